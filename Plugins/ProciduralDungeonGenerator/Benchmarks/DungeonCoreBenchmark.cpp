@@ -0,0 +1,655 @@
+// Timings for the DungeonCore stages and the whole pipeline. Not part of ctest, run the executable directly.
+//
+// DungeonCoreBenchmark [--sizes=100,1000,10000,100000] [--configs=default,dense,sparse,tight,wide]
+//                      [--stages=spawn,...] [--reps=5] [--seed=1] [--steps=10] [--pipeline-steps=20]
+//                      [--floors=1] [--separation=penetration|steering] [--format=table|csv|json] [--out=file]
+//
+// Every case is seeded, so two runs of the same build time identical work and results from different
+// builds can be diffed to catch regressions.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "DungeonCore/BatchGeneration.h"
+#include "DungeonCore/CorridorStrips.h"
+#include "DungeonCore/DungeonLayoutGenerator.h"
+#include "DungeonCore/LayoutEditor.h"
+#include "DungeonCore/LayoutSerialization.h"
+#include "DungeonCore/RoomNavigator.h"
+#include "DungeonCore/SeparationSolver.h"
+#include "DungeonCore/SpanningTree.h"
+#include "DungeonCore/Triangulation.h"
+
+using namespace DungeonCore;
+
+namespace
+{
+	/* Scales the default params, cell density is kept constant across sizes unless a config changes it. */
+	struct BenchConfig
+	{
+		const char* Name;
+		double RadiusScale;
+		float MinDistance;
+	};
+
+	const BenchConfig Configs[] = {
+		{"default", 1., 1200.f},
+		{"dense", 0.5, 1200.f},
+		{"sparse", 2., 1200.f},
+		{"tight", 1., 600.f},
+		{"wide", 1., 2400.f},
+	};
+
+	const char* const Stages[] = {
+		"spawn", "separation_step", "select_rooms", "triangulate", "spanning_tree", "connect_rooms",
+		"build_corridors", "merge_strips", "edit_room", "route_rooms", "save", "load", "pipeline", "batch"
+	};
+
+	/* Layouts per batch sample, seeds follow on from --seed. */
+	constexpr int BatchLayouts = 8;
+
+	/* Room paths per route_rooms sample, spread over a few targets the way agents share destinations. */
+	constexpr int RouteQueries = 1000;
+	constexpr int RouteTargets = 8;
+
+	struct Options
+	{
+		std::vector<int> Sizes{100, 1000, 10000, 100000};
+		std::vector<std::string> ConfigNames;
+		std::vector<std::string> StageNames;
+		int Repetitions = 5;
+		uint32_t Seed = 1;
+
+		/* Separation steps timed per separation_step sample, and the step cap used before the later stages. */
+		int SeparationSteps = 10;
+
+		/* Full separation does not settle on large inputs, the pipeline runs with this step cap instead. */
+		int PipelineSteps = 20;
+
+		/* Cells are shared out over the floors, each floor keeps the density of a single floor layout. */
+		int Floors = 1;
+
+		SeparationMethod Separation = SeparationMethod::Penetration;
+
+		std::string Format = "table";
+		std::string OutPath;
+	};
+
+	struct BenchResult
+	{
+		std::string Stage;
+		std::string Config;
+		int Cells;
+		float SpawnRadius;
+		float MinDistance;
+		uint32_t Seed;
+		int Repetitions;
+		double MinMs;
+		double MedianMs;
+		double MeanMs;
+		double MaxMs;
+
+		/* Size of the stage output, e.g. triangles or corridor tiles, to spot work changing under a timing. */
+		size_t Items;
+	};
+
+	/* Wall clock samples in milliseconds, Setup runs untimed before every repetition. */
+	std::vector<double> TimeRuns(int Repetitions, const std::function<void()>& Setup, const std::function<void()>& Function)
+	{
+		std::vector<double> Samples;
+		Samples.reserve(Repetitions);
+		for (int Run = 0; Run < Repetitions; ++Run)
+		{
+			Setup();
+			const auto Start = std::chrono::steady_clock::now();
+			Function();
+			const auto End = std::chrono::steady_clock::now();
+			Samples.push_back(std::chrono::duration<double, std::milli>(End - Start).count());
+		}
+		return Samples;
+	}
+
+	void Summarize(std::vector<double> Samples, BenchResult& Result)
+	{
+		std::sort(Samples.begin(), Samples.end());
+		const size_t Mid = Samples.size() / 2;
+		Result.MinMs = Samples.front();
+		Result.MaxMs = Samples.back();
+		Result.MedianMs = Samples.size() % 2 ? Samples[Mid] : (Samples[Mid - 1] + Samples[Mid]) / 2.;
+		double Sum = 0.;
+		for (const double Sample : Samples)
+		{
+			Sum += Sample;
+		}
+		Result.MeanMs = Sum / static_cast<double>(Samples.size());
+	}
+
+	bool Selected(const std::vector<std::string>& Names, const char* Name)
+	{
+		return Names.empty() || std::find(Names.begin(), Names.end(), Name) != Names.end();
+	}
+
+	std::vector<std::string> SplitList(const char* List)
+	{
+		std::vector<std::string> Items;
+		std::string Current;
+		for (const char* Char = List; ; ++Char)
+		{
+			if (*Char == ',' || *Char == '\0')
+			{
+				if (!Current.empty())
+				{
+					Items.push_back(Current);
+				}
+				Current.clear();
+				if (*Char == '\0')
+				{
+					break;
+				}
+			}
+			else
+			{
+				Current += *Char;
+			}
+		}
+		return Items;
+	}
+
+	bool ParseOptions(int ArgCount, char** Args, Options& Out)
+	{
+		for (int Index = 1; Index < ArgCount; ++Index)
+		{
+			const char* Arg = Args[Index];
+			const char* Value = std::strchr(Arg, '=');
+			if (!Value)
+			{
+				std::fprintf(stderr, "Expected --name=value, got %s\n", Arg);
+				return false;
+			}
+			const std::string Name(Arg, Value - Arg);
+			++Value;
+
+			if (Name == "--sizes")
+			{
+				Out.Sizes.clear();
+				for (const std::string& Size : SplitList(Value))
+				{
+					Out.Sizes.push_back(std::atoi(Size.c_str()));
+				}
+			}
+			else if (Name == "--configs")
+			{
+				Out.ConfigNames = SplitList(Value);
+			}
+			else if (Name == "--stages")
+			{
+				Out.StageNames = SplitList(Value);
+			}
+			else if (Name == "--reps")
+			{
+				Out.Repetitions = std::max(1, std::atoi(Value));
+			}
+			else if (Name == "--seed")
+			{
+				Out.Seed = static_cast<uint32_t>(std::strtoul(Value, nullptr, 10));
+			}
+			else if (Name == "--steps")
+			{
+				Out.SeparationSteps = std::max(1, std::atoi(Value));
+			}
+			else if (Name == "--pipeline-steps")
+			{
+				Out.PipelineSteps = std::max(0, std::atoi(Value));
+			}
+			else if (Name == "--floors")
+			{
+				Out.Floors = std::max(1, std::atoi(Value));
+			}
+			else if (Name == "--separation")
+			{
+				if (std::strcmp(Value, "penetration") == 0)
+				{
+					Out.Separation = SeparationMethod::Penetration;
+				}
+				else if (std::strcmp(Value, "steering") == 0)
+				{
+					Out.Separation = SeparationMethod::Steering;
+				}
+				else
+				{
+					std::fprintf(stderr, "Unknown separation %s\n", Value);
+					return false;
+				}
+			}
+			else if (Name == "--format")
+			{
+				Out.Format = Value;
+			}
+			else if (Name == "--out")
+			{
+				Out.OutPath = Value;
+			}
+			else
+			{
+				std::fprintf(stderr, "Unknown option %s\n", Name.c_str());
+				return false;
+			}
+		}
+
+		if (Out.Format != "table" && Out.Format != "csv" && Out.Format != "json")
+		{
+			std::fprintf(stderr, "Unknown format %s\n", Out.Format.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	/* Runs every selected stage for one size and config, each on the output of the stages before it. */
+	void RunCase(const Options& Opts, const BenchConfig& Config, int NumCells, std::vector<BenchResult>& Results)
+	{
+		DungeonParams Params;
+		Params.NumberOfCells = NumCells;
+		Params.SpawnRadius = static_cast<float>(2000. * Config.RadiusScale * std::sqrt(NumCells / (100. * Opts.Floors)));
+		Params.NumFloors = Opts.Floors;
+		Params.MinDistance = Config.MinDistance;
+		Params.MaxSeparationSteps = Opts.SeparationSteps;
+		Params.Separation = Opts.Separation;
+
+		const auto Record = [&](const char* Stage, const std::vector<double>& Samples, size_t Items)
+		{
+			BenchResult Result{Stage, Config.Name, NumCells, Params.SpawnRadius, Params.MinDistance, Opts.Seed,
+			                   Opts.Repetitions, 0., 0., 0., 0., Items};
+			Summarize(Samples, Result);
+			Results.push_back(Result);
+
+			/* Progress on stderr keeps stdout clean for csv and json. */
+			std::fprintf(stderr, "%-16s %-8s %7d cells: %10.3f ms median\n", Stage, Config.Name, NumCells, Result.MedianMs);
+		};
+		const auto NoSetup = [] {};
+
+		/* Same stage streams as GenerateLayout so the inputs match a real run with this seed. */
+		const auto StageRng = [&](RandomStage Stage)
+		{
+			return RandomEngine{Opts.Seed, static_cast<uint64_t>(Stage)};
+		};
+
+		DungeonLayout Spawned;
+		{
+			RandomEngine Rng = StageRng(RandomStage::SpawnCells);
+			SpawnCells(Params, Rng, Spawned);
+		}
+		if (Selected(Opts.StageNames, "spawn"))
+		{
+			DungeonLayout Layout;
+			RandomEngine Rng{0};
+			const auto Samples = TimeRuns(Opts.Repetitions, [&]
+			{
+				Layout = {};
+				Rng = StageRng(RandomStage::SpawnCells);
+			}, [&]
+			{
+				SpawnCells(Params, Rng, Layout);
+			});
+			Record("spawn", Samples, Layout.Cells.size());
+		}
+
+		if (Selected(Opts.StageNames, "separation_step"))
+		{
+			SeparationSettings Settings;
+			Settings.Method = Params.Separation;
+			Settings.MinDistance = Params.MinDistance;
+			Settings.Tolerance = Params.SeparationTolerance;
+
+			SeparationSolver Solver;
+			const auto Samples = TimeRuns(Opts.Repetitions, [&]
+			{
+				Solver.Init(Spawned.Cells, Settings);
+			}, [&]
+			{
+				for (int Step = 0; Step < Opts.SeparationSteps; ++Step)
+				{
+					Solver.Step();
+				}
+			});
+
+			std::vector<double> PerStep;
+			for (const double Sample : Samples)
+			{
+				PerStep.push_back(Sample / Opts.SeparationSteps);
+			}
+			Record("separation_step", PerStep, Spawned.Cells.size());
+		}
+
+		/* The later stages start from a layout separated for the capped number of steps. */
+		DungeonLayout Separated = Spawned;
+		SeparateCells(Params, Separated);
+
+		DungeonLayout Selection = Separated;
+		{
+			RandomEngine Rng = StageRng(RandomStage::SelectRooms);
+			SelectRooms(Params, Rng, Selection);
+		}
+		if (Selected(Opts.StageNames, "select_rooms"))
+		{
+			DungeonLayout Layout;
+			RandomEngine Rng{0};
+			const auto Samples = TimeRuns(Opts.Repetitions, [&]
+			{
+				Layout = Separated;
+				Rng = StageRng(RandomStage::SelectRooms);
+			}, [&]
+			{
+				SelectRooms(Params, Rng, Layout);
+			});
+			Record("select_rooms", Samples, Layout.Rooms.size());
+		}
+
+		/* Triangulation and spanning tree run over every cell so they scale with the size argument. */
+		std::vector<Vec2> Points;
+		Points.reserve(Separated.Cells.size());
+		for (const Cell& Current : Separated.Cells)
+		{
+			Points.push_back(Current.Location);
+		}
+		if (Selected(Opts.StageNames, "triangulate"))
+		{
+			size_t NumTriangles = 0;
+			const auto Samples = TimeRuns(Opts.Repetitions, NoSetup, [&]
+			{
+				NumTriangles = static_cast<size_t>(Triangulate(Points).NumTriangles());
+			});
+			Record("triangulate", Samples, NumTriangles);
+		}
+
+		if (Selected(Opts.StageNames, "spanning_tree"))
+		{
+			const Triangulation DT = Triangulate(Points);
+			size_t NumTreeEdges = 0;
+			const auto Samples = TimeRuns(Opts.Repetitions, NoSetup, [&]
+			{
+				NumTreeEdges = MinimumSpanningTree(DT.Edges, static_cast<int32_t>(Points.size())).size();
+			});
+			Record("spanning_tree", Samples, NumTreeEdges);
+		}
+
+		DungeonLayout Connected = Selection;
+		{
+			RandomEngine Rng = StageRng(RandomStage::ConnectRooms);
+			ConnectRooms(Rng, Connected);
+		}
+		if (Selected(Opts.StageNames, "connect_rooms"))
+		{
+			DungeonLayout Layout;
+			RandomEngine Rng{0};
+			const auto Samples = TimeRuns(Opts.Repetitions, [&]
+			{
+				Layout = Selection;
+				Rng = StageRng(RandomStage::ConnectRooms);
+			}, [&]
+			{
+				ConnectRooms(Rng, Layout);
+			});
+			Record("connect_rooms", Samples, Layout.Edges.size());
+		}
+
+		if (Selected(Opts.StageNames, "build_corridors"))
+		{
+			DungeonLayout Layout;
+			const auto Samples = TimeRuns(Opts.Repetitions, [&]
+			{
+				Layout = Connected;
+			}, [&]
+			{
+				BuildCorridors(Params, Layout);
+			});
+			Record("build_corridors", Samples, Layout.CorridorTiles.size());
+		}
+
+		/* Items is the number of strips, compare with the tiles of build_corridors for the pieces saved. */
+		if (Selected(Opts.StageNames, "merge_strips"))
+		{
+			DungeonLayout Finished = Connected;
+			BuildCorridors(Params, Finished);
+			std::vector<CorridorStrip> Strips;
+			const auto Samples = TimeRuns(Opts.Repetitions, NoSetup, [&]
+			{
+				Strips = MergeCorridorTiles(Finished.CorridorTiles, Params.SectionLength);
+			});
+			Record("merge_strips", Samples, Strips.size());
+		}
+
+		/*
+		 * One room moved at least ten sections over on the finished layout, to the first spot clear of other
+		 * rooms since the editor refuses overlaps. Items is the tiles it took out and laid.
+		 */
+		if (Selected(Opts.StageNames, "edit_room") && !Connected.Rooms.empty())
+		{
+			DungeonLayout Finished = Connected;
+			BuildCorridors(Params, Finished);
+			DungeonLayout Layout;
+			LayoutEditor Editor;
+			LayoutChanges Changes;
+			const int RoomIndex = static_cast<int>(Finished.Rooms.size() / 2);
+			const Room& Moved = Finished.GetRoom(RoomIndex);
+			const auto IsClear = [&](const Vec2& Center)
+			{
+				return std::none_of(Finished.Rooms.begin(), Finished.Rooms.end(), [&](const Room& Other)
+				{
+					return &Other != &Moved && Other.Floor == Moved.Floor &&
+						std::abs(Other.Bounds.Origin.X - Center.X) < Other.Bounds.Extent.X + Moved.Bounds.Extent.X &&
+						std::abs(Other.Bounds.Origin.Y - Center.Y) < Other.Bounds.Extent.Y + Moved.Bounds.Extent.Y;
+				});
+			};
+			Vec2 Target = Moved.GetCenter() + Vec2{10. * Params.SectionLength, 0.};
+			while (!IsClear(RoundM(Target, Params.SnapSize)))
+			{
+				Target.X += Params.SectionLength;
+			}
+			const auto Samples = TimeRuns(Opts.Repetitions, [&]
+			{
+				Layout = Finished;
+				Editor.Init(Params, Opts.Seed, Layout);
+			}, [&]
+			{
+				Editor.MoveRoom(RoomIndex, Target, Changes);
+			});
+			Record("edit_room", Samples, Changes.RemovedTiles.size() + Changes.AddedTiles.size());
+		}
+
+		/* Navigator built and queried from cold, items is the rooms on all the paths found. */
+		if (Selected(Opts.StageNames, "route_rooms") && !Connected.Rooms.empty())
+		{
+			DungeonLayout Finished = Connected;
+			BuildCorridors(Params, Finished);
+			const int32_t NumRooms = static_cast<int32_t>(Finished.Rooms.size());
+			RoomNavigator Navigator;
+			std::vector<int32_t> Path;
+			size_t NumPathRooms = 0;
+			const auto Samples = TimeRuns(Opts.Repetitions, [&]
+			{
+				NumPathRooms = 0;
+			}, [&]
+			{
+				Navigator.Init(Finished);
+				for (int Query = 0; Query < RouteQueries; ++Query)
+				{
+					const int32_t From = static_cast<int32_t>((Query * 7919LL) % NumRooms);
+					const int32_t To = static_cast<int32_t>(((Query % RouteTargets) * 104729LL) % NumRooms);
+					Navigator.FindRoomPath(From, To, Path);
+					NumPathRooms += Path.size();
+				}
+			});
+			Record("route_rooms", Samples, NumPathRooms);
+		}
+
+		/* Save and load work on the finished layout, items is the blob size in bytes. */
+		if (Selected(Opts.StageNames, "save") || Selected(Opts.StageNames, "load"))
+		{
+			SavedLayout Saved{Params, Opts.Seed, Connected};
+			BuildCorridors(Params, Saved.Layout);
+			std::vector<uint8_t> Bytes = WriteLayout(Saved);
+
+			if (Selected(Opts.StageNames, "save"))
+			{
+				const auto Samples = TimeRuns(Opts.Repetitions, NoSetup, [&]
+				{
+					Bytes = WriteLayout(Saved);
+				});
+				Record("save", Samples, Bytes.size());
+			}
+
+			if (Selected(Opts.StageNames, "load"))
+			{
+				SavedLayout Loaded;
+				const auto Samples = TimeRuns(Opts.Repetitions, NoSetup, [&]
+				{
+					ReadLayout(Bytes.data(), Bytes.size(), Loaded);
+				});
+				Record("load", Samples, Bytes.size());
+			}
+		}
+
+		if (Selected(Opts.StageNames, "pipeline"))
+		{
+			DungeonParams PipelineParams = Params;
+			PipelineParams.MaxSeparationSteps = Opts.PipelineSteps;
+			size_t NumTiles = 0;
+			const auto Samples = TimeRuns(Opts.Repetitions, NoSetup, [&]
+			{
+				NumTiles = GenerateLayout(PipelineParams, Opts.Seed).CorridorTiles.size();
+			});
+			Record("pipeline", Samples, NumTiles);
+		}
+
+		/* Compare with BatchLayouts times the pipeline median to see what spreading whole layouts gains. */
+		if (Selected(Opts.StageNames, "batch"))
+		{
+			std::vector<BatchEntry> Entries(BatchLayouts);
+			for (int EntryIndex = 0; EntryIndex < BatchLayouts; ++EntryIndex)
+			{
+				Entries[EntryIndex].Params = Params;
+				Entries[EntryIndex].Params.MaxSeparationSteps = Opts.PipelineSteps;
+				Entries[EntryIndex].Seed = Opts.Seed + static_cast<uint32_t>(EntryIndex);
+			}
+			size_t NumTiles = 0;
+			const auto Samples = TimeRuns(Opts.Repetitions, NoSetup, [&]
+			{
+				NumTiles = 0;
+				for (const BatchSummary& Summary : GenerateBatch(Entries))
+				{
+					NumTiles += Summary.NumCorridorTiles;
+				}
+			});
+			Record("batch", Samples, NumTiles);
+		}
+	}
+
+	void WriteTable(std::FILE* Out, const std::vector<BenchResult>& Results)
+	{
+		std::fprintf(Out, "%-16s %-8s %8s %10s %10s %10s %10s %10s\n", "stage", "config", "cells", "min_ms",
+		             "median_ms", "mean_ms", "max_ms", "items");
+		for (const BenchResult& Result : Results)
+		{
+			std::fprintf(Out, "%-16s %-8s %8d %10.3f %10.3f %10.3f %10.3f %10zu\n", Result.Stage.c_str(),
+			             Result.Config.c_str(), Result.Cells, Result.MinMs, Result.MedianMs, Result.MeanMs, Result.MaxMs,
+			             Result.Items);
+		}
+	}
+
+	void WriteCsv(std::FILE* Out, const std::vector<BenchResult>& Results)
+	{
+		std::fprintf(Out, "stage,config,cells,spawn_radius,min_distance,seed,repetitions,min_ms,median_ms,mean_ms,max_ms,items\n");
+		for (const BenchResult& Result : Results)
+		{
+			std::fprintf(Out, "%s,%s,%d,%.1f,%.1f,%u,%d,%.4f,%.4f,%.4f,%.4f,%zu\n", Result.Stage.c_str(),
+			             Result.Config.c_str(), Result.Cells, Result.SpawnRadius, Result.MinDistance, Result.Seed,
+			             Result.Repetitions, Result.MinMs, Result.MedianMs, Result.MeanMs, Result.MaxMs, Result.Items);
+		}
+	}
+
+	void WriteJson(std::FILE* Out, const std::vector<BenchResult>& Results)
+	{
+		std::fprintf(Out, "[\n");
+		for (size_t Index = 0; Index < Results.size(); ++Index)
+		{
+			const BenchResult& Result = Results[Index];
+			std::fprintf(Out,
+			             "  {\"stage\": \"%s\", \"config\": \"%s\", \"cells\": %d, \"spawn_radius\": %.1f, "
+			             "\"min_distance\": %.1f, \"seed\": %u, \"repetitions\": %d, \"min_ms\": %.4f, "
+			             "\"median_ms\": %.4f, \"mean_ms\": %.4f, \"max_ms\": %.4f, \"items\": %zu}%s\n",
+			             Result.Stage.c_str(), Result.Config.c_str(), Result.Cells, Result.SpawnRadius,
+			             Result.MinDistance, Result.Seed, Result.Repetitions, Result.MinMs, Result.MedianMs,
+			             Result.MeanMs, Result.MaxMs, Result.Items, Index + 1 < Results.size() ? "," : "");
+		}
+		std::fprintf(Out, "]\n");
+	}
+}
+
+int main(int ArgCount, char** Args)
+{
+	Options Opts;
+	if (!ParseOptions(ArgCount, Args, Opts))
+	{
+		return 2;
+	}
+
+	for (const std::string& Stage : Opts.StageNames)
+	{
+		if (std::find_if(std::begin(Stages), std::end(Stages), [&](const char* Name) { return Stage == Name; }) ==
+			std::end(Stages))
+		{
+			std::fprintf(stderr, "Unknown stage %s\n", Stage.c_str());
+			return 2;
+		}
+	}
+
+	std::vector<BenchResult> Results;
+	for (const BenchConfig& Config : Configs)
+	{
+		if (!Selected(Opts.ConfigNames, Config.Name))
+		{
+			continue;
+		}
+		for (const int NumCells : Opts.Sizes)
+		{
+			RunCase(Opts, Config, NumCells, Results);
+		}
+	}
+
+	std::FILE* Out = stdout;
+	if (!Opts.OutPath.empty())
+	{
+		Out = std::fopen(Opts.OutPath.c_str(), "w");
+		if (!Out)
+		{
+			std::fprintf(stderr, "Cannot open %s\n", Opts.OutPath.c_str());
+			return 1;
+		}
+	}
+
+	if (Opts.Format == "csv")
+	{
+		WriteCsv(Out, Results);
+	}
+	else if (Opts.Format == "json")
+	{
+		WriteJson(Out, Results);
+	}
+	else
+	{
+		WriteTable(Out, Results);
+	}
+
+	if (Out != stdout)
+	{
+		std::fclose(Out);
+	}
+	return 0;
+}
@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DungeonBatchCommandlet.h"
+#include "DungeonGenerator.h"
+#include "DungeonCore/BatchGeneration.h"
+#include "DungeonCore/LayoutSerialization.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include <atomic>
+
+DEFINE_LOG_CATEGORY_STATIC(LogDungeonBatch, Log, All);
+
+namespace
+{
+	// A progress line every this many dungeons
+	constexpr int32 ProgressInterval = 1000;
+
+	FString MakeLayoutPath(const FString& OutDir, const DungeonCore::BatchEntry& Entry)
+	{
+		return FPaths::Combine(OutDir, TEXT("Layouts"),
+		                       FString::Printf(TEXT("Dungeon_%d_%u.dungeon"), Entry.Params.NumberOfCells, Entry.Seed));
+	}
+}
+
+UDungeonBatchCommandlet::UDungeonBatchCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UDungeonBatchCommandlet::Main(const FString& Params)
+{
+	const TCHAR* Switches = *Params;
+
+	DungeonCore::DungeonParams BaseParams;
+	FString GeneratorPath;
+	if (FParse::Value(Switches, TEXT("Generator="), GeneratorPath))
+	{
+		UClass* GeneratorClass = LoadClass<ADungeonGenerator>(nullptr, *GeneratorPath);
+		if (!GeneratorClass)
+		{
+			UE_LOG(LogDungeonBatch, Error, TEXT("%s is not a DungeonGenerator class"), *GeneratorPath);
+			return 1;
+		}
+		BaseParams = GetDefault<ADungeonGenerator>(GeneratorClass)->MakeLayoutParams();
+	}
+	FParse::Value(Switches, TEXT("Floors="), BaseParams.NumFloors);
+	FParse::Value(Switches, TEXT("Radius="), BaseParams.SpawnRadius);
+	FParse::Value(Switches, TEXT("MinDistance="), BaseParams.MinDistance);
+	FParse::Value(Switches, TEXT("Steps="), BaseParams.MaxSeparationSteps);
+	FParse::Value(Switches, TEXT("Tolerance="), BaseParams.SeparationTolerance);
+	if (FParse::Param(Switches, TEXT("Steering")))
+	{
+		BaseParams.Separation = DungeonCore::SeparationMethod::Steering;
+	}
+	BaseParams.NumFloors = FMath::Max(1, BaseParams.NumFloors);
+
+	uint32 FirstSeed = 1;
+	int32 Count = 100;
+	FParse::Value(Switches, TEXT("FirstSeed="), FirstSeed);
+	FParse::Value(Switches, TEXT("Count="), Count);
+
+	TArray<int32> CellCounts;
+	FString CellList;
+	if (FParse::Value(Switches, TEXT("Cells="), CellList, false))
+	{
+		TArray<FString> Items;
+		CellList.ParseIntoArray(Items, TEXT(","));
+		for (const FString& Item : Items)
+		{
+			CellCounts.Add(FCString::Atoi(*Item));
+		}
+	}
+	if (CellCounts.IsEmpty())
+	{
+		CellCounts.Add(BaseParams.NumberOfCells);
+	}
+
+	if (Count <= 0 || CellCounts.ContainsByPredicate([](int32 Cells) { return Cells <= 0; }))
+	{
+		UE_LOG(LogDungeonBatch, Error, TEXT("Count and Cells must be positive"));
+		return 1;
+	}
+
+	FString OutDir = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("DungeonBatch"));
+	FParse::Value(Switches, TEXT("Out="), OutDir);
+	const bool bSaveLayouts = FParse::Param(Switches, TEXT("SaveLayouts"));
+
+	std::vector<DungeonCore::BatchEntry> Entries;
+	Entries.reserve(static_cast<size_t>(CellCounts.Num()) * Count);
+	for (const int32 Cells : CellCounts)
+	{
+		for (int32 Offset = 0; Offset < Count; ++Offset)
+		{
+			DungeonCore::BatchEntry& Entry = Entries.emplace_back();
+			Entry.Params = BaseParams;
+			Entry.Params.NumberOfCells = Cells;
+			Entry.Seed = FirstSeed + static_cast<uint32>(Offset);
+		}
+	}
+
+	UE_LOG(LogDungeonBatch, Display, TEXT("Generating %d dungeons on %d threads"), static_cast<int32>(Entries.size()),
+	       FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+
+	// Layouts are written and dropped on the worker that made them, only the summaries are kept
+	std::atomic<int32> NumDone{0};
+	std::atomic<int32> NumWriteErrors{0};
+	const double StartTime = FPlatformTime::Seconds();
+	const std::vector<DungeonCore::BatchSummary> Summaries = DungeonCore::GenerateBatch(Entries,
+		[&](size_t EntryIndex, const DungeonCore::DungeonLayout& Layout)
+		{
+			if (bSaveLayouts)
+			{
+				const std::vector<uint8_t> Bytes = DungeonCore::WriteLayout({Entries[EntryIndex].Params, Entries[EntryIndex].Seed, Layout});
+				if (!FFileHelper::SaveArrayToFile(TArrayView<const uint8>(Bytes.data(), Bytes.size()),
+				                                  *MakeLayoutPath(OutDir, Entries[EntryIndex])))
+				{
+					++NumWriteErrors;
+				}
+			}
+
+			const int32 Done = ++NumDone;
+			if (Done % ProgressInterval == 0)
+			{
+				UE_LOG(LogDungeonBatch, Display, TEXT("%d / %d dungeons"), Done, static_cast<int32>(Entries.size()));
+			}
+		});
+	const double WallSeconds = FPlatformTime::Seconds() - StartTime;
+
+	FString Csv = TEXT("seed,cell_count,floors,cells,rooms,edges,loop_edges,corridor_tiles,stairs,separation_steps,")
+		TEXT("separation_converged,")
+		TEXT("spawn_ms,separation_ms,select_rooms_ms,triangulation_ms,spanning_tree_ms,loop_edges_ms,corridors_ms,")
+		TEXT("total_ms,peak_bytes\n");
+	double SumTotalMs = 0.;
+	size_t Slowest = 0;
+	for (size_t EntryIndex = 0; EntryIndex < Entries.size(); ++EntryIndex)
+	{
+		const DungeonCore::BatchEntry& Entry = Entries[EntryIndex];
+		const DungeonCore::BatchSummary& Summary = Summaries[EntryIndex];
+		const DungeonCore::GenerationStats& Stats = Summary.Stats;
+		Csv += FString::Printf(TEXT("%u,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%llu\n"),
+		                       Entry.Seed, Entry.Params.NumberOfCells, Entry.Params.NumFloors, Summary.NumCells,
+		                       Summary.NumRooms, Summary.NumEdges, Stats.NumLoopEdges, Summary.NumCorridorTiles,
+		                       Summary.NumStairs, Summary.SeparationSteps, Stats.bSeparationConverged ? 1 : 0,
+		                       Stats.SpawnMs, Stats.SeparationMs,
+		                       Stats.SelectRoomsMs, Stats.TriangulationMs, Stats.SpanningTreeMs, Stats.LoopEdgesMs,
+		                       Stats.CorridorsMs, Stats.TotalMs, static_cast<uint64>(Stats.PeakBytes));
+		SumTotalMs += Stats.TotalMs;
+		if (Stats.TotalMs > Summaries[Slowest].Stats.TotalMs)
+		{
+			Slowest = EntryIndex;
+		}
+	}
+
+	const FString CsvPath = FPaths::Combine(OutDir, TEXT("stats.csv"));
+	if (!FFileHelper::SaveStringToFile(Csv, *CsvPath))
+	{
+		UE_LOG(LogDungeonBatch, Error, TEXT("Could not write %s"), *CsvPath);
+		return 1;
+	}
+	if (NumWriteErrors > 0)
+	{
+		UE_LOG(LogDungeonBatch, Error, TEXT("Could not write %d layouts to %s"), NumWriteErrors.load(), *OutDir);
+		return 1;
+	}
+
+	UE_LOG(LogDungeonBatch, Display, TEXT("%d dungeons in %.2f s, %.1f per second, %.2f ms mean generation, ")
+	       TEXT("slowest %.2f ms (seed %u, %d cells). Stats in %s"), static_cast<int32>(Entries.size()), WallSeconds,
+	       Entries.size() / FMath::Max(WallSeconds, 1e-6), SumTotalMs / Entries.size(), Summaries[Slowest].Stats.TotalMs,
+	       Entries[Slowest].Seed, Entries[Slowest].Params.NumberOfCells, *CsvPath);
+	return 0;
+}
@@ -0,0 +1,41 @@
+#include "DungeonCore/BatchGeneration.h"
+
+#include "DungeonCore/DungeonLayoutGenerator.h"
+#include "DungeonCore/Parallel.h"
+
+namespace DungeonCore
+{
+	BatchSummary Summarize(const DungeonLayout& Layout)
+	{
+		BatchSummary Summary;
+		Summary.NumCells = static_cast<int>(Layout.Cells.size());
+		Summary.NumRooms = static_cast<int>(Layout.Rooms.size());
+		Summary.NumEdges = static_cast<int>(Layout.Edges.size());
+		Summary.NumCorridorTiles = static_cast<int>(Layout.CorridorTiles.size());
+		Summary.NumStairs = static_cast<int>(Layout.Stairs.size());
+		Summary.SeparationSteps = Layout.SeparationSteps;
+		Summary.Stats = Layout.Stats;
+		return Summary;
+	}
+
+	std::vector<BatchSummary> GenerateBatch(const std::vector<BatchEntry>& Entries, const BatchLayoutCallback& OnLayout)
+	{
+		std::vector<BatchSummary> Summaries(Entries.size());
+
+		/* One entry per chunk, the executor hands them out as threads free up so slow layouts balance out. */
+		ParallelForRange(static_cast<int32_t>(Entries.size()), 1, [&](int32_t Begin, int32_t End)
+		{
+			const ScopedSerialParallelFor Serial;
+			for (int32_t EntryIndex = Begin; EntryIndex < End; ++EntryIndex)
+			{
+				const DungeonLayout Layout = GenerateLayout(Entries[EntryIndex].Params, Entries[EntryIndex].Seed);
+				Summaries[EntryIndex] = Summarize(Layout);
+				if (OnLayout)
+				{
+					OnLayout(EntryIndex, Layout);
+				}
+			}
+		});
+		return Summaries;
+	}
+}
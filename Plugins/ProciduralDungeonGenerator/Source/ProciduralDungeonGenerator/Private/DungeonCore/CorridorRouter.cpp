@@ -0,0 +1,254 @@
+#include "DungeonCore/CorridorRouter.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "DungeonCore/OccupancyGrid.h"
+#include "DungeonTrace.h"
+
+namespace DungeonCore
+{
+	namespace
+	{
+		constexpr int32_t StepX[4] = {1, -1, 0, 0};
+		constexpr int32_t StepY[4] = {0, 0, 1, -1};
+
+		/* Direction of a seed, so the first step never counts as a turn. */
+		constexpr uint8_t NoDirection = 4;
+	}
+
+	void CorridorRouter::Reset(double InSectionLength, const CorridorRouterSettings& InSettings)
+	{
+		Settings = InSettings;
+		Settings.Margin = std::max(1, Settings.Margin);
+		Settings.MaxWidenings = std::max(0, Settings.MaxWidenings);
+		SectionLength = InSectionLength > 0. ? InSectionLength : 1.;
+		InvSectionLength = 1. / SectionLength;
+		NumExpanded = 0;
+	}
+
+	bool CorridorRouter::Route(const Bounds2D& From, const Bounds2D& To, double TileZ, OccupancyGrid& Occupancy,
+	                           std::vector<Vec3>& Tiles, std::vector<Vec3>* RouteTiles)
+	{
+		DUNGEONCORE_TRACE_SCOPE(DungeonRouteCorridor);
+		NumExpanded = 0;
+
+		const int32_t MinX = std::min(ToGrid(From.Origin.X - From.Extent.X), ToGrid(To.Origin.X - To.Extent.X));
+		const int32_t MinY = std::min(ToGrid(From.Origin.Y - From.Extent.Y), ToGrid(To.Origin.Y - To.Extent.Y));
+		const int32_t MaxX = std::max(ToGrid(From.Origin.X + From.Extent.X), ToGrid(To.Origin.X + To.Extent.X));
+		const int32_t MaxY = std::max(ToGrid(From.Origin.Y + From.Extent.Y), ToGrid(To.Origin.Y + To.Extent.Y));
+
+		for (int32_t Widening = 0; Widening <= Settings.MaxWidenings; ++Widening)
+		{
+			const int32_t Pad = Settings.Margin << Widening;
+			const Window Area{MinX - Pad, MinY - Pad, MaxX - MinX + 1 + 2 * Pad, MaxY - MinY + 1 + 2 * Pad};
+			bool bHitWindowEdge = false;
+			if (Search(Area, From, To, TileZ, Occupancy, Tiles, RouteTiles, bHitWindowEdge))
+			{
+				return true;
+			}
+
+			/* Everything reachable was searched, a wider window cannot help. */
+			if (!bHitWindowEdge)
+			{
+				break;
+			}
+		}
+		return false;
+	}
+
+	size_t CorridorRouter::GetAllocatedBytes() const
+	{
+		return DungeonCore::GetAllocatedBytes(Nodes) + DungeonCore::GetAllocatedBytes(Open) +
+			DungeonCore::GetAllocatedBytes(Path);
+	}
+
+	bool CorridorRouter::Search(const Window& Area, const Bounds2D& From, const Bounds2D& To, double TileZ,
+	                            OccupancyGrid& Occupancy, std::vector<Vec3>& Tiles, std::vector<Vec3>* RouteTiles,
+	                            bool& bOutHitWindowEdge)
+	{
+		/* Grows only, stale nodes are told apart by their stamp instead of being cleared. */
+		const size_t NumNodes = static_cast<size_t>(Area.Width) * static_cast<size_t>(Area.Height);
+		if (Nodes.size() < NumNodes)
+		{
+			Nodes.resize(NumNodes, Node{0., -1, 0, NodeKind::Open, NoDirection, false});
+		}
+		if (++Stamp == 0)
+		{
+			for (Node& Stale : Nodes)
+			{
+				Stale.Stamp = 0;
+			}
+			Stamp = 1;
+		}
+		Open.clear();
+
+		/* Manhattan distance to the target room's tiles at the cheapest step cost never overestimates. */
+		const int32_t GoalMinX = ToGrid(To.Origin.X - To.Extent.X);
+		const int32_t GoalMinY = ToGrid(To.Origin.Y - To.Extent.Y);
+		const int32_t GoalMaxX = ToGrid(To.Origin.X + To.Extent.X);
+		const int32_t GoalMaxY = ToGrid(To.Origin.Y + To.Extent.Y);
+		const double MinStepCost = std::min(1., Settings.ReuseCost);
+		const auto Compare = [](const OpenEntry& A, const OpenEntry& B)
+		{
+			/* Min heap on the estimate, deeper nodes first on ties. */
+			return A.Estimate > B.Estimate || (A.Estimate == B.Estimate && A.Cost < B.Cost);
+		};
+		const auto Push = [&](int32_t Index, double Cost)
+		{
+			const int32_t X = Area.MinX + Index % Area.Width;
+			const int32_t Y = Area.MinY + Index / Area.Width;
+			const int32_t DistanceX = std::max({0, GoalMinX - X, X - GoalMaxX});
+			const int32_t DistanceY = std::max({0, GoalMinY - Y, Y - GoalMaxY});
+			Open.push_back({Cost + (DistanceX + DistanceY) * MinStepCost, Cost, Index});
+			std::push_heap(Open.begin(), Open.end(), Compare);
+		};
+		const auto IndexOf = [&Area](int32_t X, int32_t Y)
+		{
+			return (Y - Area.MinY) * Area.Width + (X - Area.MinX);
+		};
+
+		/* Seeds are the start room's edge tiles, its interior is blocked like any other room. */
+		const auto InsideFrom = [&](int32_t X, int32_t Y)
+		{
+			return From.Overlap({ToWorld(X), ToWorld(Y)});
+		};
+		const auto Seed = [&](int32_t X, int32_t Y)
+		{
+			const int32_t Index = IndexOf(X, Y);
+			Node& Start = Touch(Area, Index, To, TileZ, Occupancy);
+			Start.Cost = 0.;
+			Push(Index, 0.);
+		};
+		for (int32_t Y = ToGrid(From.Origin.Y - From.Extent.Y); Y <= ToGrid(From.Origin.Y + From.Extent.Y); ++Y)
+		{
+			for (int32_t X = ToGrid(From.Origin.X - From.Extent.X); X <= ToGrid(From.Origin.X + From.Extent.X); ++X)
+			{
+				if (InsideFrom(X, Y) && (!InsideFrom(X + 1, Y) || !InsideFrom(X - 1, Y) || !InsideFrom(X, Y + 1) ||
+					!InsideFrom(X, Y - 1)))
+				{
+					Seed(X, Y);
+				}
+			}
+		}
+		if (Open.empty())
+		{
+			/* Room smaller than a tile, start from the tile holding its centre. */
+			Seed(ToGrid(From.Origin.X), ToGrid(From.Origin.Y));
+		}
+
+		while (!Open.empty())
+		{
+			std::pop_heap(Open.begin(), Open.end(), Compare);
+			const OpenEntry Entry = Open.back();
+			Open.pop_back();
+
+			Node& Current = Nodes[Entry.Index];
+			if (Current.bClosed || Entry.Cost > Current.Cost)
+			{
+				continue;
+			}
+			Current.bClosed = true;
+			++NumExpanded;
+
+			if (Current.Kind == NodeKind::Goal)
+			{
+				Path.clear();
+				for (int32_t Index = Entry.Index; Index != -1; Index = Nodes[Index].Parent)
+				{
+					Path.push_back(Index);
+				}
+
+				/* Only fresh tiles are laid, reused ones and those inside the two rooms already exist or are not needed. */
+				for (auto It = Path.rbegin(); It != Path.rend(); ++It)
+				{
+					const NodeKind Kind = Nodes[*It].Kind;
+					if (Kind != NodeKind::Open && (Kind != NodeKind::Reuse || !RouteTiles))
+					{
+						continue;
+					}
+					const Vec3 Tile{ToWorld(Area.MinX + *It % Area.Width), ToWorld(Area.MinY + *It / Area.Width), TileZ};
+					if (Kind == NodeKind::Open && Occupancy.AddTile(Tile))
+					{
+						Tiles.push_back(Tile);
+					}
+					if (RouteTiles)
+					{
+						RouteTiles->push_back(Tile);
+					}
+				}
+				return true;
+			}
+
+			const int32_t X = Area.MinX + Entry.Index % Area.Width;
+			const int32_t Y = Area.MinY + Entry.Index / Area.Width;
+			for (uint8_t Direction = 0; Direction < 4; ++Direction)
+			{
+				const int32_t NextX = X + StepX[Direction];
+				const int32_t NextY = Y + StepY[Direction];
+				if (NextX < Area.MinX || NextY < Area.MinY || NextX >= Area.MinX + Area.Width ||
+					NextY >= Area.MinY + Area.Height)
+				{
+					bOutHitWindowEdge = true;
+					continue;
+				}
+
+				const int32_t NextIndex = IndexOf(NextX, NextY);
+				Node& Next = Touch(Area, NextIndex, To, TileZ, Occupancy);
+				if (Next.bClosed || Next.Kind == NodeKind::Blocked)
+				{
+					continue;
+				}
+
+				double StepCost = Next.Kind == NodeKind::Reuse ? Settings.ReuseCost : 1.;
+				if (Current.Direction != NoDirection && Current.Direction != Direction)
+				{
+					StepCost += Settings.TurnCost;
+				}
+				const double NextCost = Current.Cost + StepCost;
+				if (NextCost < Next.Cost)
+				{
+					Next.Cost = NextCost;
+					Next.Parent = Entry.Index;
+					Next.Direction = Direction;
+					Push(NextIndex, NextCost);
+				}
+			}
+		}
+		return false;
+	}
+
+	CorridorRouter::Node& CorridorRouter::Touch(const Window& Area, int32_t Index, const Bounds2D& To, double TileZ,
+	                                            const OccupancyGrid& Occupancy)
+	{
+		Node& Current = Nodes[Index];
+		if (Current.Stamp == Stamp)
+		{
+			return Current;
+		}
+
+		const Vec2 Center{ToWorld(Area.MinX + Index % Area.Width), ToWorld(Area.MinY + Index / Area.Width)};
+		if (To.Overlap(Center))
+		{
+			Current.Kind = NodeKind::Goal;
+		}
+		else if (Occupancy.IsInsideRoom(Center))
+		{
+			Current.Kind = NodeKind::Blocked;
+		}
+		else if (Occupancy.HasTile({Center.X, Center.Y, TileZ}))
+		{
+			Current.Kind = NodeKind::Reuse;
+		}
+		else
+		{
+			Current.Kind = NodeKind::Open;
+		}
+		Current.Cost = std::numeric_limits<double>::max();
+		Current.Parent = -1;
+		Current.Stamp = Stamp;
+		Current.Direction = NoDirection;
+		Current.bClosed = false;
+		return Current;
+	}
+}
@@ -0,0 +1,186 @@
+#include "DungeonCore/CorridorStrips.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <tuple>
+
+namespace DungeonCore
+{
+	namespace
+	{
+		/* Tiles count as in line when their spacing is this share of SectionLength off, routes are built in doubles. */
+		constexpr double RelativeTolerance = 1e-3;
+
+		/* Maximal run of tiles in line, Begin and Length index the axis' sorted tile order. */
+		struct Run
+		{
+			int32_t Begin;
+			int32_t Length;
+			bool bAlongY;
+		};
+
+		double GetAlong(const Vec3& Tile, bool bAlongY) { return bAlongY ? Tile.Y : Tile.X; }
+		double GetAcross(const Vec3& Tile, bool bAlongY) { return bAlongY ? Tile.X : Tile.Y; }
+
+		void FindRuns(const std::vector<Vec3>& Tiles, double SectionLength, bool bAlongY, std::vector<int32_t>& Order,
+		              std::vector<Run>& Runs)
+		{
+			/* Sorted line by line, index last so duplicate tiles keep a fixed order. */
+			Order.resize(Tiles.size());
+			std::iota(Order.begin(), Order.end(), 0);
+			std::sort(Order.begin(), Order.end(), [&](int32_t A, int32_t B)
+			{
+				return std::make_tuple(Tiles[A].Z, GetAcross(Tiles[A], bAlongY), GetAlong(Tiles[A], bAlongY), A) <
+					std::make_tuple(Tiles[B].Z, GetAcross(Tiles[B], bAlongY), GetAlong(Tiles[B], bAlongY), B);
+			});
+
+			const double Tolerance = SectionLength * RelativeTolerance;
+			const int32_t NumTiles = static_cast<int32_t>(Order.size());
+			int32_t Begin = 0;
+			for (int32_t Next = 1; Next <= NumTiles; ++Next)
+			{
+				const bool bContinues = Next < NumTiles && [&]
+				{
+					const Vec3& Previous = Tiles[Order[Next - 1]];
+					const Vec3& Current = Tiles[Order[Next]];
+					return Current.Z == Previous.Z && GetAcross(Current, bAlongY) == GetAcross(Previous, bAlongY) &&
+						std::abs(GetAlong(Current, bAlongY) - GetAlong(Previous, bAlongY) - SectionLength) <= Tolerance;
+				}();
+				if (!bContinues)
+				{
+					Runs.push_back({Begin, Next - Begin, bAlongY});
+					Begin = Next;
+				}
+			}
+		}
+	}
+
+	Vec3 CorridorStrip::GetTile(int32_t TileIndex, double SectionLength) const
+	{
+		const double Offset = TileIndex * SectionLength;
+		return bAlongY ? Vec3{First.X, First.Y + Offset, First.Z} : Vec3{First.X + Offset, First.Y, First.Z};
+	}
+
+	Vec3 CorridorStrip::GetCenter(double SectionLength) const
+	{
+		const double Offset = (NumTiles - 1) * SectionLength / 2.;
+		return bAlongY ? Vec3{First.X, First.Y + Offset, First.Z} : Vec3{First.X + Offset, First.Y, First.Z};
+	}
+
+	int32_t CorridorStrip::FindTile(const Vec3& Tile, double SectionLength) const
+	{
+		if (Tile.Z != First.Z || GetAcross(Tile, bAlongY) != GetAcross(First, bAlongY))
+		{
+			return -1;
+		}
+
+		const double Offset = (GetAlong(Tile, bAlongY) - GetAlong(First, bAlongY)) / SectionLength;
+		const double TileIndex = std::round(Offset);
+		if (std::abs(Offset - TileIndex) > RelativeTolerance || TileIndex < 0. || TileIndex >= NumTiles)
+		{
+			return -1;
+		}
+		return static_cast<int32_t>(TileIndex);
+	}
+
+	std::vector<CorridorStrip> MergeCorridorTiles(const std::vector<Vec3>& Tiles, double SectionLength)
+	{
+		std::vector<int32_t> OrderX;
+		std::vector<int32_t> OrderY;
+		std::vector<Run> Runs;
+		FindRuns(Tiles, SectionLength, false, OrderX, Runs);
+		FindRuns(Tiles, SectionLength, true, OrderY, Runs);
+		std::stable_sort(Runs.begin(), Runs.end(), [](const Run& A, const Run& B)
+		{
+			return A.Length > B.Length;
+		});
+
+		/* A run cut by tiles already taken leaves segments, those of two or more tiles still make strips. */
+		std::vector<CorridorStrip> Strips;
+		std::vector<bool> Claimed(Tiles.size(), false);
+		for (const Run& Current : Runs)
+		{
+			if (Current.Length < 2)
+			{
+				break;
+			}
+
+			const std::vector<int32_t>& Order = Current.bAlongY ? OrderY : OrderX;
+			const int32_t End = Current.Begin + Current.Length;
+			int32_t SegmentBegin = -1;
+			for (int32_t Position = Current.Begin; Position <= End; ++Position)
+			{
+				const bool bFree = Position < End && !Claimed[Order[Position]];
+				if (bFree && SegmentBegin == -1)
+				{
+					SegmentBegin = Position;
+				}
+				else if (!bFree && SegmentBegin != -1)
+				{
+					if (Position - SegmentBegin >= 2)
+					{
+						Strips.push_back({Tiles[Order[SegmentBegin]], Position - SegmentBegin, Current.bAlongY});
+						for (int32_t Claim = SegmentBegin; Claim < Position; ++Claim)
+						{
+							Claimed[Order[Claim]] = true;
+						}
+					}
+					SegmentBegin = -1;
+				}
+			}
+		}
+
+		for (size_t TileIndex = 0; TileIndex < Tiles.size(); ++TileIndex)
+		{
+			if (!Claimed[TileIndex])
+			{
+				Strips.push_back({Tiles[TileIndex], 1, false});
+			}
+		}
+		return Strips;
+	}
+
+	void UpdateCorridorStrips(std::vector<CorridorStrip>& Strips, const std::vector<Vec3>& RemovedTiles,
+	                          const std::vector<Vec3>& AddedTiles, double SectionLength,
+	                          std::vector<CorridorStrip>& RemovedStrips, std::vector<CorridorStrip>& AddedStrips)
+	{
+		RemovedStrips.clear();
+		std::vector<Vec3> Loose = AddedTiles;
+		const auto IsRemoved = [&](const CorridorStrip& Strip, int32_t TileIndex)
+		{
+			return std::any_of(RemovedTiles.begin(), RemovedTiles.end(), [&](const Vec3& Removed)
+			{
+				return Strip.FindTile(Removed, SectionLength) == TileIndex;
+			});
+		};
+
+		/* Edits remove a handful of tiles, checking each strip against all of them beats indexing every tile. */
+		size_t NumKept = 0;
+		for (const CorridorStrip& Strip : Strips)
+		{
+			const bool bHit = std::any_of(RemovedTiles.begin(), RemovedTiles.end(), [&](const Vec3& Removed)
+			{
+				return Strip.FindTile(Removed, SectionLength) != -1;
+			});
+			if (!bHit)
+			{
+				Strips[NumKept++] = Strip;
+				continue;
+			}
+
+			RemovedStrips.push_back(Strip);
+			for (int32_t TileIndex = 0; TileIndex < Strip.NumTiles; ++TileIndex)
+			{
+				if (!IsRemoved(Strip, TileIndex))
+				{
+					Loose.push_back(Strip.GetTile(TileIndex, SectionLength));
+				}
+			}
+		}
+		Strips.resize(NumKept);
+
+		AddedStrips = MergeCorridorTiles(Loose, SectionLength);
+		Strips.insert(Strips.end(), AddedStrips.begin(), AddedStrips.end());
+	}
+}
@@ -0,0 +1,632 @@
+#include "DungeonCore/DungeonLayoutGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "DungeonCore/CorridorRouter.h"
+#include "DungeonCore/OccupancyGrid.h"
+#include "DungeonCore/SeparationSolver.h"
+#include "DungeonCore/SpanningTree.h"
+#include "DungeonCore/Triangulation.h"
+#include "DungeonTrace.h"
+
+namespace DungeonCore
+{
+	namespace
+	{
+		constexpr double Pi = 3.14159265358979323846;
+		constexpr double CorridorZ = -5.;
+
+		/* Rings of tiles searched around the midpoint of a cross-floor edge when the lower room has no stair spot. */
+		constexpr int32_t MaxStairSearchRings = 16;
+
+		/* Share of GenerateLayout progress reached once each stage is done, separation dominates the cost. */
+		constexpr float SpawnDone = 0.05f;
+		constexpr float SeparationDone = 0.8f;
+		constexpr float RoomsDone = 0.82f;
+		constexpr float ConnectDone = 0.9f;
+
+		/* Separation work between two progress updates and cancel checks. */
+		constexpr double SeparationSliceMs = 4.;
+
+		void NotePeakBytes(DungeonLayout& Layout, size_t ScratchBytes)
+		{
+			Layout.Stats.PeakBytes = std::max(Layout.Stats.PeakBytes, Layout.GetAllocatedBytes() + ScratchBytes);
+		}
+
+		bool IsLargeCell(const DungeonParams& Params, const Cell& Current)
+		{
+			return Current.Scale.X > Params.MinSize + 10 && Current.Scale.Y > Params.MinSize + 10;
+		}
+
+		/* Floors the rooms actually use, at least Layout.NumFloors. */
+		int CountFloors(const DungeonLayout& Layout)
+		{
+			int NumFloors = std::max(1, Layout.NumFloors);
+			for (const Room& Current : Layout.Rooms)
+			{
+				NumFloors = std::max(NumFloors, Current.Floor + 1);
+			}
+			return NumFloors;
+		}
+
+		/*
+		 * Candidate edges between the rooms of two adjacent floors, from one triangulation of both. Rooms the
+		 * triangulation leaves out, stacked exactly above another or all collinear, get linked to the nearest
+		 * room of the other floor instead.
+		 */
+		void LinkFloors(const DungeonLayout& Layout, const std::vector<int32_t>& Lower,
+		                const std::vector<int32_t>& Upper, std::vector<IndexEdge>& Candidates, size_t& ScratchBytes)
+		{
+			if (Lower.empty() || Upper.empty())
+			{
+				return;
+			}
+
+			const int32_t NumLower = static_cast<int32_t>(Lower.size());
+			std::vector<Vec2> Points;
+			Points.reserve(Lower.size() + Upper.size());
+			for (const std::vector<int32_t>* Floor : {&Lower, &Upper})
+			{
+				for (const int32_t RoomIndex : *Floor)
+				{
+					Points.push_back(Layout.GetRoom(RoomIndex).GetCenter());
+				}
+			}
+			const auto RoomOf = [&](int32_t Vertex)
+			{
+				return Vertex < NumLower ? Lower[Vertex] : Upper[Vertex - NumLower];
+			};
+
+			const Triangulation DT = Triangulate(Points);
+			std::vector<bool> Used(Points.size(), false);
+			for (const IndexEdge& Edge : DT.Edges)
+			{
+				Used[Edge.A] = Used[Edge.B] = true;
+				if ((Edge.A < NumLower) != (Edge.B < NumLower))
+				{
+					Candidates.push_back({RoomOf(Edge.A), RoomOf(Edge.B), std::hypot(Edge.Weight, Layout.FloorHeight)});
+				}
+			}
+
+			for (int32_t Vertex = 0; Vertex < static_cast<int32_t>(Points.size()); ++Vertex)
+			{
+				if (Used[Vertex])
+				{
+					continue;
+				}
+				const bool bIsLower = Vertex < NumLower;
+				const int32_t First = bIsLower ? NumLower : 0;
+				const int32_t Last = bIsLower ? static_cast<int32_t>(Points.size()) : NumLower;
+				int32_t Nearest = First;
+				for (int32_t Other = First + 1; Other < Last; ++Other)
+				{
+					if ((Points[Other] - Points[Vertex]).SizeSquared() < (Points[Nearest] - Points[Vertex]).SizeSquared())
+					{
+						Nearest = Other;
+					}
+				}
+				Candidates.push_back({RoomOf(Vertex), RoomOf(Nearest),
+				                      std::hypot((Points[Nearest] - Points[Vertex]).Size(), Layout.FloorHeight)});
+			}
+			ScratchBytes = std::max(ScratchBytes, DT.GetAllocatedBytes() + GetAllocatedBytes(Points));
+		}
+
+		/*
+		 * Stairs climb out of the lower room, from its tile closest to the upper room that lands inside the upper
+		 * room or on no room at all upstairs. Only the upper floor then needs a corridor, if any. When every tile
+		 * is covered by other rooms upstairs, the nearest tile to the middle of the two rooms that is inside no
+		 * room on either floor is used instead.
+		 */
+		Vec2 PlaceStairwell(const Room& Lower, const Room& Upper, double SectionLength,
+		                    const OccupancyGrid& LowerOccupancy, const OccupancyGrid& UpperOccupancy)
+		{
+			const auto ToGrid = [SectionLength](double Coord)
+			{
+				return static_cast<int32_t>(std::floor(Coord / SectionLength));
+			};
+			const auto TileCenter = [SectionLength](int32_t X, int32_t Y)
+			{
+				return Vec2{(X + 0.5) * SectionLength, (Y + 0.5) * SectionLength};
+			};
+
+			const Bounds2D& From = Lower.Bounds;
+			Vec2 Best;
+			double BestDistance = -1.;
+			for (int32_t Y = ToGrid(From.Origin.Y - From.Extent.Y); Y <= ToGrid(From.Origin.Y + From.Extent.Y); ++Y)
+			{
+				for (int32_t X = ToGrid(From.Origin.X - From.Extent.X); X <= ToGrid(From.Origin.X + From.Extent.X); ++X)
+				{
+					const Vec2 Candidate = TileCenter(X, Y);
+					if (!From.Overlap(Candidate))
+					{
+						continue;
+					}
+					const bool bInsideUpper = Upper.Bounds.Overlap(Candidate);
+					if (!bInsideUpper && UpperOccupancy.IsInsideRoom(Candidate))
+					{
+						continue;
+					}
+					const double Distance = bInsideUpper ? 0. : (Candidate - Upper.GetCenter()).SizeSquared();
+					if (BestDistance < 0. || Distance < BestDistance)
+					{
+						Best = Candidate;
+						BestDistance = Distance;
+					}
+				}
+			}
+			if (BestDistance >= 0.)
+			{
+				return Best;
+			}
+
+			const Vec2 Middle = (Lower.GetCenter() + Upper.GetCenter()) / 2.;
+			const int32_t MiddleX = ToGrid(Middle.X);
+			const int32_t MiddleY = ToGrid(Middle.Y);
+			for (int32_t Ring = 0; Ring <= MaxStairSearchRings; ++Ring)
+			{
+				for (int32_t OffsetY = -Ring; OffsetY <= Ring; ++OffsetY)
+				{
+					for (int32_t OffsetX = -Ring; OffsetX <= Ring; ++OffsetX)
+					{
+						if (std::max(std::abs(OffsetX), std::abs(OffsetY)) != Ring)
+						{
+							continue;
+						}
+						const Vec2 Candidate = TileCenter(MiddleX + OffsetX, MiddleY + OffsetY);
+						if (!LowerOccupancy.IsInsideRoom(Candidate) && !UpperOccupancy.IsInsideRoom(Candidate))
+						{
+							return Candidate;
+						}
+					}
+				}
+			}
+
+			/* Packed solid around the middle, the stairwell ends up inside a room rather than nowhere. */
+			return TileCenter(MiddleX, MiddleY);
+		}
+
+		void TryPlaceCorridorTile(OccupancyGrid& Occupancy, const Vec3& Location, std::vector<Vec3>& Tiles,
+		                          std::vector<Vec3>* RouteTiles)
+		{
+			if (Occupancy.IsInsideRoom({Location.X, Location.Y}))
+			{
+				return;
+			}
+			if (Occupancy.AddTile(Location))
+			{
+				Tiles.push_back(Location);
+			}
+			if (RouteTiles)
+			{
+				RouteTiles->push_back(Location);
+			}
+		}
+
+		/* Every stage of GenerateLayout, returns early once Progress is cancelled. */
+		void RunStages(const DungeonParams& Params, uint32_t Seed, GenerationProgress* Progress, DungeonLayout& Layout)
+		{
+			const auto StageRng = [Seed](RandomStage Stage)
+			{
+				return RandomEngine{Seed, static_cast<uint64_t>(Stage)};
+			};
+
+			/* Records the stage as done and tells the caller whether to carry on. */
+			const auto Advance = [Progress](float Done)
+			{
+				if (!Progress)
+				{
+					return true;
+				}
+				Progress->Set(Done);
+				return !Progress->IsCancelled();
+			};
+
+			RandomEngine SpawnRng = StageRng(RandomStage::SpawnCells);
+			SpawnCells(Params, SpawnRng, Layout);
+			if (!Advance(SpawnDone))
+			{
+				return;
+			}
+
+			SeparateCells(Params, Layout, Progress);
+			if (!Advance(SeparationDone))
+			{
+				return;
+			}
+
+			RandomEngine RoomRng = StageRng(RandomStage::SelectRooms);
+			SelectRooms(Params, RoomRng, Layout);
+			if (!Advance(RoomsDone))
+			{
+				return;
+			}
+
+			RandomEngine ConnectRng = StageRng(RandomStage::ConnectRooms);
+			ConnectRooms(ConnectRng, Layout);
+			if (!Advance(ConnectDone))
+			{
+				return;
+			}
+
+			BuildCorridors(Params, Layout);
+			Advance(1.f);
+		}
+	}
+
+	float RandomFloat(RandomEngine& Rng)
+	{
+		return Rng.NextFloat();
+	}
+
+	int RandRange(RandomEngine& Rng, int Min, int Max)
+	{
+		/* An empty or inverted range would divide by zero or wrap in NextBounded. */
+		if (Max <= Min)
+		{
+			return Min;
+		}
+		return Min + static_cast<int>(Rng.NextBounded(static_cast<uint32_t>(Max - Min) + 1u));
+	}
+
+	int RoundM(double Loc, int SnapSize)
+	{
+		return static_cast<int>(std::floor((Loc + SnapSize - 1) / SnapSize)) * SnapSize;
+	}
+
+	Vec2 RoundM(const Vec2& Loc, int SnapSize)
+	{
+		return {static_cast<double>(RoundM(Loc.X, SnapSize)), static_cast<double>(RoundM(Loc.Y, SnapSize))};
+	}
+
+	Vec2 GetRandomPointInCircle(RandomEngine& Rng, float Radius, int SnapSize)
+	{
+		const float t = static_cast<float>(2 * Pi) * RandomFloat(Rng);
+		const float u = RandomFloat(Rng) + RandomFloat(Rng);
+		const float r = u > 1 ? 2 - u : u;
+
+		return {static_cast<double>(RoundM(Radius * r * std::cos(t), SnapSize)),
+		        static_cast<double>(RoundM(Radius * r * std::sin(t), SnapSize))};
+	}
+
+	void SpawnCells(const DungeonParams& Params, RandomEngine& Rng, DungeonLayout& Layout)
+	{
+		DUNGEONCORE_TRACE_SCOPE(DungeonSpawnCells);
+		ScopedStageTimer Timer{Layout.Stats.SpawnMs};
+
+		Layout.NumFloors = std::max(1, Params.NumFloors);
+		Layout.FloorHeight = Params.FloorHeight;
+		Layout.Cells.reserve(Layout.Cells.size() + Params.NumberOfCells);
+		for (int CellSpawned = 0; CellSpawned < Params.NumberOfCells; ++CellSpawned)
+		{
+			Cell NewCell;
+			NewCell.Floor = CellSpawned % Layout.NumFloors;
+			NewCell.Location = GetRandomPointInCircle(Rng, Params.SpawnRadius, Params.SnapSize);
+			NewCell.Scale.X = RandRange(Rng, Params.MinSize, Params.MaxSize) * 2;
+			NewCell.Scale.Y = RandRange(Rng, Params.MinSize, Params.MaxSize) * 2;
+			NewCell.Scale.Z = 2;
+			NewCell.HalfExtent = {Params.RoomMeshExtent.X * NewCell.Scale.X,
+			                      Params.RoomMeshExtent.Y * NewCell.Scale.Y,
+			                      Params.RoomMeshExtent.Z * NewCell.Scale.Z};
+			Layout.Cells.push_back(NewCell);
+		}
+		NotePeakBytes(Layout, 0);
+	}
+
+	void SeparateCells(const DungeonParams& Params, DungeonLayout& Layout, GenerationProgress* Progress)
+	{
+		DUNGEONCORE_TRACE_SCOPE(DungeonSeparateCells);
+		ScopedStageTimer Timer{Layout.Stats.SeparationMs};
+
+		SeparationSettings Settings;
+		Settings.Method = Params.Separation;
+		Settings.MinDistance = Params.MinDistance;
+		Settings.Tolerance = Params.SeparationTolerance;
+		Settings.MaxIterations = Params.MaxSeparationSteps;
+
+		SeparationSolver Solver;
+		Solver.Init(Layout.Cells, Settings);
+		while (!Solver.IsDone())
+		{
+			{
+				DUNGEONCORE_TRACE_SCOPE(DungeonSeparationSlice);
+				Solver.Solve(Progress ? SeparationSliceMs : 0.);
+			}
+			if (Progress)
+			{
+				if (Progress->IsCancelled())
+				{
+					break;
+				}
+				/* The iteration cap is the only bound we know up front, settling early just jumps ahead. */
+				const float Fraction = static_cast<float>(Solver.GetResult().Iterations) / std::max(1, Params.MaxSeparationSteps);
+				Progress->Set(SpawnDone + (SeparationDone - SpawnDone) * Fraction);
+			}
+		}
+		Layout.SeparationSteps += Solver.GetResult().Iterations;
+		Layout.Stats.bSeparationConverged = Solver.GetResult().bConverged;
+		Solver.Commit(Layout.Cells);
+		NotePeakBytes(Layout, Solver.GetAllocatedBytes());
+	}
+
+	Room MakeRoom(const DungeonParams& Params, const DungeonLayout& Layout, int CellIndex)
+	{
+		const Cell& Source = Layout.Cells[CellIndex];
+		return {CellIndex, Source.GetBounds(), IsLargeCell(Params, Source) ? RoomType::Main : RoomType::Side, Source.Floor};
+	}
+
+	void SelectRooms(const DungeonParams& Params, RandomEngine& Rng, DungeonLayout& Layout)
+	{
+		DUNGEONCORE_TRACE_SCOPE(DungeonSelectRooms);
+		ScopedStageTimer Timer{Layout.Stats.SelectRoomsMs};
+
+		Layout.Rooms.clear();
+		for (int CellIndex = 0; CellIndex < static_cast<int>(Layout.Cells.size()); ++CellIndex)
+		{
+			Cell& Current = Layout.Cells[CellIndex];
+			Current.bIsRoom = IsLargeCell(Params, Current) || RandomFloat(Rng) > 0.85f;
+			if (Current.bIsRoom)
+			{
+				Current.Location = RoundM(Current.Location, Params.SnapSize);
+				Layout.Rooms.push_back(MakeRoom(Params, Layout, CellIndex));
+			}
+		}
+		NotePeakBytes(Layout, 0);
+	}
+
+	void ConnectRooms(RandomEngine& Rng, DungeonLayout& Layout)
+	{
+		Layout.Edges.clear();
+
+		/* Room indices of each floor, in room order, so a single floor triangulates all rooms as they are. */
+		std::vector<std::vector<int32_t>> FloorRooms(CountFloors(Layout));
+		for (int32_t RoomIndex = 0; RoomIndex < static_cast<int32_t>(Layout.Rooms.size()); ++RoomIndex)
+		{
+			FloorRooms[std::max(0, Layout.GetRoom(RoomIndex).Floor)].push_back(RoomIndex);
+		}
+
+		/* Edges within a floor first, then those between each pair of adjacent floors. */
+		std::vector<IndexEdge> Candidates;
+		size_t ScratchBytes = 0;
+		{
+			DUNGEONCORE_TRACE_SCOPE(DungeonTriangulate);
+			ScopedStageTimer Timer{Layout.Stats.TriangulationMs};
+			Layout.Stats.NumTriangles = 0;
+			std::vector<Vec2> Points;
+			for (const std::vector<int32_t>& Floor : FloorRooms)
+			{
+				Points.clear();
+				for (const int32_t RoomIndex : Floor)
+				{
+					Points.push_back(Layout.GetRoom(RoomIndex).GetCenter());
+				}
+
+				const Triangulation DT = Triangulate(Points);
+				Layout.Stats.NumTriangles += DT.NumTriangles();
+				for (const IndexEdge& Edge : DT.Edges)
+				{
+					Candidates.push_back({Floor[Edge.A], Floor[Edge.B], Edge.Weight});
+				}
+				ScratchBytes = std::max(ScratchBytes, DT.GetAllocatedBytes() + GetAllocatedBytes(Points));
+			}
+
+			for (size_t Floor = 0; Floor + 1 < FloorRooms.size(); ++Floor)
+			{
+				LinkFloors(Layout, FloorRooms[Floor], FloorRooms[Floor + 1], Candidates, ScratchBytes);
+			}
+		}
+		if (Candidates.empty())
+		{
+			return;
+		}
+
+		std::vector<int32_t> TreeEdges;
+		{
+			DUNGEONCORE_TRACE_SCOPE(DungeonSpanningTree);
+			ScopedStageTimer Timer{Layout.Stats.SpanningTreeMs};
+			TreeEdges = MinimumSpanningTree(Candidates, static_cast<int32_t>(Layout.Rooms.size()));
+		}
+
+		DUNGEONCORE_TRACE_SCOPE(DungeonLoopEdges);
+		ScopedStageTimer Timer{Layout.Stats.LoopEdgesMs};
+
+		std::vector<bool> InTree(Candidates.size(), false);
+		for (const int32_t EdgeIndex : TreeEdges)
+		{
+			const IndexEdge& Edge = Candidates[EdgeIndex];
+			Layout.Edges.push_back({Edge.A, Edge.B, Edge.Weight, false});
+			InTree[EdgeIndex] = true;
+		}
+
+		/* Re-add a few of the remaining edges so the dungeon has loops. */
+		Layout.Stats.NumLoopEdges = 0;
+		for (size_t EdgeIndex = 0; EdgeIndex < Candidates.size(); ++EdgeIndex)
+		{
+			if (!InTree[EdgeIndex] && RandomFloat(Rng) > 0.9f)
+			{
+				const IndexEdge& Edge = Candidates[EdgeIndex];
+				Layout.Edges.push_back({Edge.A, Edge.B, Edge.Weight, true});
+				++Layout.Stats.NumLoopEdges;
+			}
+		}
+		NotePeakBytes(Layout, ScratchBytes + GetAllocatedBytes(Candidates) + GetAllocatedBytes(TreeEdges) +
+		              InTree.capacity() / 8);
+	}
+
+	void BuildCorridors(const DungeonParams& Params, DungeonLayout& Layout)
+	{
+		DUNGEONCORE_TRACE_SCOPE(DungeonBuildCorridors);
+		ScopedStageTimer Timer{Layout.Stats.CorridorsMs};
+
+		Layout.CorridorTiles.clear();
+		Layout.Stairs.clear();
+		const double SectionLength = Params.SectionLength;
+
+		/* Rooms only block corridors on their own floor. */
+		std::vector<OccupancyGrid> Occupancy(CountFloors(Layout));
+		for (int Floor = 0; Floor < static_cast<int>(Occupancy.size()); ++Floor)
+		{
+			Occupancy[Floor].Reset(SectionLength);
+			Occupancy[Floor].AddRooms(Layout, Floor);
+		}
+		CorridorRouter Router;
+		Router.Reset(SectionLength);
+
+		for (const RoomEdge& Edge : Layout.Edges)
+		{
+			BuildEdgeCorridor(Params, Edge, Router, Occupancy, Layout);
+		}
+
+		size_t OccupancyBytes = 0;
+		for (const OccupancyGrid& Floor : Occupancy)
+		{
+			OccupancyBytes += Floor.GetAllocatedBytes();
+		}
+		NotePeakBytes(Layout, OccupancyBytes + Router.GetAllocatedBytes());
+	}
+
+	void BuildEdgeCorridor(const DungeonParams& Params, const RoomEdge& Edge, CorridorRouter& Router,
+	                       std::vector<OccupancyGrid>& Occupancy, DungeonLayout& Layout, std::vector<Vec3>* RouteTiles)
+	{
+		const double SectionLength = Params.SectionLength;
+		const Room& A = Layout.GetRoom(Edge.A);
+		const Room& B = Layout.GetRoom(Edge.B);
+		if (A.Floor == B.Floor)
+		{
+			RouteCorridor(A.Bounds, B.Bounds, GetCorridorZ(Layout, A.Floor), SectionLength, Router, Occupancy[A.Floor],
+			              Layout.CorridorTiles, RouteTiles);
+			return;
+		}
+
+		/* A stairwell outside a room gets a corridor tile on that floor, routed to the room it serves. */
+		const Room& Lower = A.Floor < B.Floor ? A : B;
+		const Room& Upper = A.Floor < B.Floor ? B : A;
+		const Vec2 Stair = PlaceStairwell(Lower, Upper, SectionLength, Occupancy[Lower.Floor], Occupancy[Upper.Floor]);
+		const Bounds2D StairBounds{Stair, {SectionLength / 2., SectionLength / 2.}};
+		for (const Room* End : {&Lower, &Upper})
+		{
+			if (End->Bounds.Overlap(Stair))
+			{
+				continue;
+			}
+			const Vec3 Tile{Stair.X, Stair.Y, GetCorridorZ(Layout, End->Floor)};
+			if (Occupancy[End->Floor].AddTile(Tile))
+			{
+				Layout.CorridorTiles.push_back(Tile);
+			}
+			if (RouteTiles)
+			{
+				RouteTiles->push_back(Tile);
+			}
+			RouteCorridor(StairBounds, End->Bounds, Tile.Z, SectionLength, Router, Occupancy[End->Floor],
+			              Layout.CorridorTiles, RouteTiles);
+		}
+		Layout.Stairs.push_back({Stair, Lower.Floor});
+	}
+
+	double GetCorridorZ(const DungeonLayout& Layout, int Floor)
+	{
+		return Layout.GetFloorZ(Floor) + CorridorZ;
+	}
+
+	void RouteCorridor(const Bounds2D& From, const Bounds2D& To, double TileZ, double SectionLength,
+	                   CorridorRouter& Router, OccupancyGrid& Occupancy, std::vector<Vec3>& Tiles,
+	                   std::vector<Vec3>* RouteTiles)
+	{
+		if (!Router.Route(From, To, TileZ, Occupancy, Tiles, RouteTiles))
+		{
+			LayCorridor(From.Origin, To.Origin, TileZ, SectionLength, Occupancy, Tiles, RouteTiles);
+		}
+	}
+
+	void LayCorridor(const Vec2& From, const Vec2& To, double TileZ, double SectionLength, OccupancyGrid& Occupancy,
+	                 std::vector<Vec3>& Tiles, std::vector<Vec3>* RouteTiles)
+	{
+		const Vec2 P0 = From;
+		const Vec2 PathLoc = To - P0;
+
+		int CountX = static_cast<int>(std::trunc(PathLoc.X / SectionLength));
+		int CountY = static_cast<int>(std::trunc(PathLoc.Y / SectionLength));
+		const int DirX = CountX < 0 ? -1 : 1;
+		const int DirY = CountY < 0 ? -1 : 1;
+
+		CountX = std::abs(CountX) + (DirX == 1 ? 0 : 1);
+		CountY = std::abs(CountY) + (DirY == 1 ? 0 : 1);
+
+		int TotalBlocksToSpawn = CountX + CountY;
+
+		Vec3 Location{P0.X + SectionLength * DirX, P0.Y + SectionLength / 2, TileZ};
+
+		/* X run first, then turn and walk the Y run. */
+		while (TotalBlocksToSpawn > 0)
+		{
+			if (TotalBlocksToSpawn <= CountY)
+			{
+				Location.Y += SectionLength * DirY;
+			}
+			else
+			{
+				Location.X += SectionLength * DirX;
+			}
+			TryPlaceCorridorTile(Occupancy, Location, Tiles, RouteTiles);
+			--TotalBlocksToSpawn;
+		}
+	}
+
+	bool IsOverlappingRoom(const DungeonLayout& Layout, const Vec2& Loc)
+	{
+		for (const Room& Current : Layout.Rooms)
+		{
+			if (Current.Bounds.Overlap(Loc))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	Segment GetClosestEdge(const DungeonLayout& Layout, int RoomA, int RoomB)
+	{
+		const Bounds2D& A = Layout.GetRoom(RoomA).Bounds;
+		const Bounds2D& B = Layout.GetRoom(RoomB).Bounds;
+
+		const Vec2 StartPoints[] = {
+			{A.Origin.X, A.Origin.Y - A.Extent.Y},
+			{A.Origin.X + A.Extent.X, A.Origin.Y},
+			{A.Origin.X, A.Origin.Y + A.Extent.Y},
+			{A.Origin.X - A.Extent.X, A.Origin.Y},
+		};
+		const Vec2 EndPoints[] = {
+			{B.Origin.X, B.Origin.Y - B.Extent.Y},
+			{B.Origin.X + B.Extent.X, B.Origin.Y},
+			{B.Origin.X, B.Origin.Y + B.Extent.Y},
+			{B.Origin.X - B.Extent.X, B.Origin.Y},
+		};
+
+		Segment Best{StartPoints[0], EndPoints[0], static_cast<int>((EndPoints[0] - StartPoints[0]).Size())};
+		for (const Vec2& Start : StartPoints)
+		{
+			for (const Vec2& End : EndPoints)
+			{
+				const int Weight = static_cast<int>((End - Start).Size());
+				if (Weight < Best.Weight)
+				{
+					Best = {Start, End, Weight};
+				}
+			}
+		}
+		return Best;
+	}
+
+	DungeonLayout GenerateLayout(const DungeonParams& Params, uint32_t Seed, GenerationProgress* Progress)
+	{
+		DUNGEONCORE_TRACE_SCOPE(DungeonGenerateLayout);
+		DungeonLayout Layout;
+		{
+			ScopedStageTimer Timer{Layout.Stats.TotalMs};
+			RunStages(Params, Seed, Progress, Layout);
+		}
+		return Layout;
+	}
+}
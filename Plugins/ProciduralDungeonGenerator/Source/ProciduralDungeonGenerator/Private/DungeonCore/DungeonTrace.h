@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+
+// Profiler scopes for the core. Inside the engine module they become Unreal Insights CPU events, the
+// standalone build compiles them away. Name is a bare identifier, as for TRACE_CPUPROFILER_EVENT_SCOPE.
+#if defined(DUNGEONCORE_WITH_ENGINE) && DUNGEONCORE_WITH_ENGINE
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#define DUNGEONCORE_TRACE_SCOPE(Name) TRACE_CPUPROFILER_EVENT_SCOPE(Name)
+#else
+#define DUNGEONCORE_TRACE_SCOPE(Name)
+#endif
+
+namespace DungeonCore
+{
+	/* Adds the wall clock time spent in its scope to Target, in milliseconds. */
+	class ScopedStageTimer
+	{
+	public:
+		explicit ScopedStageTimer(double& InTarget) : Target{InTarget}, Start{std::chrono::steady_clock::now()}
+		{
+		}
+
+		~ScopedStageTimer()
+		{
+			Target += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+		}
+
+		ScopedStageTimer(const ScopedStageTimer&) = delete;
+		ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+	private:
+		double& Target;
+		std::chrono::steady_clock::time_point Start;
+	};
+}
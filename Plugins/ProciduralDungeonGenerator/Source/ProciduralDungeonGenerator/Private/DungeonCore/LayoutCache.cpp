@@ -0,0 +1,91 @@
+#include "DungeonCore/LayoutCache.h"
+
+#include <algorithm>
+
+#include "DungeonCore/DungeonLayoutGenerator.h"
+
+namespace DungeonCore
+{
+	std::shared_ptr<const DungeonLayout> LayoutCache::Find(const DungeonParams& Params, uint32_t Seed)
+	{
+		std::lock_guard<std::mutex> Lock{Mutex};
+		for (Entry& Cached : Entries)
+		{
+			if (Cached.Seed == Seed && Cached.Params == Params)
+			{
+				Cached.LastUsed = ++UseCounter;
+				return Cached.Layout;
+			}
+		}
+		return nullptr;
+	}
+
+	std::shared_ptr<const DungeonLayout> LayoutCache::GetOrGenerate(const DungeonParams& Params, uint32_t Seed,
+	                                                                GenerationProgress* Progress)
+	{
+		if (std::shared_ptr<const DungeonLayout> Cached = Find(Params, Seed))
+		{
+			if (Progress)
+			{
+				Progress->Set(1.f);
+			}
+			return Cached;
+		}
+
+		auto Layout = std::make_shared<const DungeonLayout>(GenerateLayout(Params, Seed, Progress));
+		if (Progress && Progress->IsCancelled())
+		{
+			return nullptr;
+		}
+		Add(Params, Seed, Layout);
+		return Layout;
+	}
+
+	void LayoutCache::Add(const DungeonParams& Params, uint32_t Seed, std::shared_ptr<const DungeonLayout> Layout)
+	{
+		std::lock_guard<std::mutex> Lock{Mutex};
+		for (Entry& Cached : Entries)
+		{
+			/* Another thread may have generated the same key meanwhile, both results are identical. */
+			if (Cached.Seed == Seed && Cached.Params == Params)
+			{
+				Cached.LastUsed = ++UseCounter;
+				return;
+			}
+		}
+
+		Entries.push_back({Params, Seed, ++UseCounter, std::move(Layout)});
+		EvictToCapacity();
+	}
+
+	void LayoutCache::SetCapacity(size_t InCapacity)
+	{
+		std::lock_guard<std::mutex> Lock{Mutex};
+		Capacity = InCapacity;
+		EvictToCapacity();
+	}
+
+	void LayoutCache::Clear()
+	{
+		std::lock_guard<std::mutex> Lock{Mutex};
+		Entries.clear();
+	}
+
+	size_t LayoutCache::Num() const
+	{
+		std::lock_guard<std::mutex> Lock{Mutex};
+		return Entries.size();
+	}
+
+	void LayoutCache::EvictToCapacity()
+	{
+		while (Entries.size() > Capacity)
+		{
+			const auto Oldest = std::min_element(Entries.begin(), Entries.end(), [](const Entry& A, const Entry& B)
+			{
+				return A.LastUsed < B.LastUsed;
+			});
+			Entries.erase(Oldest);
+		}
+	}
+}
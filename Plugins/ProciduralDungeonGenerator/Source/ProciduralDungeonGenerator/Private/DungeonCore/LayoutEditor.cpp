@@ -0,0 +1,657 @@
+#include "DungeonCore/LayoutEditor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "DungeonCore/DungeonLayoutGenerator.h"
+
+namespace DungeonCore
+{
+	namespace
+	{
+		/* Rooms triangulated around a room being connected, enough to hold all its Delaunay neighbours in practice. */
+		constexpr size_t MaxNeighbourRooms = 16;
+
+		/* Same odds of keeping a non tree edge as ConnectRooms. */
+		constexpr float LoopEdgeThreshold = 0.9f;
+
+		void EraseValue(std::vector<int32_t>& Values, int32_t Value)
+		{
+			const auto Found = std::find(Values.begin(), Values.end(), Value);
+			if (Found != Values.end())
+			{
+				*Found = Values.back();
+				Values.pop_back();
+			}
+		}
+
+		void ReplaceValue(std::vector<int32_t>& Values, int32_t From, int32_t To)
+		{
+			std::replace(Values.begin(), Values.end(), From, To);
+		}
+
+		int32_t FindRoot(std::vector<int32_t>& Parents, int32_t Item)
+		{
+			while (Parents[Item] != Item)
+			{
+				Parents[Item] = Parents[Parents[Item]];
+				Item = Parents[Item];
+			}
+			return Item;
+		}
+
+		/* Drops the entries both lists hold, once per match, keeping the order of the rest. */
+		template <typename ValueType, typename HashType>
+		void CancelOut(std::vector<ValueType>& Removed, std::vector<ValueType>& Added)
+		{
+			std::unordered_map<ValueType, int32_t, HashType> Pending;
+			for (const ValueType& Value : Added)
+			{
+				++Pending[Value];
+			}
+
+			std::unordered_map<ValueType, int32_t, HashType> Cancelled;
+			Removed.erase(std::remove_if(Removed.begin(), Removed.end(), [&](const ValueType& Value)
+			{
+				const auto Found = Pending.find(Value);
+				if (Found == Pending.end() || Found->second == 0)
+				{
+					return false;
+				}
+				--Found->second;
+				++Cancelled[Value];
+				return true;
+			}), Removed.end());
+
+			Added.erase(std::remove_if(Added.begin(), Added.end(), [&](const ValueType& Value)
+			{
+				const auto Found = Cancelled.find(Value);
+				if (Found == Cancelled.end() || Found->second == 0)
+				{
+					return false;
+				}
+				--Found->second;
+				return true;
+			}), Added.end());
+		}
+
+		struct StairHash
+		{
+			size_t operator()(const Stairwell& Stair) const
+			{
+				return std::hash<double>()(Stair.Location.X) ^ std::hash<double>()(Stair.Location.Y) * 31u ^
+					static_cast<size_t>(Stair.LowerFloor) * 131u;
+			}
+		};
+	}
+
+	void LayoutChanges::Clear()
+	{
+		RemovedRooms.clear();
+		AddedRooms.clear();
+		RemovedTiles.clear();
+		AddedTiles.clear();
+		RemovedStairs.clear();
+		AddedStairs.clear();
+	}
+
+	size_t LayoutEditor::TileHash::operator()(const Vec3& Tile) const
+	{
+		/* Adding 0 turns -0 into 0, the two compare equal so they have to hash the same. */
+		const double Coords[3] = {Tile.X + 0., Tile.Y + 0., Tile.Z + 0.};
+		uint64_t Bits[3];
+		std::memcpy(Bits, Coords, sizeof(Bits));
+		return static_cast<size_t>(Bits[0] * 0x9E3779B97F4A7C15ull ^ Bits[1] * 0xC2B2AE3D27D4EB4Full ^
+			Bits[2] * 0x165667B19E3779F9ull);
+	}
+
+	void LayoutEditor::Init(const DungeonParams& InParams, uint32_t Seed, DungeonLayout& InLayout)
+	{
+		Params = InParams;
+		Layout = &InLayout;
+		Rng = RandomEngine{Seed, static_cast<uint64_t>(RandomStage::EditRooms)};
+		Router.Reset(Params.SectionLength);
+
+		int NumFloors = std::max(1, Layout->NumFloors);
+		for (const Room& Current : Layout->Rooms)
+		{
+			NumFloors = std::max(NumFloors, Current.Floor + 1);
+		}
+		Occupancy.assign(NumFloors, OccupancyGrid());
+		for (OccupancyGrid& Floor : Occupancy)
+		{
+			Floor.Reset(Params.SectionLength);
+		}
+
+		const int32_t NumRooms = static_cast<int32_t>(Layout->Rooms.size());
+		RoomOccupancy.resize(NumRooms);
+		RoomEdges.assign(NumRooms, {});
+		for (int32_t RoomIndex = 0; RoomIndex < NumRooms; ++RoomIndex)
+		{
+			const Room& Current = Layout->GetRoom(RoomIndex);
+			RoomOccupancy[RoomIndex] = Occupancy[Current.Floor].AddRoom(Current.Bounds);
+		}
+
+		/* Same edges in the same order through the same router as BuildCorridors, so the same tiles. */
+		Layout->CorridorTiles.clear();
+		Layout->Stairs.clear();
+		Tiles.clear();
+		StairEdges.clear();
+		Routes.assign(Layout->Edges.size(), {});
+		LayoutChanges Ignored;
+		for (int32_t EdgeIndex = 0; EdgeIndex < static_cast<int32_t>(Layout->Edges.size()); ++EdgeIndex)
+		{
+			const RoomEdge& Edge = Layout->Edges[EdgeIndex];
+			RoomEdges[Edge.A].push_back(EdgeIndex);
+			RoomEdges[Edge.B].push_back(EdgeIndex);
+			LayRoute(EdgeIndex, Ignored);
+		}
+	}
+
+	int LayoutEditor::AddRoom(const Vec2& Location, const Vec2& HalfExtent, int Floor, LayoutChanges& Changes)
+	{
+		Changes.Clear();
+		if (!Layout || Floor < 0 || Floor >= static_cast<int>(Occupancy.size()) || HalfExtent.X <= 0. ||
+			HalfExtent.Y <= 0.)
+		{
+			return -1;
+		}
+
+		/* Scale is what the room mesh needs to cover the extent, the same way SpawnCells derives one from the other. */
+		const Vec3& MeshExtent = Params.RoomMeshExtent;
+		Cell NewCell;
+		NewCell.Location = RoundM(Location, Params.SnapSize);
+		NewCell.Scale = {MeshExtent.X > 0. ? HalfExtent.X / MeshExtent.X : 1.,
+		                 MeshExtent.Y > 0. ? HalfExtent.Y / MeshExtent.Y : 1., 2.};
+		NewCell.HalfExtent = {HalfExtent.X, HalfExtent.Y, MeshExtent.Z * NewCell.Scale.Z};
+		NewCell.bIsRoom = true;
+		NewCell.Floor = Floor;
+		if (OverlapsRoom(NewCell.GetBounds(), Floor, -1))
+		{
+			return -1;
+		}
+		Layout->Cells.push_back(NewCell);
+
+		const int32_t RoomIndex = static_cast<int32_t>(Layout->Rooms.size());
+		Layout->Rooms.push_back(MakeRoom(Params, *Layout, static_cast<int>(Layout->Cells.size()) - 1));
+		RoomOccupancy.push_back(Occupancy[Floor].AddRoom(Layout->GetRoom(RoomIndex).Bounds));
+		RoomEdges.emplace_back();
+		Changes.AddedRooms.push_back(Layout->GetRoom(RoomIndex));
+
+		RerouteAround(RoomIndex, Changes);
+		Attach(RoomIndex, Changes);
+		CancelOut<Vec3, TileHash>(Changes.RemovedTiles, Changes.AddedTiles);
+		CancelOut<Stairwell, StairHash>(Changes.RemovedStairs, Changes.AddedStairs);
+		return RoomIndex;
+	}
+
+	bool LayoutEditor::RemoveRoom(int RoomIndex, LayoutChanges& Changes)
+	{
+		Changes.Clear();
+		if (!Layout || RoomIndex < 0 || RoomIndex >= static_cast<int>(Layout->Rooms.size()))
+		{
+			return false;
+		}
+
+		Detach(RoomIndex, Changes);
+		const Room Removed = Layout->GetRoom(RoomIndex);
+		Changes.RemovedRooms.push_back(Removed);
+		Occupancy[Removed.Floor].RemoveRoom(RoomOccupancy[RoomIndex]);
+		Layout->Cells[Removed.CellIndex].bIsRoom = false;
+
+		/* The last room moves into the gap, its edges follow it. */
+		const int32_t Last = static_cast<int32_t>(Layout->Rooms.size()) - 1;
+		if (RoomIndex != Last)
+		{
+			Layout->Rooms[RoomIndex] = Layout->Rooms[Last];
+			RoomOccupancy[RoomIndex] = RoomOccupancy[Last];
+			RoomEdges[RoomIndex] = std::move(RoomEdges[Last]);
+			for (const int32_t EdgeIndex : RoomEdges[RoomIndex])
+			{
+				RoomEdge& Edge = Layout->Edges[EdgeIndex];
+				Edge.A = Edge.A == Last ? RoomIndex : Edge.A;
+				Edge.B = Edge.B == Last ? RoomIndex : Edge.B;
+			}
+		}
+		Layout->Rooms.pop_back();
+		RoomOccupancy.pop_back();
+		RoomEdges.pop_back();
+
+		CancelOut<Vec3, TileHash>(Changes.RemovedTiles, Changes.AddedTiles);
+		CancelOut<Stairwell, StairHash>(Changes.RemovedStairs, Changes.AddedStairs);
+		return true;
+	}
+
+	bool LayoutEditor::MoveRoom(int RoomIndex, const Vec2& Location, LayoutChanges& Changes)
+	{
+		Changes.Clear();
+		if (!Layout || RoomIndex < 0 || RoomIndex >= static_cast<int>(Layout->Rooms.size()))
+		{
+			return false;
+		}
+
+		const Room Moved = Layout->GetRoom(RoomIndex);
+		const Vec2 Snapped = RoundM(Location, Params.SnapSize);
+		if (OverlapsRoom({Snapped, Moved.Bounds.Extent}, Moved.Floor, RoomIndex))
+		{
+			return false;
+		}
+
+		Detach(RoomIndex, Changes);
+		Changes.RemovedRooms.push_back(Moved);
+		Occupancy[Moved.Floor].RemoveRoom(RoomOccupancy[RoomIndex]);
+
+		Layout->Cells[Moved.CellIndex].Location = Snapped;
+		Layout->Rooms[RoomIndex] = MakeRoom(Params, *Layout, Moved.CellIndex);
+		RoomOccupancy[RoomIndex] = Occupancy[Moved.Floor].AddRoom(Layout->GetRoom(RoomIndex).Bounds);
+		Changes.AddedRooms.push_back(Layout->GetRoom(RoomIndex));
+
+		RerouteAround(RoomIndex, Changes);
+		Attach(RoomIndex, Changes);
+		CancelOut<Vec3, TileHash>(Changes.RemovedTiles, Changes.AddedTiles);
+		CancelOut<Stairwell, StairHash>(Changes.RemovedStairs, Changes.AddedStairs);
+		return true;
+	}
+
+	size_t LayoutEditor::GetAllocatedBytes() const
+	{
+		size_t Bytes = Router.GetAllocatedBytes() + DungeonCore::GetAllocatedBytes(RoomOccupancy) +
+			DungeonCore::GetAllocatedBytes(RoomEdges) + DungeonCore::GetAllocatedBytes(Routes) +
+			DungeonCore::GetAllocatedBytes(StairEdges) + DungeonCore::GetAllocatedBytes(Occupancy);
+		for (const OccupancyGrid& Floor : Occupancy)
+		{
+			Bytes += Floor.GetAllocatedBytes();
+		}
+		for (const std::vector<int32_t>& Edges : RoomEdges)
+		{
+			Bytes += DungeonCore::GetAllocatedBytes(Edges);
+		}
+		for (const EdgeRoute& Route : Routes)
+		{
+			Bytes += DungeonCore::GetAllocatedBytes(Route.Tiles);
+		}
+
+		/* Same estimate as OccupancyGrid, one node per entry plus the bucket array. */
+		constexpr size_t NodeBytes = sizeof(std::pair<const Vec3, TileRef>) + 2 * sizeof(void*);
+		return Bytes + Tiles.size() * NodeBytes + Tiles.bucket_count() * sizeof(void*);
+	}
+
+	void LayoutEditor::AddEdge(int32_t A, int32_t B, double Weight, bool bIsLoop, LayoutChanges& Changes)
+	{
+		const int32_t EdgeIndex = static_cast<int32_t>(Layout->Edges.size());
+		Layout->Edges.push_back({A, B, Weight, bIsLoop});
+		Layout->Stats.NumLoopEdges += bIsLoop ? 1 : 0;
+		Routes.emplace_back();
+		RoomEdges[A].push_back(EdgeIndex);
+		RoomEdges[B].push_back(EdgeIndex);
+		LayRoute(EdgeIndex, Changes);
+	}
+
+	void LayoutEditor::LayRoute(int32_t EdgeIndex, LayoutChanges& Changes)
+	{
+		const size_t FirstTile = Layout->CorridorTiles.size();
+		const size_t FirstStair = Layout->Stairs.size();
+		EdgeRoute& Route = Routes[EdgeIndex];
+		BuildEdgeCorridor(Params, Layout->Edges[EdgeIndex], Router, Occupancy, *Layout, &Route.Tiles);
+
+		for (size_t TileIndex = FirstTile; TileIndex < Layout->CorridorTiles.size(); ++TileIndex)
+		{
+			const Vec3& Tile = Layout->CorridorTiles[TileIndex];
+			Tiles.emplace(Tile, TileRef{static_cast<int32_t>(TileIndex), 0});
+			Changes.AddedTiles.push_back(Tile);
+		}
+		for (const Vec3& Tile : Route.Tiles)
+		{
+			const auto Found = Tiles.find(Tile);
+			if (Found != Tiles.end())
+			{
+				++Found->second.Refs;
+			}
+		}
+
+		if (Layout->Stairs.size() > FirstStair)
+		{
+			Route.Stair = static_cast<int32_t>(FirstStair);
+			StairEdges.push_back(EdgeIndex);
+			Changes.AddedStairs.push_back(Layout->Stairs[FirstStair]);
+		}
+	}
+
+	void LayoutEditor::RemoveEdge(int32_t EdgeIndex, LayoutChanges& Changes)
+	{
+		const RoomEdge Edge = Layout->Edges[EdgeIndex];
+		for (const Vec3& Tile : Routes[EdgeIndex].Tiles)
+		{
+			ReleaseTile(Tile, Changes);
+		}
+		if (Routes[EdgeIndex].Stair != -1)
+		{
+			RemoveStair(Routes[EdgeIndex].Stair, Changes);
+		}
+		Layout->Stats.NumLoopEdges -= Edge.bIsLoop ? 1 : 0;
+		EraseValue(RoomEdges[Edge.A], EdgeIndex);
+		EraseValue(RoomEdges[Edge.B], EdgeIndex);
+
+		/* The last edge moves into the gap, its rooms and stairwell point to its new index. */
+		const int32_t Last = static_cast<int32_t>(Layout->Edges.size()) - 1;
+		if (EdgeIndex != Last)
+		{
+			Layout->Edges[EdgeIndex] = Layout->Edges[Last];
+			Routes[EdgeIndex] = std::move(Routes[Last]);
+			ReplaceValue(RoomEdges[Layout->Edges[EdgeIndex].A], Last, EdgeIndex);
+			ReplaceValue(RoomEdges[Layout->Edges[EdgeIndex].B], Last, EdgeIndex);
+			if (Routes[EdgeIndex].Stair != -1)
+			{
+				StairEdges[Routes[EdgeIndex].Stair] = EdgeIndex;
+			}
+		}
+		Layout->Edges.pop_back();
+		Routes.pop_back();
+	}
+
+	void LayoutEditor::Detach(int32_t RoomIndex, LayoutChanges& Changes)
+	{
+		/* Every tree edge of the room held a separate piece of the spanning tree. */
+		std::vector<int32_t> Pieces;
+		while (!RoomEdges[RoomIndex].empty())
+		{
+			const int32_t EdgeIndex = RoomEdges[RoomIndex].back();
+			const RoomEdge& Edge = Layout->Edges[EdgeIndex];
+			if (!Edge.bIsLoop)
+			{
+				Pieces.push_back(Edge.A == RoomIndex ? Edge.B : Edge.A);
+			}
+			RemoveEdge(EdgeIndex, Changes);
+		}
+		if (Pieces.size() < 2)
+		{
+			return;
+		}
+
+		/* Spanning tree of the pieces' rooms, a handful at most. */
+		std::vector<IndexEdge> Links;
+		for (int32_t First = 0; First < static_cast<int32_t>(Pieces.size()); ++First)
+		{
+			for (int32_t Second = First + 1; Second < static_cast<int32_t>(Pieces.size()); ++Second)
+			{
+				const double Weight = GetLinkWeight(Pieces[First], Pieces[Second]);
+				if (Weight >= 0.)
+				{
+					Links.push_back({First, Second, Weight});
+				}
+			}
+		}
+		std::stable_sort(Links.begin(), Links.end(), [](const IndexEdge& A, const IndexEdge& B)
+		{
+			return A.Weight < B.Weight;
+		});
+
+		std::vector<int32_t> Parents(Pieces.size());
+		std::iota(Parents.begin(), Parents.end(), 0);
+		size_t NumJoined = 0;
+		for (const IndexEdge& Link : Links)
+		{
+			const int32_t RootA = FindRoot(Parents, Link.A);
+			const int32_t RootB = FindRoot(Parents, Link.B);
+			if (RootA != RootB)
+			{
+				Parents[RootA] = RootB;
+				AddEdge(Pieces[Link.A], Pieces[Link.B], Link.Weight, false, Changes);
+				++NumJoined;
+			}
+		}
+
+		/* Pieces more than a floor apart, e.g. the room was the only stop between them. */
+		if (NumJoined + 1 < Pieces.size())
+		{
+			JoinTreeComponents(RoomIndex, Changes);
+		}
+	}
+
+	void LayoutEditor::Attach(int32_t RoomIndex, LayoutChanges& Changes)
+	{
+		const std::vector<IndexEdge> Candidates = FindCandidates(RoomIndex);
+		for (size_t CandidateIndex = 0; CandidateIndex < Candidates.size(); ++CandidateIndex)
+		{
+			const IndexEdge& Candidate = Candidates[CandidateIndex];
+			if (CandidateIndex == 0)
+			{
+				AddEdge(Candidate.A, Candidate.B, Candidate.Weight, false, Changes);
+			}
+			else if (RandomFloat(Rng) > LoopEdgeThreshold)
+			{
+				AddEdge(Candidate.A, Candidate.B, Candidate.Weight, true, Changes);
+			}
+		}
+	}
+
+	void LayoutEditor::RerouteAround(int32_t RoomIndex, LayoutChanges& Changes)
+	{
+		const Room& Target = Layout->GetRoom(RoomIndex);
+		const auto IsCovered = [&](const Vec3& Tile)
+		{
+			return Target.Bounds.Overlap({Tile.X, Tile.Y}) && GetTileFloor(Tile) == Target.Floor;
+		};
+
+		/* Back to front, the last edge moving into a removed one's gap has already been looked at. */
+		std::vector<RoomEdge> Crossing;
+		for (int32_t EdgeIndex = static_cast<int32_t>(Layout->Edges.size()) - 1; EdgeIndex >= 0; --EdgeIndex)
+		{
+			const std::vector<Vec3>& RouteTiles = Routes[EdgeIndex].Tiles;
+			if (std::any_of(RouteTiles.begin(), RouteTiles.end(), IsCovered))
+			{
+				Crossing.push_back(Layout->Edges[EdgeIndex]);
+				RemoveEdge(EdgeIndex, Changes);
+			}
+		}
+
+		/* The room is in the occupancy grid by now, the new routes go around it. */
+		for (auto Edge = Crossing.rbegin(); Edge != Crossing.rend(); ++Edge)
+		{
+			AddEdge(Edge->A, Edge->B, Edge->Weight, Edge->bIsLoop, Changes);
+		}
+	}
+
+	bool LayoutEditor::OverlapsRoom(const Bounds2D& Bounds, int Floor, int32_t Skip) const
+	{
+		for (int32_t RoomIndex = 0; RoomIndex < static_cast<int32_t>(Layout->Rooms.size()); ++RoomIndex)
+		{
+			const Room& Other = Layout->GetRoom(RoomIndex);
+			if (RoomIndex != Skip && Other.Floor == Floor &&
+				std::abs(Other.Bounds.Origin.X - Bounds.Origin.X) < Other.Bounds.Extent.X + Bounds.Extent.X &&
+				std::abs(Other.Bounds.Origin.Y - Bounds.Origin.Y) < Other.Bounds.Extent.Y + Bounds.Extent.Y)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::vector<IndexEdge> LayoutEditor::FindCandidates(int32_t RoomIndex) const
+	{
+		const Room& Target = Layout->GetRoom(RoomIndex);
+		const int32_t NumRooms = static_cast<int32_t>(Layout->Rooms.size());
+
+		std::vector<std::pair<double, int32_t>> Near;
+		int32_t NearestBelow = -1;
+		int32_t NearestAbove = -1;
+		const auto DistanceSquared = [&](int32_t Other)
+		{
+			return (Layout->GetRoom(Other).GetCenter() - Target.GetCenter()).SizeSquared();
+		};
+		for (int32_t Other = 0; Other < NumRooms; ++Other)
+		{
+			const int Floor = Layout->GetRoom(Other).Floor;
+			if (Other == RoomIndex)
+			{
+				continue;
+			}
+			if (Floor == Target.Floor)
+			{
+				Near.push_back({DistanceSquared(Other), Other});
+			}
+			else if (Floor == Target.Floor - 1 && (NearestBelow == -1 || DistanceSquared(Other) < DistanceSquared(NearestBelow)))
+			{
+				NearestBelow = Other;
+			}
+			else if (Floor == Target.Floor + 1 && (NearestAbove == -1 || DistanceSquared(Other) < DistanceSquared(NearestAbove)))
+			{
+				NearestAbove = Other;
+			}
+		}
+		const size_t NumNear = std::min(Near.size(), MaxNeighbourRooms);
+		std::partial_sort(Near.begin(), Near.begin() + NumNear, Near.end());
+		Near.resize(NumNear);
+
+		/* The room is vertex 0, its triangle edges are the Delaunay links it would have had all along. */
+		std::vector<IndexEdge> Candidates;
+		std::vector<Vec2> Points{Target.GetCenter()};
+		for (const auto& Neighbour : Near)
+		{
+			Points.push_back(Layout->GetRoom(Neighbour.second).GetCenter());
+		}
+		for (const IndexEdge& Edge : Triangulate(Points).Edges)
+		{
+			if (Edge.A == 0 || Edge.B == 0)
+			{
+				Candidates.push_back({RoomIndex, Near[(Edge.A == 0 ? Edge.B : Edge.A) - 1].second, Edge.Weight});
+			}
+		}
+
+		/* Left out of the triangulation, sitting on another room or in line with all of them. */
+		if (Candidates.empty() && !Near.empty())
+		{
+			Candidates.push_back({RoomIndex, Near.front().second, std::sqrt(Near.front().first)});
+		}
+		for (const int32_t Other : {NearestBelow, NearestAbove})
+		{
+			if (Other != -1)
+			{
+				Candidates.push_back({RoomIndex, Other, GetLinkWeight(RoomIndex, Other)});
+			}
+		}
+
+		std::stable_sort(Candidates.begin(), Candidates.end(), [](const IndexEdge& A, const IndexEdge& B)
+		{
+			return A.Weight < B.Weight;
+		});
+		return Candidates;
+	}
+
+	void LayoutEditor::JoinTreeComponents(int32_t Skip, LayoutChanges& Changes)
+	{
+		const int32_t NumRooms = static_cast<int32_t>(Layout->Rooms.size());
+		std::vector<int32_t> Parents(NumRooms);
+		std::iota(Parents.begin(), Parents.end(), 0);
+		for (const RoomEdge& Edge : Layout->Edges)
+		{
+			if (!Edge.bIsLoop)
+			{
+				Parents[FindRoot(Parents, Edge.A)] = FindRoot(Parents, Edge.B);
+			}
+		}
+
+		/* Each pass links one piece to its nearest room outside it, until none can be linked. */
+		for (bool bLinked = true; bLinked;)
+		{
+			bLinked = false;
+			for (int32_t Piece = 0; Piece < NumRooms && !bLinked; ++Piece)
+			{
+				if (Piece == Skip || FindRoot(Parents, Piece) != Piece)
+				{
+					continue;
+				}
+
+				IndexEdge Best{-1, -1, 0.};
+				for (int32_t Inside = 0; Inside < NumRooms; ++Inside)
+				{
+					if (Inside == Skip || FindRoot(Parents, Inside) != Piece)
+					{
+						continue;
+					}
+					for (int32_t Outside = 0; Outside < NumRooms; ++Outside)
+					{
+						if (Outside == Skip || FindRoot(Parents, Outside) == Piece)
+						{
+							continue;
+						}
+						const double Weight = GetLinkWeight(Inside, Outside);
+						if (Weight >= 0. && (Best.A == -1 || Weight < Best.Weight))
+						{
+							Best = {Inside, Outside, Weight};
+						}
+					}
+				}
+
+				/* Already the whole tree, or nothing within a floor of it. */
+				if (Best.A != -1)
+				{
+					Parents[Piece] = FindRoot(Parents, Best.B);
+					AddEdge(Best.A, Best.B, Best.Weight, false, Changes);
+					bLinked = true;
+				}
+			}
+		}
+	}
+
+	void LayoutEditor::ReleaseTile(const Vec3& Tile, LayoutChanges& Changes)
+	{
+		const auto Found = Tiles.find(Tile);
+		if (Found == Tiles.end() || --Found->second.Refs > 0)
+		{
+			return;
+		}
+
+		/* The last tile moves into the gap. */
+		const int32_t TileIndex = Found->second.Index;
+		const int32_t Last = static_cast<int32_t>(Layout->CorridorTiles.size()) - 1;
+		if (TileIndex != Last)
+		{
+			Layout->CorridorTiles[TileIndex] = Layout->CorridorTiles[Last];
+			Tiles[Layout->CorridorTiles[TileIndex]].Index = TileIndex;
+		}
+		Layout->CorridorTiles.pop_back();
+		Tiles.erase(Found);
+		Occupancy[GetTileFloor(Tile)].RemoveTile(Tile);
+		Changes.RemovedTiles.push_back(Tile);
+	}
+
+	void LayoutEditor::RemoveStair(int32_t StairIndex, LayoutChanges& Changes)
+	{
+		Changes.RemovedStairs.push_back(Layout->Stairs[StairIndex]);
+		const int32_t Last = static_cast<int32_t>(Layout->Stairs.size()) - 1;
+		if (StairIndex != Last)
+		{
+			Layout->Stairs[StairIndex] = Layout->Stairs[Last];
+			StairEdges[StairIndex] = StairEdges[Last];
+			Routes[StairEdges[StairIndex]].Stair = StairIndex;
+		}
+		Layout->Stairs.pop_back();
+		StairEdges.pop_back();
+	}
+
+	double LayoutEditor::GetLinkWeight(int32_t A, int32_t B) const
+	{
+		const Room& RoomA = Layout->GetRoom(A);
+		const Room& RoomB = Layout->GetRoom(B);
+		const int Climb = std::abs(RoomA.Floor - RoomB.Floor);
+		if (Climb > 1)
+		{
+			return -1.;
+		}
+		const double Distance = (RoomA.GetCenter() - RoomB.GetCenter()).Size();
+		return Climb == 0 ? Distance : std::hypot(Distance, Layout->FloorHeight);
+	}
+
+	int LayoutEditor::GetTileFloor(const Vec3& Tile) const
+	{
+		if (Layout->FloorHeight <= 0.)
+		{
+			return 0;
+		}
+		const long Floor = std::lround((Tile.Z - GetCorridorZ(*Layout, 0)) / Layout->FloorHeight);
+		return static_cast<int>(std::clamp<long>(Floor, 0, static_cast<long>(Occupancy.size()) - 1));
+	}
+}
@@ -0,0 +1,555 @@
+#include "DungeonCore/LayoutSerialization.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "DungeonCore/DungeonLayoutGenerator.h"
+
+namespace DungeonCore
+{
+	namespace
+	{
+		constexpr uint8_t Magic[4] = {'D', 'G', 'L', 'Y'};
+
+		/* Magic, version, flags, payload size, checksum. */
+		constexpr size_t HeaderSize = 4 + 2 + 2 + 4 + 4;
+
+		/* Cells store their scale as doubles and their half extent, set when the compact form would lose bits. */
+		constexpr uint16_t FlagFullPrecisionCells = 1 << 0;
+
+		/* Cells store their floor, set when any cell is above the ground floor. */
+		constexpr uint16_t FlagMultiFloor = 1 << 1;
+
+		/* Tile runs step along one axis, the step is ±SectionLength. */
+		enum class RunAxis : uint8_t
+		{
+			PositiveX,
+			NegativeX,
+			PositiveY,
+			NegativeY,
+			Single
+		};
+
+		uint32_t HashBytes(const uint8_t* Data, size_t Size)
+		{
+			/* FNV-1a, only meant to catch damaged files. */
+			uint32_t Hash = 2166136261u;
+			for (size_t Index = 0; Index < Size; ++Index)
+			{
+				Hash = (Hash ^ Data[Index]) * 16777619u;
+			}
+			return Hash;
+		}
+
+		class ByteWriter
+		{
+		public:
+			explicit ByteWriter(std::vector<uint8_t>& InBytes) : Bytes{InBytes}
+			{
+			}
+
+			void U8(uint8_t Value) { Bytes.push_back(Value); }
+
+			void U16(uint16_t Value) { Unsigned(Value, 2); }
+			void U32(uint32_t Value) { Unsigned(Value, 4); }
+			void I32(int32_t Value) { U32(static_cast<uint32_t>(Value)); }
+
+			void F32(float Value)
+			{
+				uint32_t Bits;
+				std::memcpy(&Bits, &Value, sizeof(Bits));
+				U32(Bits);
+			}
+
+			void F64(double Value)
+			{
+				uint64_t Bits;
+				std::memcpy(&Bits, &Value, sizeof(Bits));
+				Unsigned(Bits, 8);
+			}
+
+			void Vector3(const Vec3& Value)
+			{
+				F64(Value.X);
+				F64(Value.Y);
+				F64(Value.Z);
+			}
+
+			/* Overwrites 4 bytes written earlier, for sizes only known at the end. */
+			void PatchU32(size_t Offset, uint32_t Value)
+			{
+				for (int Byte = 0; Byte < 4; ++Byte)
+				{
+					Bytes[Offset + Byte] = static_cast<uint8_t>(Value >> (8 * Byte));
+				}
+			}
+
+		private:
+			void Unsigned(uint64_t Value, int NumBytes)
+			{
+				for (int Byte = 0; Byte < NumBytes; ++Byte)
+				{
+					Bytes.push_back(static_cast<uint8_t>(Value >> (8 * Byte)));
+				}
+			}
+
+			std::vector<uint8_t>& Bytes;
+		};
+
+		/* Every read is bounds checked, a short buffer makes the reader fail instead of reading past it. */
+		class ByteReader
+		{
+		public:
+			ByteReader(const uint8_t* InData, size_t InSize) : Data{InData}, Size{InSize}
+			{
+			}
+
+			bool IsOk() const { return bOk; }
+			size_t Remaining() const { return Size - Offset; }
+
+			uint8_t U8() { return static_cast<uint8_t>(Unsigned(1)); }
+			uint16_t U16() { return static_cast<uint16_t>(Unsigned(2)); }
+			uint32_t U32() { return static_cast<uint32_t>(Unsigned(4)); }
+			int32_t I32() { return static_cast<int32_t>(U32()); }
+
+			float F32()
+			{
+				const uint32_t Bits = U32();
+				float Value;
+				std::memcpy(&Value, &Bits, sizeof(Value));
+				return Value;
+			}
+
+			double F64()
+			{
+				const uint64_t Bits = Unsigned(8);
+				double Value;
+				std::memcpy(&Value, &Bits, sizeof(Value));
+				return Value;
+			}
+
+			Vec3 Vector3()
+			{
+				const double X = F64();
+				const double Y = F64();
+				return {X, Y, F64()};
+			}
+
+			/* Count of records of RecordSize bytes, rejected up front if they cannot fit in what is left. */
+			uint32_t Count(size_t RecordSize)
+			{
+				const uint32_t Value = U32();
+				if (bOk && static_cast<uint64_t>(Value) * RecordSize > Remaining())
+				{
+					bOk = false;
+				}
+				return bOk ? Value : 0;
+			}
+
+		private:
+			uint64_t Unsigned(int NumBytes)
+			{
+				if (!bOk || Remaining() < static_cast<size_t>(NumBytes))
+				{
+					bOk = false;
+					return 0;
+				}
+
+				uint64_t Value = 0;
+				for (int Byte = 0; Byte < NumBytes; ++Byte)
+				{
+					Value |= static_cast<uint64_t>(Data[Offset + Byte]) << (8 * Byte);
+				}
+				Offset += NumBytes;
+				return Value;
+			}
+
+			const uint8_t* Data;
+			size_t Size;
+			size_t Offset = 0;
+			bool bOk = true;
+		};
+
+		Vec3 GetHalfExtent(const DungeonParams& Params, const Vec3& Scale)
+		{
+			/* Same product as SpawnCells, so a derived extent matches the generated one bit for bit. */
+			return {Params.RoomMeshExtent.X * Scale.X, Params.RoomMeshExtent.Y * Scale.Y,
+			        Params.RoomMeshExtent.Z * Scale.Z};
+		}
+
+		bool CanStoreCompact(const DungeonParams& Params, const Cell& Current)
+		{
+			const auto FitsFloat = [](double Value)
+			{
+				return static_cast<double>(static_cast<float>(Value)) == Value;
+			};
+			return FitsFloat(Current.Scale.X) && FitsFloat(Current.Scale.Y) && FitsFloat(Current.Scale.Z) &&
+				GetHalfExtent(Params, Current.Scale) == Current.HalfExtent;
+		}
+
+		/* Same arithmetic as the reader, a tile only joins a run if the reader rebuilds it exactly. */
+		Vec3 StepTile(const Vec3& Tile, RunAxis Axis, double SectionLength)
+		{
+			Vec3 Next = Tile;
+			switch (Axis)
+			{
+			case RunAxis::PositiveX: Next.X += SectionLength; break;
+			case RunAxis::NegativeX: Next.X += -SectionLength; break;
+			case RunAxis::PositiveY: Next.Y += SectionLength; break;
+			case RunAxis::NegativeY: Next.Y += -SectionLength; break;
+			case RunAxis::Single: break;
+			}
+			return Next;
+		}
+
+		void WriteParams(ByteWriter& Writer, const DungeonParams& Params)
+		{
+			Writer.I32(Params.NumberOfCells);
+			Writer.I32(Params.MinSize);
+			Writer.I32(Params.MaxSize);
+			Writer.F32(Params.SpawnRadius);
+			Writer.F32(Params.MinDistance);
+			Writer.I32(Params.SnapSize);
+			Writer.F32(Params.SectionLength);
+			Writer.Vector3(Params.RoomMeshExtent);
+			Writer.I32(Params.MaxSeparationSteps);
+			Writer.I32(Params.NumFloors);
+			Writer.F32(Params.FloorHeight);
+			Writer.U8(static_cast<uint8_t>(Params.Separation));
+			Writer.F32(Params.SeparationTolerance);
+		}
+
+		DungeonParams ReadParams(ByteReader& Reader, uint16_t Version)
+		{
+			DungeonParams Params;
+			Params.NumberOfCells = Reader.I32();
+			Params.MinSize = Reader.I32();
+			Params.MaxSize = Reader.I32();
+			Params.SpawnRadius = Reader.F32();
+			Params.MinDistance = Reader.F32();
+			Params.SnapSize = Reader.I32();
+			Params.SectionLength = Reader.F32();
+			Params.RoomMeshExtent = Reader.Vector3();
+			Params.MaxSeparationSteps = Reader.I32();
+			if (Version >= 2)
+			{
+				Params.NumFloors = Reader.I32();
+				Params.FloorHeight = Reader.F32();
+			}
+			if (Version >= 3)
+			{
+				Params.Separation = static_cast<SeparationMethod>(Reader.U8());
+				Params.SeparationTolerance = Reader.F32();
+			}
+			else
+			{
+				/* Older layouts were all separated by steering, keep them regenerating the same. */
+				Params.Separation = SeparationMethod::Steering;
+			}
+			return Params;
+		}
+
+		void WriteCorridorRuns(ByteWriter& Writer, const std::vector<Vec3>& Tiles, double SectionLength,
+		                       std::vector<uint8_t>& Bytes)
+		{
+			const size_t CountOffset = Bytes.size();
+			Writer.U32(0);
+
+			uint32_t NumRuns = 0;
+			for (size_t First = 0; First < Tiles.size();)
+			{
+				RunAxis Axis = RunAxis::Single;
+				if (First + 1 < Tiles.size())
+				{
+					for (const RunAxis Candidate : {RunAxis::PositiveX, RunAxis::NegativeX, RunAxis::PositiveY,
+					                                RunAxis::NegativeY})
+					{
+						if (StepTile(Tiles[First], Candidate, SectionLength) == Tiles[First + 1])
+						{
+							Axis = Candidate;
+							break;
+						}
+					}
+				}
+
+				size_t Last = First;
+				while (Axis != RunAxis::Single && Last + 1 < Tiles.size() &&
+					StepTile(Tiles[Last], Axis, SectionLength) == Tiles[Last + 1])
+				{
+					++Last;
+				}
+
+				Writer.Vector3(Tiles[First]);
+				Writer.U8(static_cast<uint8_t>(Axis));
+				Writer.U32(static_cast<uint32_t>(Last - First + 1));
+				++NumRuns;
+				First = Last + 1;
+			}
+			Writer.PatchU32(CountOffset, NumRuns);
+		}
+	}
+
+	std::vector<uint8_t> WriteLayout(const SavedLayout& Saved)
+	{
+		const DungeonParams& Params = Saved.Params;
+		const DungeonLayout& Layout = Saved.Layout;
+
+		uint16_t Flags = 0;
+		for (const Cell& Current : Layout.Cells)
+		{
+			if (!CanStoreCompact(Params, Current))
+			{
+				Flags |= FlagFullPrecisionCells;
+			}
+			if (Current.Floor != 0)
+			{
+				Flags |= FlagMultiFloor;
+			}
+		}
+
+		std::vector<uint8_t> Bytes;
+		Bytes.reserve(HeaderSize + 64 + Layout.Cells.size() * 28 + Layout.Rooms.size() * 4 +
+			Layout.Edges.size() * 17 + Layout.CorridorTiles.size() * 4 + Layout.Stairs.size() * 20);
+		ByteWriter Writer{Bytes};
+
+		for (const uint8_t Byte : Magic)
+		{
+			Writer.U8(Byte);
+		}
+		Writer.U16(LayoutFormatVersion);
+		Writer.U16(Flags);
+		Writer.U32(0);
+		Writer.U32(0);
+
+		WriteParams(Writer, Params);
+		Writer.U32(Saved.Seed);
+		Writer.I32(Layout.SeparationSteps);
+
+		Writer.U32(static_cast<uint32_t>(Layout.Cells.size()));
+		for (const Cell& Current : Layout.Cells)
+		{
+			Writer.F64(Current.Location.X);
+			Writer.F64(Current.Location.Y);
+			if (Flags & FlagFullPrecisionCells)
+			{
+				Writer.Vector3(Current.Scale);
+				Writer.Vector3(Current.HalfExtent);
+				Writer.U8(Current.bIsRoom ? 1 : 0);
+			}
+			else
+			{
+				Writer.F32(static_cast<float>(Current.Scale.X));
+				Writer.F32(static_cast<float>(Current.Scale.Y));
+				Writer.F32(static_cast<float>(Current.Scale.Z));
+			}
+			if (Flags & FlagMultiFloor)
+			{
+				Writer.I32(Current.Floor);
+			}
+		}
+
+		Writer.U32(static_cast<uint32_t>(Layout.Rooms.size()));
+		for (const Room& Current : Layout.Rooms)
+		{
+			Writer.U32(static_cast<uint32_t>(Current.CellIndex));
+		}
+
+		Writer.U32(static_cast<uint32_t>(Layout.Edges.size()));
+		for (const RoomEdge& Edge : Layout.Edges)
+		{
+			Writer.U32(static_cast<uint32_t>(Edge.A));
+			Writer.U32(static_cast<uint32_t>(Edge.B));
+			Writer.F64(Edge.Weight);
+			Writer.U8(Edge.bIsLoop ? 1 : 0);
+		}
+
+		Writer.U32(static_cast<uint32_t>(Layout.CorridorTiles.size()));
+		WriteCorridorRuns(Writer, Layout.CorridorTiles, Params.SectionLength, Bytes);
+
+		Writer.U32(static_cast<uint32_t>(Layout.Stairs.size()));
+		for (const Stairwell& Stair : Layout.Stairs)
+		{
+			Writer.F64(Stair.Location.X);
+			Writer.F64(Stair.Location.Y);
+			Writer.I32(Stair.LowerFloor);
+		}
+
+		const size_t PayloadSize = Bytes.size() - HeaderSize;
+		Writer.PatchU32(8, static_cast<uint32_t>(PayloadSize));
+		Writer.PatchU32(12, HashBytes(Bytes.data() + HeaderSize, PayloadSize));
+		return Bytes;
+	}
+
+	LayoutReadResult ReadLayout(const uint8_t* Data, size_t Size, SavedLayout& Out)
+	{
+		if (!Data || Size < HeaderSize)
+		{
+			return LayoutReadResult::Truncated;
+		}
+		if (std::memcmp(Data, Magic, sizeof(Magic)) != 0)
+		{
+			return LayoutReadResult::BadMagic;
+		}
+
+		ByteReader Header{Data + sizeof(Magic), HeaderSize - sizeof(Magic)};
+		const uint16_t Version = Header.U16();
+		const uint16_t Flags = Header.U16();
+		const uint32_t PayloadSize = Header.U32();
+		const uint32_t Checksum = Header.U32();
+		if (Version == 0 || Version > LayoutFormatVersion)
+		{
+			return LayoutReadResult::UnsupportedVersion;
+		}
+		if (Size - HeaderSize < PayloadSize)
+		{
+			return LayoutReadResult::Truncated;
+		}
+		if (HashBytes(Data + HeaderSize, PayloadSize) != Checksum)
+		{
+			return LayoutReadResult::ChecksumMismatch;
+		}
+
+		ByteReader Reader{Data + HeaderSize, PayloadSize};
+		SavedLayout Saved;
+		Saved.Params = ReadParams(Reader, Version);
+		if (Saved.Params.Separation > SeparationMethod::Steering)
+		{
+			return LayoutReadResult::Corrupt;
+		}
+		Saved.Seed = Reader.U32();
+		DungeonLayout& Layout = Saved.Layout;
+		Layout.SeparationSteps = Reader.I32();
+		Layout.NumFloors = std::max(1, Saved.Params.NumFloors);
+		Layout.FloorHeight = Saved.Params.FloorHeight;
+
+		const bool bFullPrecision = (Flags & FlagFullPrecisionCells) != 0;
+		const bool bMultiFloor = (Flags & FlagMultiFloor) != 0;
+		Layout.Cells.resize(Reader.Count((bFullPrecision ? 65 : 28) + (bMultiFloor ? 4 : 0)));
+		for (Cell& Current : Layout.Cells)
+		{
+			Current.Location.X = Reader.F64();
+			Current.Location.Y = Reader.F64();
+			if (bFullPrecision)
+			{
+				Current.Scale = Reader.Vector3();
+				Current.HalfExtent = Reader.Vector3();
+				Current.bIsRoom = Reader.U8() != 0;
+			}
+			else
+			{
+				const double ScaleX = Reader.F32();
+				const double ScaleY = Reader.F32();
+				Current.Scale = {ScaleX, ScaleY, Reader.F32()};
+				Current.HalfExtent = GetHalfExtent(Saved.Params, Current.Scale);
+			}
+			if (bMultiFloor)
+			{
+				Current.Floor = Reader.I32();
+				if (Current.Floor < 0 || Current.Floor >= Layout.NumFloors)
+				{
+					return LayoutReadResult::Corrupt;
+				}
+			}
+		}
+
+		/* The room table is not stored, it is rebuilt from the cells like SelectRooms does. */
+		Layout.Rooms.resize(Reader.Count(4));
+		for (Room& Current : Layout.Rooms)
+		{
+			const uint32_t Index = Reader.U32();
+			if (Index >= Layout.Cells.size())
+			{
+				return LayoutReadResult::Corrupt;
+			}
+			Current = MakeRoom(Saved.Params, Layout, static_cast<int>(Index));
+			if (!bFullPrecision)
+			{
+				Layout.Cells[Index].bIsRoom = true;
+			}
+		}
+
+		Layout.Edges.resize(Reader.Count(17));
+		for (RoomEdge& Edge : Layout.Edges)
+		{
+			const uint32_t A = Reader.U32();
+			const uint32_t B = Reader.U32();
+			if (A >= Layout.Rooms.size() || B >= Layout.Rooms.size())
+			{
+				return LayoutReadResult::Corrupt;
+			}
+			Edge.A = static_cast<int>(A);
+			Edge.B = static_cast<int>(B);
+			Edge.Weight = Reader.F64();
+			Edge.bIsLoop = Reader.U8() != 0;
+		}
+
+		/* Tiles are counted up front so the runs can be checked against it and the vector sized once. */
+		const uint32_t NumTiles = Reader.U32();
+		const uint32_t NumRuns = Reader.Count(29);
+		if (NumTiles < NumRuns || (NumTiles > 0 && NumRuns == 0))
+		{
+			return LayoutReadResult::Corrupt;
+		}
+		Layout.CorridorTiles.reserve(NumTiles);
+		for (uint32_t Run = 0; Run < NumRuns && Reader.IsOk(); ++Run)
+		{
+			Vec3 Tile = Reader.Vector3();
+			const uint8_t Axis = Reader.U8();
+			const uint32_t Length = Reader.U32();
+			if (Axis > static_cast<uint8_t>(RunAxis::Single) || Length == 0 ||
+				Length > NumTiles - Layout.CorridorTiles.size() ||
+				(Axis == static_cast<uint8_t>(RunAxis::Single) && Length != 1))
+			{
+				return LayoutReadResult::Corrupt;
+			}
+
+			for (uint32_t InRun = 0; InRun < Length; ++InRun)
+			{
+				Layout.CorridorTiles.push_back(Tile);
+				Tile = StepTile(Tile, static_cast<RunAxis>(Axis), Saved.Params.SectionLength);
+			}
+		}
+
+		if (Version >= 2)
+		{
+			Layout.Stairs.resize(Reader.Count(20));
+			for (Stairwell& Stair : Layout.Stairs)
+			{
+				Stair.Location.X = Reader.F64();
+				Stair.Location.Y = Reader.F64();
+				Stair.LowerFloor = Reader.I32();
+				if (Stair.LowerFloor < 0 || Stair.LowerFloor + 1 >= Layout.NumFloors)
+				{
+					return LayoutReadResult::Corrupt;
+				}
+			}
+		}
+
+		if (!Reader.IsOk())
+		{
+			return LayoutReadResult::Truncated;
+		}
+		if (Layout.CorridorTiles.size() != NumTiles || Reader.Remaining() != 0)
+		{
+			return LayoutReadResult::Corrupt;
+		}
+
+		Out = std::move(Saved);
+		return LayoutReadResult::Ok;
+	}
+
+	const char* ToString(LayoutReadResult Result)
+	{
+		switch (Result)
+		{
+		case LayoutReadResult::Ok: return "Ok";
+		case LayoutReadResult::Truncated: return "Truncated";
+		case LayoutReadResult::BadMagic: return "BadMagic";
+		case LayoutReadResult::UnsupportedVersion: return "UnsupportedVersion";
+		case LayoutReadResult::ChecksumMismatch: return "ChecksumMismatch";
+		case LayoutReadResult::Corrupt: return "Corrupt";
+		}
+		return "Unknown";
+	}
+}
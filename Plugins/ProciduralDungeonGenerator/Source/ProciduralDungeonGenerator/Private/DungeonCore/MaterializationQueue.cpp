@@ -0,0 +1,106 @@
+#include "DungeonCore/MaterializationQueue.h"
+
+#include <algorithm>
+
+namespace DungeonCore
+{
+	void MaterializationQueue::Reset(const DungeonLayout& Layout, bool bIncludeFillerCells,
+	                                 const std::vector<CorridorStrip>* Strips, double SectionLength)
+	{
+		Clear();
+
+		for (int32_t CellIndex = 0; CellIndex < static_cast<int32_t>(Layout.Cells.size()); ++CellIndex)
+		{
+			const Cell& Current = Layout.Cells[CellIndex];
+			if (Current.bIsRoom || bIncludeFillerCells)
+			{
+				Cells.push_back({{LayoutItemType::Cell, CellIndex}, Current.Location, 0.});
+			}
+		}
+
+		if (Strips)
+		{
+			Corridors.reserve(Strips->size() + Layout.Stairs.size());
+			for (int32_t StripIndex = 0; StripIndex < static_cast<int32_t>(Strips->size()); ++StripIndex)
+			{
+				const Vec3 Center = (*Strips)[StripIndex].GetCenter(SectionLength);
+				Corridors.push_back({{LayoutItemType::Strip, StripIndex}, {Center.X, Center.Y}, 0.});
+			}
+		}
+		else
+		{
+			Corridors.reserve(Layout.CorridorTiles.size() + Layout.Stairs.size());
+			for (int32_t TileIndex = 0; TileIndex < static_cast<int32_t>(Layout.CorridorTiles.size()); ++TileIndex)
+			{
+				const Vec3& Tile = Layout.CorridorTiles[TileIndex];
+				Corridors.push_back({{LayoutItemType::Corridor, TileIndex}, {Tile.X, Tile.Y}, 0.});
+			}
+		}
+		for (int32_t StairIndex = 0; StairIndex < static_cast<int32_t>(Layout.Stairs.size()); ++StairIndex)
+		{
+			Corridors.push_back({{LayoutItemType::Stair, StairIndex}, Layout.Stairs[StairIndex].Location, 0.});
+		}
+
+		/* Until a focus is set keep layout order, which Pop reads from the back. */
+		std::reverse(Cells.begin(), Cells.end());
+		std::reverse(Corridors.begin(), Corridors.end());
+		Total = NumPending();
+	}
+
+	void MaterializationQueue::Clear()
+	{
+		Cells.clear();
+		Corridors.clear();
+		bHasFocus = false;
+		Total = 0;
+	}
+
+	void MaterializationQueue::SetFocus(const Vec2& Focus, double RefocusDistance)
+	{
+		if (bHasFocus && (Focus - LastFocus).SizeSquared() <= RefocusDistance * RefocusDistance)
+		{
+			return;
+		}
+
+		LastFocus = Focus;
+		bHasFocus = true;
+		SortFarthestFirst(Cells, Focus);
+		SortFarthestFirst(Corridors, Focus);
+	}
+
+	bool MaterializationQueue::Pop(LayoutItem& Item)
+	{
+		std::vector<Entry>& Source = Cells.empty() ? Corridors : Cells;
+		if (Source.empty())
+		{
+			return false;
+		}
+
+		Item = Source.back().Item;
+		Source.pop_back();
+		return true;
+	}
+
+	float MaterializationQueue::GetProgress() const
+	{
+		return Total == 0 ? 1.f : static_cast<float>(Total - NumPending()) / static_cast<float>(Total);
+	}
+
+	void MaterializationQueue::SortFarthestFirst(std::vector<Entry>& Entries, const Vec2& Focus)
+	{
+		for (Entry& Pending : Entries)
+		{
+			Pending.DistanceSquared = (Pending.Location - Focus).SizeSquared();
+		}
+
+		/* Ties go to the lower index so the order only depends on the layout and the focus. */
+		std::sort(Entries.begin(), Entries.end(), [](const Entry& A, const Entry& B)
+		{
+			if (A.DistanceSquared != B.DistanceSquared)
+			{
+				return A.DistanceSquared > B.DistanceSquared;
+			}
+			return A.Item.Index > B.Item.Index;
+		});
+	}
+}
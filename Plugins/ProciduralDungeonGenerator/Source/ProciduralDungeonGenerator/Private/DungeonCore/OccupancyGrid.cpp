@@ -0,0 +1,171 @@
+#include "DungeonCore/OccupancyGrid.h"
+
+namespace DungeonCore
+{
+	void OccupancyGrid::Init(const DungeonLayout& Layout, double InCellSize)
+	{
+		Reset(InCellSize);
+		AddRooms(Layout);
+	}
+
+	void OccupancyGrid::Reset(double InCellSize)
+	{
+		InvCellSize = InCellSize > 0. ? 1. / InCellSize : 1.;
+		RoomHeads.clear();
+		TileHeads.clear();
+		RoomLinks.clear();
+		TileLinks.clear();
+		RoomBounds.clear();
+		Tiles.clear();
+	}
+
+	void OccupancyGrid::AddRooms(const DungeonLayout& Layout)
+	{
+		RoomBounds.reserve(RoomBounds.size() + Layout.Rooms.size());
+		for (const Room& Current : Layout.Rooms)
+		{
+			AddRoom(Current.Bounds);
+		}
+	}
+
+	void OccupancyGrid::AddRooms(const DungeonLayout& Layout, int Floor)
+	{
+		for (const Room& Current : Layout.Rooms)
+		{
+			if (Current.Floor == Floor)
+			{
+				AddRoom(Current.Bounds);
+			}
+		}
+	}
+
+	int32_t OccupancyGrid::AddRoom(const Bounds2D& Bounds)
+	{
+		const int32_t RoomId = static_cast<int32_t>(RoomBounds.size());
+		RoomBounds.push_back(Bounds);
+
+		/* Every grid cell touched by the room bounds, a point strictly inside the room lands in one of them. */
+		const int32_t MinX = ToGrid(Bounds.Origin.X - Bounds.Extent.X);
+		const int32_t MaxX = ToGrid(Bounds.Origin.X + Bounds.Extent.X);
+		const int32_t MinY = ToGrid(Bounds.Origin.Y - Bounds.Extent.Y);
+		const int32_t MaxY = ToGrid(Bounds.Origin.Y + Bounds.Extent.Y);
+		for (int32_t GridY = MinY; GridY <= MaxY; ++GridY)
+		{
+			for (int32_t GridX = MinX; GridX <= MaxX; ++GridX)
+			{
+				auto Head = RoomHeads.try_emplace(MakeKey(GridX, GridY), -1).first;
+				RoomLinks.push_back({RoomId, Head->second});
+				Head->second = static_cast<int32_t>(RoomLinks.size()) - 1;
+			}
+		}
+		return RoomId;
+	}
+
+	void OccupancyGrid::RemoveRoom(int32_t RoomId)
+	{
+		if (RoomId < 0 || RoomId >= static_cast<int32_t>(RoomBounds.size()))
+		{
+			return;
+		}
+
+		const Bounds2D& Bounds = RoomBounds[RoomId];
+		const int32_t MinX = ToGrid(Bounds.Origin.X - Bounds.Extent.X);
+		const int32_t MaxX = ToGrid(Bounds.Origin.X + Bounds.Extent.X);
+		const int32_t MinY = ToGrid(Bounds.Origin.Y - Bounds.Extent.Y);
+		const int32_t MaxY = ToGrid(Bounds.Origin.Y + Bounds.Extent.Y);
+		for (int32_t GridY = MinY; GridY <= MaxY; ++GridY)
+		{
+			for (int32_t GridX = MinX; GridX <= MaxX; ++GridX)
+			{
+				Unlink(RoomHeads, RoomLinks, MakeKey(GridX, GridY), [RoomId](int32_t Item) { return Item == RoomId; });
+			}
+		}
+
+		/* Zero extent overlaps nothing, removing the same id again finds no links. */
+		RoomBounds[RoomId] = {};
+	}
+
+	bool OccupancyGrid::RemoveTile(const Vec3& Tile)
+	{
+		return Unlink(TileHeads, TileLinks, KeyOf(Tile.X, Tile.Y), [this, &Tile](int32_t Item) { return Tiles[Item] == Tile; });
+	}
+
+	bool OccupancyGrid::Unlink(std::unordered_map<uint64_t, int32_t>& Heads, std::vector<Link>& Links, uint64_t Key,
+	                           const std::function<bool(int32_t)>& IsItem)
+	{
+		const auto Head = Heads.find(Key);
+		if (Head == Heads.end())
+		{
+			return false;
+		}
+
+		for (int32_t* LinkIndex = &Head->second; *LinkIndex != -1; LinkIndex = &Links[*LinkIndex].Next)
+		{
+			if (IsItem(Links[*LinkIndex].Item))
+			{
+				*LinkIndex = Links[*LinkIndex].Next;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool OccupancyGrid::IsInsideRoom(const Vec2& Loc) const
+	{
+		const auto Head = RoomHeads.find(KeyOf(Loc.X, Loc.Y));
+		if (Head == RoomHeads.end())
+		{
+			return false;
+		}
+
+		for (int32_t LinkIndex = Head->second; LinkIndex != -1; LinkIndex = RoomLinks[LinkIndex].Next)
+		{
+			if (RoomBounds[RoomLinks[LinkIndex].Item].Overlap(Loc))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	size_t OccupancyGrid::GetAllocatedBytes() const
+	{
+		constexpr size_t NodeBytes = sizeof(std::pair<const uint64_t, int32_t>) + 2 * sizeof(void*);
+		const size_t MapBytes = (RoomHeads.size() + TileHeads.size()) * NodeBytes +
+			(RoomHeads.bucket_count() + TileHeads.bucket_count()) * sizeof(void*);
+		return MapBytes + DungeonCore::GetAllocatedBytes(RoomLinks) + DungeonCore::GetAllocatedBytes(TileLinks) +
+			DungeonCore::GetAllocatedBytes(RoomBounds) + DungeonCore::GetAllocatedBytes(Tiles);
+	}
+
+	bool OccupancyGrid::HasTile(const Vec3& Tile) const
+	{
+		const auto Head = TileHeads.find(KeyOf(Tile.X, Tile.Y));
+		if (Head == TileHeads.end())
+		{
+			return false;
+		}
+
+		for (int32_t LinkIndex = Head->second; LinkIndex != -1; LinkIndex = TileLinks[LinkIndex].Next)
+		{
+			if (Tiles[TileLinks[LinkIndex].Item] == Tile)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool OccupancyGrid::AddTile(const Vec3& Tile)
+	{
+		if (HasTile(Tile))
+		{
+			return false;
+		}
+
+		auto Head = TileHeads.try_emplace(KeyOf(Tile.X, Tile.Y), -1).first;
+		Tiles.push_back(Tile);
+		TileLinks.push_back({static_cast<int32_t>(Tiles.size()) - 1, Head->second});
+		Head->second = static_cast<int32_t>(TileLinks.size()) - 1;
+		return true;
+	}
+}
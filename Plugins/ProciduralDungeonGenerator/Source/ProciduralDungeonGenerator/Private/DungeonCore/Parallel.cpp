@@ -0,0 +1,175 @@
+#include "DungeonCore/Parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DungeonCore
+{
+	namespace
+	{
+		std::atomic<ParallelExecutor> CurrentExecutor{&ThreadParallelExecutor};
+
+		/* Live ScopedSerialParallelFor on this thread. */
+		thread_local int32_t SerialDepth = 0;
+
+		/*
+		 * Threads started once and kept waiting for work, so a loop only pays for waking them. Every call
+		 * queues a job its caller works on as well, which keeps nested and concurrent calls from waiting on
+		 * workers that are all busy.
+		 */
+		class WorkerPool
+		{
+		public:
+			explicit WorkerPool(int32_t NumWorkers)
+			{
+				Workers.reserve(NumWorkers);
+				for (int32_t Worker = 0; Worker < NumWorkers; ++Worker)
+				{
+					Workers.emplace_back([this] { WorkerLoop(); });
+				}
+			}
+
+			int32_t GetNumWorkers() const { return static_cast<int32_t>(Workers.size()); }
+
+			void Run(int32_t NumChunks, const std::function<void(int32_t)>& Chunk)
+			{
+				Job Current{Chunk, NumChunks};
+				{
+					std::lock_guard<std::mutex> Lock{Mutex};
+					Jobs.push_back(&Current);
+				}
+				const int32_t NumWake = std::min(NumChunks - 1, GetNumWorkers());
+				for (int32_t Worker = 0; Worker < NumWake; ++Worker)
+				{
+					WorkReady.notify_one();
+				}
+
+				Current.Work();
+
+				/* Every chunk is claimed, wait for the workers still running one before Current goes away. */
+				std::unique_lock<std::mutex> Lock{Mutex};
+				Remove(&Current);
+				JobDone.wait(Lock, [&Current] { return Current.NumUsers == 0; });
+			}
+
+		private:
+			struct Job
+			{
+				const std::function<void(int32_t)>& Chunk;
+				int32_t NumChunks;
+				std::atomic<int32_t> NextChunk{0};
+
+				/* Workers holding the job, guarded by Mutex. */
+				int32_t NumUsers = 0;
+
+				void Work()
+				{
+					for (int32_t Index = NextChunk++; Index < NumChunks; Index = NextChunk++)
+					{
+						Chunk(Index);
+					}
+				}
+			};
+
+			void WorkerLoop()
+			{
+				std::unique_lock<std::mutex> Lock{Mutex};
+				while (true)
+				{
+					WorkReady.wait(Lock, [this] { return !Jobs.empty(); });
+					Job* Current = Jobs.front();
+					++Current->NumUsers;
+					Lock.unlock();
+					Current->Work();
+					Lock.lock();
+
+					/* Out of chunks, later workers should not pick it up again. */
+					Remove(Current);
+					if (--Current->NumUsers == 0)
+					{
+						JobDone.notify_all();
+					}
+				}
+			}
+
+			void Remove(Job* Done)
+			{
+				const auto Found = std::find(Jobs.begin(), Jobs.end(), Done);
+				if (Found != Jobs.end())
+				{
+					Jobs.erase(Found);
+				}
+			}
+
+			std::mutex Mutex;
+			std::condition_variable WorkReady;
+			std::condition_variable JobDone;
+			std::deque<Job*> Jobs;
+			std::vector<std::thread> Workers;
+		};
+
+		WorkerPool& GetWorkerPool()
+		{
+			/* Never destroyed, joining threads from a static destructor can hang while the process exits. */
+			static WorkerPool* Pool = new WorkerPool{static_cast<int32_t>(std::max(1u, std::thread::hardware_concurrency())) - 1};
+			return *Pool;
+		}
+	}
+
+	void SetParallelExecutor(ParallelExecutor Executor)
+	{
+		CurrentExecutor = Executor;
+	}
+
+	ParallelExecutor GetParallelExecutor()
+	{
+		return CurrentExecutor;
+	}
+
+	void ThreadParallelExecutor(int32_t NumChunks, const std::function<void(int32_t)>& Chunk)
+	{
+		GetWorkerPool().Run(NumChunks, Chunk);
+	}
+
+	void ParallelForRange(int32_t Num, int32_t ChunkSize, const std::function<void(int32_t, int32_t)>& Body)
+	{
+		if (Num <= 0)
+		{
+			return;
+		}
+
+		ChunkSize = std::max(ChunkSize, 1);
+		const int32_t NumChunks = (Num + ChunkSize - 1) / ChunkSize;
+		const auto RunChunk = [&](int32_t Chunk)
+		{
+			const int32_t Begin = Chunk * ChunkSize;
+			Body(Begin, std::min(Begin + ChunkSize, Num));
+		};
+
+		const ParallelExecutor Executor = CurrentExecutor;
+		if (NumChunks == 1 || !Executor || SerialDepth > 0)
+		{
+			for (int32_t Chunk = 0; Chunk < NumChunks; ++Chunk)
+			{
+				RunChunk(Chunk);
+			}
+			return;
+		}
+		Executor(NumChunks, RunChunk);
+	}
+
+	ScopedSerialParallelFor::ScopedSerialParallelFor()
+	{
+		++SerialDepth;
+	}
+
+	ScopedSerialParallelFor::~ScopedSerialParallelFor()
+	{
+		--SerialDepth;
+	}
+}
@@ -0,0 +1,290 @@
+#include "DungeonCore/RoomNavigator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace DungeonCore
+{
+	namespace
+	{
+		constexpr double Unreachable = std::numeric_limits<double>::infinity();
+
+		/* Distance from Pos to the nearest point of Bounds, 0 inside. */
+		double DistanceToBounds(const Bounds2D& Bounds, const Vec2& Pos)
+		{
+			const double OutX = std::max(0., std::abs(Pos.X - Bounds.Origin.X) - Bounds.Extent.X);
+			const double OutY = std::max(0., std::abs(Pos.Y - Bounds.Origin.Y) - Bounds.Extent.Y);
+			return std::hypot(OutX, OutY);
+		}
+	}
+
+	void RoomNavigator::Init(const DungeonLayout& Layout, size_t InMaxCachedTargets)
+	{
+		Reset();
+		Rooms = Layout.Rooms;
+		Stairs = Layout.Stairs;
+		FloorHeight = Layout.FloorHeight;
+		MaxCachedTargets = std::max<size_t>(1, InMaxCachedTargets);
+
+		/* Both directions of every edge, bucketed by room. */
+		LinkStart.assign(Rooms.size() + 1, 0);
+		for (const RoomEdge& Edge : Layout.Edges)
+		{
+			++LinkStart[Edge.A + 1];
+			++LinkStart[Edge.B + 1];
+		}
+		for (size_t RoomIndex = 0; RoomIndex < Rooms.size(); ++RoomIndex)
+		{
+			LinkStart[RoomIndex + 1] += LinkStart[RoomIndex];
+		}
+		Links.resize(LinkStart.back());
+		std::vector<int32_t> Cursor(LinkStart.begin(), LinkStart.end() - 1);
+		for (const RoomEdge& Edge : Layout.Edges)
+		{
+			const int32_t Stair = Rooms[Edge.A].Floor != Rooms[Edge.B].Floor ? FindStair(Edge.A, Edge.B) : -1;
+			Links[Cursor[Edge.A]++] = {Edge.B, Stair, Edge.Weight};
+			Links[Cursor[Edge.B]++] = {Edge.A, Stair, Edge.Weight};
+		}
+
+		std::vector<Vec2> Centers(Rooms.size());
+		std::vector<int32_t> Floors(Rooms.size());
+		double Reach = 0.;
+		for (size_t RoomIndex = 0; RoomIndex < Rooms.size(); ++RoomIndex)
+		{
+			Centers[RoomIndex] = Rooms[RoomIndex].GetCenter();
+			Floors[RoomIndex] = Rooms[RoomIndex].Floor;
+			Reach = std::max(Reach, Rooms[RoomIndex].GetHalfExtent().Size());
+		}
+		RoomGrid.Build(Centers, Reach + 1., &Floors);
+	}
+
+	void RoomNavigator::Reset()
+	{
+		Rooms.clear();
+		Stairs.clear();
+		LinkStart.clear();
+		Links.clear();
+		RoomGrid = SpatialGrid();
+		Fields.clear();
+		UseCounter = 0;
+	}
+
+	int RoomNavigator::GetFloorAt(double Z) const
+	{
+		return FloorHeight > 0. ? static_cast<int>(std::floor(Z / FloorHeight)) : 0;
+	}
+
+	int32_t RoomNavigator::FindRoom(const Vec2& Location, int Floor) const
+	{
+		int32_t Found = -1;
+		RoomGrid.ForEachNear(Location, Floor, [&](int32_t RoomIndex)
+		{
+			/* Lowest index wins where rooms overlap, as a scan in room order would find. */
+			if ((Found < 0 || RoomIndex < Found) && Rooms[RoomIndex].Bounds.Overlap(Location))
+			{
+				Found = RoomIndex;
+			}
+		});
+		if (Found >= 0)
+		{
+			return Found;
+		}
+
+		/* Off the rooms, in a corridor or outside the dungeon, a rare case a plain scan is good enough for. */
+		double BestDistance = Unreachable;
+		for (int32_t RoomIndex = 0; RoomIndex < GetNumRooms(); ++RoomIndex)
+		{
+			if (Rooms[RoomIndex].Floor != Floor)
+			{
+				continue;
+			}
+			const double Distance = DistanceToBounds(Rooms[RoomIndex].Bounds, Location);
+			if (Distance < BestDistance)
+			{
+				BestDistance = Distance;
+				Found = RoomIndex;
+			}
+		}
+		return Found;
+	}
+
+	double RoomNavigator::GetDistance(int32_t From, int32_t To)
+	{
+		if (From < 0 || From >= GetNumRooms() || To < 0 || To >= GetNumRooms())
+		{
+			return -1.;
+		}
+		const double Distance = GetField(To)[From];
+		return Distance == Unreachable ? -1. : Distance;
+	}
+
+	bool RoomNavigator::FindRoomPath(int32_t From, int32_t To, std::vector<int32_t>& OutRooms)
+	{
+		OutRooms.clear();
+		if (GetDistance(From, To) < 0.)
+		{
+			return false;
+		}
+
+		/* Downhill on the target's field, every room on a shortest walk is exactly its next link closer. */
+		const std::vector<double>& Distances = GetField(To);
+		OutRooms.push_back(From);
+		int32_t Current = From;
+		while (Current != To)
+		{
+			int32_t Next = -1;
+			double BestDistance = Distances[Current];
+			for (int32_t LinkIndex = LinkStart[Current]; LinkIndex < LinkStart[Current + 1]; ++LinkIndex)
+			{
+				const Link& Neighbour = Links[LinkIndex];
+				const double Distance = Neighbour.Weight + Distances[Neighbour.Room];
+				if (Distances[Neighbour.Room] < Distances[Current] && (Next < 0 || Distance < BestDistance))
+				{
+					Next = Neighbour.Room;
+					BestDistance = Distance;
+				}
+			}
+			if (Next < 0)
+			{
+				OutRooms.clear();
+				return false;
+			}
+			OutRooms.push_back(Next);
+			Current = Next;
+		}
+		return true;
+	}
+
+	bool RoomNavigator::FindWaypoints(const Vec3& Start, const Vec3& End, std::vector<Vec3>& OutWaypoints)
+	{
+		OutWaypoints.clear();
+		const int32_t From = FindRoom({Start.X, Start.Y}, GetFloorAt(Start.Z));
+		const int32_t To = FindRoom({End.X, End.Y}, GetFloorAt(End.Z));
+		std::vector<int32_t> Path;
+		if (!FindRoomPath(From, To, Path))
+		{
+			return false;
+		}
+
+		for (size_t Hop = 1; Hop < Path.size(); ++Hop)
+		{
+			const Room& Previous = Rooms[Path[Hop - 1]];
+			const Room& Current = Rooms[Path[Hop]];
+			if (Previous.Floor != Current.Floor)
+			{
+				/* Any link between the two will do, they all lead through a stairwell. */
+				for (int32_t LinkIndex = LinkStart[Path[Hop - 1]]; LinkIndex < LinkStart[Path[Hop - 1] + 1]; ++LinkIndex)
+				{
+					if (Links[LinkIndex].Room == Path[Hop] && Links[LinkIndex].Stair >= 0)
+					{
+						const Vec2& Stair = Stairs[Links[LinkIndex].Stair].Location;
+						OutWaypoints.push_back({Stair.X, Stair.Y, Previous.Floor * FloorHeight});
+						OutWaypoints.push_back({Stair.X, Stair.Y, Current.Floor * FloorHeight});
+						break;
+					}
+				}
+			}
+			if (Hop + 1 < Path.size())
+			{
+				OutWaypoints.push_back({Current.GetCenter().X, Current.GetCenter().Y, Current.Floor * FloorHeight});
+			}
+		}
+		OutWaypoints.push_back(End);
+		return true;
+	}
+
+	size_t RoomNavigator::GetAllocatedBytes() const
+	{
+		size_t Bytes = DungeonCore::GetAllocatedBytes(Rooms) + DungeonCore::GetAllocatedBytes(Stairs) +
+			DungeonCore::GetAllocatedBytes(LinkStart) + DungeonCore::GetAllocatedBytes(Links) +
+			DungeonCore::GetAllocatedBytes(Fields) + RoomGrid.GetAllocatedBytes();
+		for (const DistanceField& Field : Fields)
+		{
+			Bytes += DungeonCore::GetAllocatedBytes(Field.Distances);
+		}
+		return Bytes;
+	}
+
+	const std::vector<double>& RoomNavigator::GetField(int32_t Target)
+	{
+		for (DistanceField& Field : Fields)
+		{
+			if (Field.Target == Target)
+			{
+				Field.LastUsed = ++UseCounter;
+				return Field.Distances;
+			}
+		}
+
+		/* Reuse the least recently used field's storage once the cache is full. */
+		DistanceField* Field = nullptr;
+		if (Fields.size() < MaxCachedTargets)
+		{
+			Field = &Fields.emplace_back();
+		}
+		else
+		{
+			Field = &*std::min_element(Fields.begin(), Fields.end(), [](const DistanceField& A, const DistanceField& B)
+			{
+				return A.LastUsed < B.LastUsed;
+			});
+		}
+		Field->Target = Target;
+		Field->LastUsed = ++UseCounter;
+
+		/* Edges are undirected, distances to Target are distances from it. */
+		std::vector<double>& Distances = Field->Distances;
+		Distances.assign(Rooms.size(), Unreachable);
+		using QueueEntry = std::pair<double, int32_t>;
+		std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> Open;
+		Distances[Target] = 0.;
+		Open.push({0., Target});
+		while (!Open.empty())
+		{
+			const auto [Distance, Current] = Open.top();
+			Open.pop();
+			if (Distance > Distances[Current])
+			{
+				continue;
+			}
+			for (int32_t LinkIndex = LinkStart[Current]; LinkIndex < LinkStart[Current + 1]; ++LinkIndex)
+			{
+				const Link& Neighbour = Links[LinkIndex];
+				const double NewDistance = Distance + Neighbour.Weight;
+				if (NewDistance < Distances[Neighbour.Room])
+				{
+					Distances[Neighbour.Room] = NewDistance;
+					Open.push({NewDistance, Neighbour.Room});
+				}
+			}
+		}
+		return Distances;
+	}
+
+	int32_t RoomNavigator::FindStair(int32_t A, int32_t B) const
+	{
+		const Room& Lower = Rooms[A].Floor < Rooms[B].Floor ? Rooms[A] : Rooms[B];
+		const Room& Upper = Rooms[A].Floor < Rooms[B].Floor ? Rooms[B] : Rooms[A];
+		int32_t Best = -1;
+		double BestDistance = Unreachable;
+		for (int32_t StairIndex = 0; StairIndex < static_cast<int32_t>(Stairs.size()); ++StairIndex)
+		{
+			const Stairwell& Stair = Stairs[StairIndex];
+			if (Stair.LowerFloor != Lower.Floor)
+			{
+				continue;
+			}
+			const double Distance = DistanceToBounds(Lower.Bounds, Stair.Location) + DistanceToBounds(Upper.Bounds, Stair.Location);
+			if (Distance < BestDistance)
+			{
+				BestDistance = Distance;
+				Best = StairIndex;
+			}
+		}
+		return Best;
+	}
+}
@@ -0,0 +1,340 @@
+#include "DungeonCore/SectorStreaming.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <tuple>
+
+#include "DungeonCore/CorridorRouter.h"
+#include "DungeonCore/OccupancyGrid.h"
+#include "DungeonTrace.h"
+
+namespace DungeonCore
+{
+	namespace
+	{
+		void RunSectorStages(const SectorParams& Params, const SectorCoord& Coord, GenerationProgress* Progress,
+		                     DungeonLayout& Layout)
+		{
+			/* Same stage order and streams as GenerateLayout, with the sector seed and the room clipping added. */
+			const uint32_t Seed = GetSectorSeed(Params.WorldSeed, Coord);
+			const auto StageRng = [Seed](RandomStage Stage)
+			{
+				return RandomEngine{Seed, static_cast<uint64_t>(Stage)};
+			};
+			const auto Cancelled = [Progress]
+			{
+				return Progress && Progress->IsCancelled();
+			};
+
+			RandomEngine SpawnRng = StageRng(RandomStage::SpawnCells);
+			SpawnCells(Params.Layout, SpawnRng, Layout);
+			SeparateCells(Params.Layout, Layout, Progress);
+			if (Cancelled())
+			{
+				return;
+			}
+
+			const Vec2 Center = GetSectorCenter(Params.SectorSize, Coord);
+			for (Cell& Current : Layout.Cells)
+			{
+				Current.Location += Center;
+			}
+
+			RandomEngine RoomRng = StageRng(RandomStage::SelectRooms);
+			SelectRooms(Params.Layout, RoomRng, Layout);
+
+			const double HalfSize = Params.SectorSize / 2.;
+			const auto Inside = [&](const Room& Current)
+			{
+				const Bounds2D& Bounds = Current.Bounds;
+				return std::abs(Bounds.Origin.X - Center.X) + Bounds.Extent.X <= HalfSize &&
+					std::abs(Bounds.Origin.Y - Center.Y) + Bounds.Extent.Y <= HalfSize;
+			};
+			const auto FirstOutside = std::stable_partition(Layout.Rooms.begin(), Layout.Rooms.end(), Inside);
+			for (auto Outside = FirstOutside; Outside != Layout.Rooms.end(); ++Outside)
+			{
+				Layout.Cells[Outside->CellIndex].bIsRoom = false;
+			}
+			Layout.Rooms.erase(FirstOutside, Layout.Rooms.end());
+
+			RandomEngine ConnectRng = StageRng(RandomStage::ConnectRooms);
+			ConnectRooms(ConnectRng, Layout);
+			if (Cancelled())
+			{
+				return;
+			}
+
+			BuildCorridors(Params.Layout, Layout);
+			if (Progress)
+			{
+				Progress->Set(1.f);
+			}
+		}
+	}
+
+	uint32_t GetSectorSeed(uint32_t WorldSeed, const SectorCoord& Coord)
+	{
+		/* SplitMix64 finalizer over the packed inputs, neighbouring coordinates end up far apart. */
+		uint64_t Hash = static_cast<uint64_t>(WorldSeed) * 0x9E3779B97F4A7C15ull;
+		Hash ^= static_cast<uint64_t>(static_cast<uint32_t>(Coord.X)) << 32 | static_cast<uint32_t>(Coord.Y);
+		Hash = (Hash ^ (Hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+		Hash = (Hash ^ (Hash >> 27)) * 0x94D049BB133111EBull;
+		Hash ^= Hash >> 31;
+		return static_cast<uint32_t>(Hash >> 32);
+	}
+
+	SectorCoord GetSectorAt(double SectorSize, const Vec2& Location)
+	{
+		return {static_cast<int32_t>(std::floor(Location.X / SectorSize + 0.5)),
+		        static_cast<int32_t>(std::floor(Location.Y / SectorSize + 0.5))};
+	}
+
+	Vec2 GetSectorCenter(double SectorSize, const SectorCoord& Coord)
+	{
+		return {Coord.X * SectorSize, Coord.Y * SectorSize};
+	}
+
+	DungeonLayout GenerateSectorLayout(const SectorParams& Params, const SectorCoord& Coord, GenerationProgress* Progress)
+	{
+		DUNGEONCORE_TRACE_SCOPE(DungeonGenerateSectorLayout);
+		DungeonLayout Layout;
+		{
+			ScopedStageTimer Timer{Layout.Stats.TotalMs};
+			RunSectorStages(Params, Coord, Progress, Layout);
+		}
+		return Layout;
+	}
+
+	std::vector<Vec3> BuildSectorStitch(const SectorParams& Params, const DungeonLayout& A, const DungeonLayout& B)
+	{
+		std::vector<Vec3> Tiles;
+		if (A.Rooms.empty() || B.Rooms.empty())
+		{
+			return Tiles;
+		}
+
+		/* Closest room pair on a shared floor, lowest indices on ties, so both sides would pick the same one. */
+		int BestA = -1;
+		int BestB = -1;
+		double BestDistance = 0.;
+		for (int RoomA = 0; RoomA < static_cast<int>(A.Rooms.size()); ++RoomA)
+		{
+			for (int RoomB = 0; RoomB < static_cast<int>(B.Rooms.size()); ++RoomB)
+			{
+				if (A.GetRoom(RoomA).Floor != B.GetRoom(RoomB).Floor)
+				{
+					continue;
+				}
+				const double Distance = (A.GetRoom(RoomA).GetCenter() - B.GetRoom(RoomB).GetCenter()).SizeSquared();
+				if (BestA < 0 || Distance < BestDistance)
+				{
+					BestDistance = Distance;
+					BestA = RoomA;
+					BestB = RoomB;
+				}
+			}
+		}
+
+		if (BestA < 0)
+		{
+			return Tiles;
+		}
+
+		/* A's own tiles are registered so the stitch only adds new ones. */
+		const int Floor = A.GetRoom(BestA).Floor;
+		OccupancyGrid Occupancy;
+		Occupancy.Reset(Params.Layout.SectionLength);
+		Occupancy.AddRooms(A, Floor);
+		Occupancy.AddRooms(B, Floor);
+		for (const Vec3& Tile : A.CorridorTiles)
+		{
+			Occupancy.AddTile(Tile);
+		}
+
+		CorridorRouter Router;
+		Router.Reset(Params.Layout.SectionLength);
+		RouteCorridor(A.GetRoom(BestA).Bounds, B.GetRoom(BestB).Bounds, GetCorridorZ(A, Floor),
+		              Params.Layout.SectionLength, Router, Occupancy, Tiles);
+		return Tiles;
+	}
+
+	void SectorStreamer::Init(const SectorParams& InParams, int32_t InActiveRadius)
+	{
+		Params = InParams;
+		ActiveRadius = std::max(0, InActiveRadius);
+		Reset();
+	}
+
+	void SectorStreamer::Reset()
+	{
+		Sectors.clear();
+		FocusSector = {};
+		bHasFocus = false;
+	}
+
+	void SectorStreamer::Update(const Vec2& Focus, std::vector<SectorCoord>& OutReleased)
+	{
+		const SectorCoord NewFocus = GetSectorAt(Params.SectorSize, Focus);
+		if (bHasFocus && NewFocus == FocusSector)
+		{
+			return;
+		}
+		FocusSector = NewFocus;
+		bHasFocus = true;
+
+		for (auto It = Sectors.begin(); It != Sectors.end();)
+		{
+			SectorState& State = It->second;
+			const bool bActive = IsActive(It->first);
+			if (State.bActive && !bActive)
+			{
+				OutReleased.push_back(It->first);
+				State.bReported = false;
+			}
+			State.bActive = bActive;
+
+			if (IsNeeded(It->first))
+			{
+				++It;
+			}
+			else
+			{
+				It = Sectors.erase(It);
+			}
+		}
+
+		/* One extra column and row for the east and north neighbours of the active block. */
+		for (int32_t Y = FocusSector.Y - ActiveRadius; Y <= FocusSector.Y + ActiveRadius + 1; ++Y)
+		{
+			for (int32_t X = FocusSector.X - ActiveRadius; X <= FocusSector.X + ActiveRadius + 1; ++X)
+			{
+				const SectorCoord Coord{X, Y};
+				if (IsNeeded(Coord))
+				{
+					Sectors[Coord].bActive = IsActive(Coord);
+				}
+			}
+		}
+
+		for (auto& Entry : Sectors)
+		{
+			TryStitch(Entry.first);
+		}
+	}
+
+	std::vector<SectorCoord> SectorStreamer::GetMissingLayouts() const
+	{
+		std::vector<SectorCoord> Missing;
+		for (const auto& Entry : Sectors)
+		{
+			if (!Entry.second.bHasLayout)
+			{
+				Missing.push_back(Entry.first);
+			}
+		}
+		SortNearestFirst(Missing);
+		return Missing;
+	}
+
+	void SectorStreamer::ProvideLayout(const SectorCoord& Coord, DungeonLayout&& Layout)
+	{
+		const auto Found = Sectors.find(Coord);
+		if (Found == Sectors.end() || Found->second.bHasLayout)
+		{
+			return;
+		}
+		Found->second.Layout = std::move(Layout);
+		Found->second.bHasLayout = true;
+
+		/* This sector may complete itself or the sectors west and south of it, which stitch towards it. */
+		TryStitch(Coord);
+		TryStitch({Coord.X - 1, Coord.Y});
+		TryStitch({Coord.X, Coord.Y - 1});
+	}
+
+	std::vector<SectorCoord> SectorStreamer::TakeReadySectors()
+	{
+		std::vector<SectorCoord> Ready;
+		for (auto& Entry : Sectors)
+		{
+			SectorState& State = Entry.second;
+			if (State.bActive && State.bStitched && !State.bReported)
+			{
+				State.bReported = true;
+				Ready.push_back(Entry.first);
+			}
+		}
+		SortNearestFirst(Ready);
+		return Ready;
+	}
+
+	const DungeonLayout* SectorStreamer::GetReadyLayout(const SectorCoord& Coord) const
+	{
+		const auto Found = Sectors.find(Coord);
+		if (Found == Sectors.end() || !Found->second.bActive || !Found->second.bStitched)
+		{
+			return nullptr;
+		}
+		return &Found->second.Layout;
+	}
+
+	bool SectorStreamer::IsActive(const SectorCoord& Coord) const
+	{
+		return bHasFocus && std::abs(Coord.X - FocusSector.X) <= ActiveRadius &&
+			std::abs(Coord.Y - FocusSector.Y) <= ActiveRadius;
+	}
+
+	size_t SectorStreamer::NumActive() const
+	{
+		size_t NumActiveSectors = 0;
+		for (const auto& Entry : Sectors)
+		{
+			NumActiveSectors += Entry.second.bActive ? 1 : 0;
+		}
+		return NumActiveSectors;
+	}
+
+	bool SectorStreamer::IsNeeded(const SectorCoord& Coord) const
+	{
+		return IsActive(Coord) || IsActive({Coord.X - 1, Coord.Y}) || IsActive({Coord.X, Coord.Y - 1});
+	}
+
+	void SectorStreamer::TryStitch(const SectorCoord& Coord)
+	{
+		const auto Found = Sectors.find(Coord);
+		if (Found == Sectors.end() || !Found->second.bActive || !Found->second.bHasLayout || Found->second.bStitched)
+		{
+			return;
+		}
+
+		const auto East = Sectors.find({Coord.X + 1, Coord.Y});
+		const auto North = Sectors.find({Coord.X, Coord.Y + 1});
+		if (East == Sectors.end() || !East->second.bHasLayout || North == Sectors.end() || !North->second.bHasLayout)
+		{
+			return;
+		}
+
+		DungeonLayout& Layout = Found->second.Layout;
+		for (const DungeonLayout* Neighbour : {&East->second.Layout, &North->second.Layout})
+		{
+			const std::vector<Vec3> Stitch = BuildSectorStitch(Params, Layout, *Neighbour);
+			Layout.CorridorTiles.insert(Layout.CorridorTiles.end(), Stitch.begin(), Stitch.end());
+		}
+		Found->second.bStitched = true;
+	}
+
+	void SectorStreamer::SortNearestFirst(std::vector<SectorCoord>& Coords) const
+	{
+		const auto Key = [this](const SectorCoord& Coord)
+		{
+			const int32_t DeltaX = Coord.X - FocusSector.X;
+			const int32_t DeltaY = Coord.Y - FocusSector.Y;
+			return std::make_tuple(DeltaX * DeltaX + DeltaY * DeltaY, Coord.Y, Coord.X);
+		};
+		std::sort(Coords.begin(), Coords.end(), [&](const SectorCoord& A, const SectorCoord& B)
+		{
+			return Key(A) < Key(B);
+		});
+	}
+}
@@ -0,0 +1,238 @@
+#include "DungeonCore/SeparationSolver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include "DungeonCore/Parallel.h"
+
+namespace DungeonCore
+{
+	namespace
+	{
+		constexpr double SeparationStepLength = 100.;
+		constexpr int32_t CellsPerTask = 256;
+	}
+
+	void SeparationSolver::Init(const std::vector<Cell>& Cells, const SeparationSettings& InSettings)
+	{
+		Settings = InSettings;
+		Result = SeparationResult();
+		bDone = false;
+		PairReach = 0.;
+		Positions.resize(Cells.size());
+		Extents.resize(Cells.size());
+		ExtentSizes.resize(Cells.size());
+		Floors.resize(Cells.size());
+		Forces.assign(Cells.size(), Vec2());
+		Penetrations.assign(Cells.size(), 0.);
+		for (size_t CellIndex = 0; CellIndex < Cells.size(); ++CellIndex)
+		{
+			Positions[CellIndex] = Cells[CellIndex].Location;
+			Extents[CellIndex] = {Cells[CellIndex].HalfExtent.X, Cells[CellIndex].HalfExtent.Y};
+			ExtentSizes[CellIndex] = Cells[CellIndex].HalfExtent.Size();
+			Floors[CellIndex] = Cells[CellIndex].Floor;
+			PairReach = std::max({PairReach, 2. * Extents[CellIndex].X, 2. * Extents[CellIndex].Y});
+		}
+	}
+
+	void SeparationSolver::Init(const std::vector<Cell>& Cells, float InMinDistance)
+	{
+		SeparationSettings Steering;
+		Steering.Method = SeparationMethod::Steering;
+		Steering.MinDistance = InMinDistance;
+		Steering.MaxIterations = std::numeric_limits<int32_t>::max();
+		Init(Cells, Steering);
+	}
+
+	bool SeparationSolver::Step()
+	{
+		const bool bMoved = Settings.Method == SeparationMethod::Steering ? StepSteering() : StepPenetration();
+		if (bMoved)
+		{
+			++Result.Iterations;
+		}
+		else
+		{
+			bDone = true;
+			Result.bConverged = true;
+		}
+		return bMoved;
+	}
+
+	const SeparationResult& SeparationSolver::Solve(double BudgetMs)
+	{
+		const auto Start = std::chrono::steady_clock::now();
+		while (!bDone)
+		{
+			if (Result.Iterations >= Settings.MaxIterations)
+			{
+				bDone = true;
+				break;
+			}
+			Step();
+
+			/* Checked after the step so every call makes progress, however small the budget. */
+			if (BudgetMs > 0. && std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count() >= BudgetMs)
+			{
+				break;
+			}
+		}
+		return Result;
+	}
+
+	void SeparationSolver::Commit(std::vector<Cell>& Cells) const
+	{
+		for (size_t CellIndex = 0; CellIndex < Cells.size() && CellIndex < Positions.size(); ++CellIndex)
+		{
+			Cells[CellIndex].Location = Positions[CellIndex];
+		}
+	}
+
+	bool SeparationSolver::StepSteering()
+	{
+		/* Pad the cell size so the float distance test below never misses a neighbour. */
+		Grid.Build(Positions, Settings.MinDistance + 1., &Floors);
+
+		ParallelForRange(GetNumCells(), CellsPerTask, [this](int32_t Begin, int32_t End)
+		{
+			for (int32_t CellIndex = Begin; CellIndex < End; ++CellIndex)
+			{
+				Forces[CellIndex] = Separate(CellIndex);
+			}
+		});
+
+		/* Applied and summed in index order so the result is the same for any thread count. */
+		Vec2 Vel;
+		for (int32_t CellIndex = 0; CellIndex < GetNumCells(); ++CellIndex)
+		{
+			Vel += Forces[CellIndex];
+			Positions[CellIndex] += Forces[CellIndex];
+		}
+		return Vel != Vec2();
+	}
+
+	bool SeparationSolver::StepPenetration()
+	{
+		/* Overlapping cells are less than PairReach apart on both axes, so within one grid cell of each other. */
+		Grid.Build(Positions, PairReach + 1., &Floors);
+
+		ParallelForRange(GetNumCells(), CellsPerTask, [this](int32_t Begin, int32_t End)
+		{
+			for (int32_t CellIndex = Begin; CellIndex < End; ++CellIndex)
+			{
+				Forces[CellIndex] = Resolve(CellIndex, Penetrations[CellIndex]);
+			}
+		});
+
+		Result.MaxPenetration = 0.;
+		for (const double Penetration : Penetrations)
+		{
+			Result.MaxPenetration = std::max(Result.MaxPenetration, Penetration);
+		}
+		if (Result.MaxPenetration <= Settings.Tolerance)
+		{
+			return false;
+		}
+
+		for (int32_t CellIndex = 0; CellIndex < GetNumCells(); ++CellIndex)
+		{
+			Positions[CellIndex] += Forces[CellIndex];
+		}
+		return true;
+	}
+
+	Vec2 SeparationSolver::Separate(int32_t CellIndex) const
+	{
+		Vec2 Velocity;
+		int NeighborCount = 0;
+
+		const float MinDistance = Settings.MinDistance;
+		const Vec2 Location = Positions[CellIndex];
+		const double ExtentSize = ExtentSizes[CellIndex];
+		const double MaxDistanceSq = static_cast<double>(MinDistance) * MinDistance * 1.0001;
+		Grid.ForEachNear(Location, Floors[CellIndex], [&](int32_t Other)
+		{
+			if (Other == CellIndex)
+			{
+				return;
+			}
+
+			/* Cheap reject before the exact float distance test below. */
+			const Vec2 Offset = Location - Positions[Other];
+			if (Offset.SizeSquared() > MaxDistanceSq)
+			{
+				return;
+			}
+
+			const float Distance = static_cast<float>(Offset.Size());
+
+			/* Coincident cells would get identical forces, push them apart by index order instead. */
+			if (Distance == 0)
+			{
+				NeighborCount = 1;
+				Velocity = CellIndex < Other ? Vec2(MinDistance, MinDistance) : Vec2(-MinDistance, -MinDistance);
+			}
+
+			if (Distance <= MinDistance)
+			{
+				Velocity += Offset / ExtentSize;
+				NeighborCount++;
+			}
+		});
+
+		if (NeighborCount == 0)
+		{
+			return {};
+		}
+
+		Velocity /= NeighborCount;
+		if (Velocity.SizeSquared() > 1.)
+		{
+			Velocity = Velocity / Velocity.Size();
+		}
+		return Velocity * SeparationStepLength;
+	}
+
+	Vec2 SeparationSolver::Resolve(int32_t CellIndex, double& Penetration) const
+	{
+		Vec2 Push;
+		Penetration = 0.;
+
+		const Vec2 Location = Positions[CellIndex];
+		const Vec2 Extent = Extents[CellIndex];
+		Grid.ForEachNear(Location, Floors[CellIndex], [&](int32_t Other)
+		{
+			if (Other == CellIndex)
+			{
+				return;
+			}
+
+			const Vec2 Offset = Location - Positions[Other];
+			const double OverlapX = Extent.X + Extents[Other].X - std::abs(Offset.X);
+			const double OverlapY = Extent.Y + Extents[Other].Y - std::abs(Offset.Y);
+			if (OverlapX <= 0. || OverlapY <= 0.)
+			{
+				return;
+			}
+
+			/*
+			 * Both cells of a pair move the whole overlap, not half, so a lone pair ends up as far apart as it
+			 * overlapped. Pushes from opposite sides of a cluster cancel out and half steps take many times
+			 * the iterations to settle. A zero offset is split by index order, the pair sees it mirrored.
+			 */
+			const double Away = CellIndex < Other ? -1. : 1.;
+			if (OverlapX <= OverlapY)
+			{
+				Push.X += (Offset.X > 0. ? 1. : Offset.X < 0. ? -1. : Away) * OverlapX;
+				Penetration = std::max(Penetration, OverlapX);
+			}
+			else
+			{
+				Push.Y += (Offset.Y > 0. ? 1. : Offset.Y < 0. ? -1. : Away) * OverlapY;
+				Penetration = std::max(Penetration, OverlapY);
+			}
+		});
+		return Push;
+	}
+}
@@ -0,0 +1,99 @@
+#include "DungeonCore/SpanningTree.h"
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+#include <utility>
+
+namespace DungeonCore
+{
+	namespace
+	{
+		class DisjointSet
+		{
+		public:
+			explicit DisjointSet(int32_t NumElements) : Parent(NumElements), Size(NumElements, 1)
+			{
+				std::iota(Parent.begin(), Parent.end(), 0);
+			}
+
+			int32_t Find(int32_t Element)
+			{
+				while (Parent[Element] != Element)
+				{
+					/* Path halving. */
+					Parent[Element] = Parent[Parent[Element]];
+					Element = Parent[Element];
+				}
+				return Element;
+			}
+
+			/* Returns false if both elements were already in the same set. */
+			bool Union(int32_t A, int32_t B)
+			{
+				A = Find(A);
+				B = Find(B);
+				if (A == B)
+				{
+					return false;
+				}
+				if (Size[A] < Size[B])
+				{
+					std::swap(A, B);
+				}
+				Parent[B] = A;
+				Size[A] += Size[B];
+				return true;
+			}
+
+		private:
+			std::vector<int32_t> Parent;
+			std::vector<int32_t> Size;
+		};
+	}
+
+	std::vector<int32_t> MinimumSpanningTree(const std::vector<IndexEdge>& EdgeList, int32_t NumVertices)
+	{
+		std::vector<int32_t> Results;
+		if (NumVertices <= 1)
+		{
+			return Results;
+		}
+
+		struct SortEntry
+		{
+			double Weight;
+			int32_t Lo, Hi, EdgeIndex;
+
+			bool operator<(const SortEntry& Other) const
+			{
+				return std::tie(Weight, Lo, Hi, EdgeIndex) < std::tie(Other.Weight, Other.Lo, Other.Hi, Other.EdgeIndex);
+			}
+		};
+
+		/* Sort flat records rather than indices so comparisons stay in cache. */
+		std::vector<SortEntry> Order;
+		Order.reserve(EdgeList.size());
+		for (int32_t EdgeIndex = 0; EdgeIndex < static_cast<int32_t>(EdgeList.size()); ++EdgeIndex)
+		{
+			const IndexEdge& Edge = EdgeList[EdgeIndex];
+			Order.push_back({Edge.Weight, std::min(Edge.A, Edge.B), std::max(Edge.A, Edge.B), EdgeIndex});
+		}
+		std::sort(Order.begin(), Order.end());
+
+		DisjointSet Sets{NumVertices};
+		Results.reserve(NumVertices - 1);
+		for (const SortEntry& Entry : Order)
+		{
+			if (Sets.Union(Entry.Lo, Entry.Hi))
+			{
+				Results.push_back(Entry.EdgeIndex);
+				if (static_cast<int32_t>(Results.size()) == NumVertices - 1)
+				{
+					break;
+				}
+			}
+		}
+		return Results;
+	}
+}
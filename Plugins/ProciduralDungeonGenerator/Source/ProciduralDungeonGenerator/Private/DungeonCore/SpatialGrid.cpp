@@ -0,0 +1,39 @@
+#include "DungeonCore/SpatialGrid.h"
+
+namespace DungeonCore
+{
+	void SpatialGrid::Build(const std::vector<Vec2>& Points, double InCellSize, const std::vector<int32_t>* Layers)
+	{
+		CellSize = InCellSize > 0. ? InCellSize : 1.;
+		InvCellSize = 1. / CellSize;
+
+		/* Power of two bucket count, about two buckets per point keeps collisions rare. */
+		uint32_t NumBuckets = 1;
+		while (NumBuckets < 2 * Points.size())
+		{
+			NumBuckets <<= 1;
+		}
+		BucketMask = NumBuckets - 1;
+
+		BucketStart.assign(NumBuckets + 1, 0);
+		Unsorted.resize(Points.size());
+		for (int32_t Index = 0; Index < static_cast<int32_t>(Points.size()); ++Index)
+		{
+			Entry& NewEntry = Unsorted[Index];
+			NewEntry = {Index, ToGrid(Points[Index].X), ToGrid(Points[Index].Y), Layers ? (*Layers)[Index] : 0};
+			++BucketStart[BucketOf(NewEntry.GridX, NewEntry.GridY, NewEntry.Layer) + 1];
+		}
+
+		for (uint32_t Bucket = 0; Bucket < NumBuckets; ++Bucket)
+		{
+			BucketStart[Bucket + 1] += BucketStart[Bucket];
+		}
+
+		Entries.resize(Points.size());
+		Cursor.assign(BucketStart.begin(), BucketStart.end() - 1);
+		for (const Entry& Item : Unsorted)
+		{
+			Entries[Cursor[BucketOf(Item.GridX, Item.GridY, Item.Layer)]++] = Item;
+		}
+	}
+}
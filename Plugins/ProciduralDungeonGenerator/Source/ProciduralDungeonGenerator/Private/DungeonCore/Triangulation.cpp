@@ -0,0 +1,490 @@
+// The sweep-hull triangulation below is adapted from delaunator by Mapbox (https://github.com/mapbox/delaunator),
+// used under the ISC license:
+//
+// Copyright (c) 2017, Mapbox
+//
+// Permission to use, copy, modify, and/or distribute this software for any purpose with or without fee is hereby
+// granted, provided that the above copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+// IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "DungeonCore/Triangulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace DungeonCore
+{
+	namespace
+	{
+		constexpr double Epsilon = std::numeric_limits<double>::epsilon();
+		constexpr int Invalid = -1;
+
+		/* True when R lies to the right of the directed line P -> Q. */
+		bool Orient(const Vec2& P, const Vec2& Q, const Vec2& R)
+		{
+			return (Q.Y - P.Y) * (R.X - Q.X) - (Q.X - P.X) * (R.Y - Q.Y) < 0.;
+		}
+
+		bool InCircle(const Vec2& A, const Vec2& B, const Vec2& C, const Vec2& P)
+		{
+			const double AX = A.X - P.X;
+			const double AY = A.Y - P.Y;
+			const double BX = B.X - P.X;
+			const double BY = B.Y - P.Y;
+			const double CX = C.X - P.X;
+			const double CY = C.Y - P.Y;
+
+			const double ALengthSq = AX * AX + AY * AY;
+			const double BLengthSq = BX * BX + BY * BY;
+			const double CLengthSq = CX * CX + CY * CY;
+
+			return AX * (BY * CLengthSq - BLengthSq * CY) - AY * (BX * CLengthSq - BLengthSq * CX) + ALengthSq * (BX * CY - BY * CX) < 0.;
+		}
+
+		/* Squared circumradius, infinite for collinear points. */
+		double CircumradiusSq(const Vec2& A, const Vec2& B, const Vec2& C)
+		{
+			const double BX = B.X - A.X;
+			const double BY = B.Y - A.Y;
+			const double CX = C.X - A.X;
+			const double CY = C.Y - A.Y;
+
+			const double BLengthSq = BX * BX + BY * BY;
+			const double CLengthSq = CX * CX + CY * CY;
+			const double Det = BX * CY - BY * CX;
+			if (Det == 0.)
+			{
+				return std::numeric_limits<double>::infinity();
+			}
+			const double Scale = 0.5 / Det;
+
+			const double X = (CY * BLengthSq - BY * CLengthSq) * Scale;
+			const double Y = (BX * CLengthSq - CX * BLengthSq) * Scale;
+			const double RadiusSq = X * X + Y * Y;
+			return std::isfinite(RadiusSq) ? RadiusSq : std::numeric_limits<double>::infinity();
+		}
+
+		Vec2 Circumcenter(const Vec2& A, const Vec2& B, const Vec2& C)
+		{
+			const double BX = B.X - A.X;
+			const double BY = B.Y - A.Y;
+			const double CX = C.X - A.X;
+			const double CY = C.Y - A.Y;
+
+			const double BLengthSq = BX * BX + BY * BY;
+			const double CLengthSq = CX * CX + CY * CY;
+			const double Scale = 0.5 / (BX * CY - BY * CX);
+
+			return {A.X + (CY * BLengthSq - BY * CLengthSq) * Scale, A.Y + (BX * CLengthSq - CX * BLengthSq) * Scale};
+		}
+
+		/* Monotonic in the angle of (DX, DY), cheaper than atan2. Result is in [0, 1]. */
+		double PseudoAngle(double DX, double DY)
+		{
+			const double Ratio = DX / (std::abs(DX) + std::abs(DY));
+			return (DY > 0. ? 3. - Ratio : 1. + Ratio) / 4.;
+		}
+
+		/*
+		 * Sweep-hull triangulation: points are inserted in order of distance from a seed triangle so every
+		 * new point lies outside the current convex hull. The hull is kept as a linked list with an angular
+		 * hash for O(1) expected lookup of a visible edge, and new triangles are legalized by edge flips.
+		 */
+		class SweepHull
+		{
+		public:
+			explicit SweepHull(const std::vector<Vec2>& InPoints) : Points{InPoints}
+			{
+			}
+
+			/* Fills Triangles as vertex triples. Returns false if every point is collinear. */
+			bool Run()
+			{
+				const int NumPoints = static_cast<int>(Points.size());
+				const int MaxTriangles = std::max(2 * NumPoints - 5, 0);
+				Triangles.resize(MaxTriangles * 3);
+				HalfEdges.resize(MaxTriangles * 3);
+				HullPrev.resize(NumPoints);
+				HullNext.resize(NumPoints);
+				HullTri.resize(NumPoints);
+				HashSize = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(NumPoints))));
+				HullHash.assign(HashSize, Invalid);
+
+				double MinX = std::numeric_limits<double>::infinity();
+				double MinY = MinX;
+				double MaxX = -MinX;
+				double MaxY = -MinX;
+				for (const Vec2& Point : Points)
+				{
+					MinX = std::min(MinX, Point.X);
+					MinY = std::min(MinY, Point.Y);
+					MaxX = std::max(MaxX, Point.X);
+					MaxY = std::max(MaxY, Point.Y);
+				}
+				const Vec2 Mid{(MinX + MaxX) / 2., (MinY + MaxY) / 2.};
+
+				/* Seed triangle: point closest to the centre, its nearest neighbour and the smallest circumcircle. */
+				int Seed0 = ClosestPoint(Mid, Invalid);
+				int Seed1 = ClosestPoint(Points[Seed0], Seed0);
+				if (Seed1 == Invalid)
+				{
+					return false;
+				}
+
+				double MinRadius = std::numeric_limits<double>::infinity();
+				int Seed2 = Invalid;
+				for (int PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+				{
+					if (PointIndex == Seed0 || PointIndex == Seed1)
+					{
+						continue;
+					}
+					const double Radius = CircumradiusSq(Points[Seed0], Points[Seed1], Points[PointIndex]);
+					if (Radius < MinRadius)
+					{
+						Seed2 = PointIndex;
+						MinRadius = Radius;
+					}
+				}
+				if (Seed2 == Invalid)
+				{
+					return false;
+				}
+
+				if (Orient(Points[Seed0], Points[Seed1], Points[Seed2]))
+				{
+					std::swap(Seed1, Seed2);
+				}
+
+				Center = Circumcenter(Points[Seed0], Points[Seed1], Points[Seed2]);
+
+				std::vector<double> Dists(NumPoints);
+				for (int PointIndex = 0; PointIndex < NumPoints; ++PointIndex)
+				{
+					Dists[PointIndex] = (Points[PointIndex] - Center).SizeSquared();
+				}
+
+				std::vector<int> Ids(NumPoints);
+				std::iota(Ids.begin(), Ids.end(), 0);
+				std::sort(Ids.begin(), Ids.end(), [&Dists](int A, int B)
+				{
+					return Dists[A] < Dists[B] || (Dists[A] == Dists[B] && A < B);
+				});
+
+				/* The seed triangle is the starting hull. */
+				HullStart = Seed0;
+				HullNext[Seed0] = HullPrev[Seed2] = Seed1;
+				HullNext[Seed1] = HullPrev[Seed0] = Seed2;
+				HullNext[Seed2] = HullPrev[Seed1] = Seed0;
+
+				HullTri[Seed0] = 0;
+				HullTri[Seed1] = 1;
+				HullTri[Seed2] = 2;
+
+				HullHash[HashKey(Points[Seed0])] = Seed0;
+				HullHash[HashKey(Points[Seed1])] = Seed1;
+				HullHash[HashKey(Points[Seed2])] = Seed2;
+
+				AddTriangle(Seed0, Seed1, Seed2, Invalid, Invalid, Invalid);
+
+				Vec2 Previous;
+				for (int Order = 0; Order < NumPoints; ++Order)
+				{
+					const int PointIndex = Ids[Order];
+					const Vec2& Point = Points[PointIndex];
+
+					/* Skip near-duplicate points. */
+					if (Order > 0 && std::abs(Point.X - Previous.X) <= Epsilon && std::abs(Point.Y - Previous.Y) <= Epsilon)
+					{
+						continue;
+					}
+					Previous = Point;
+
+					if (PointIndex == Seed0 || PointIndex == Seed1 || PointIndex == Seed2)
+					{
+						continue;
+					}
+
+					/* Find a visible edge on the convex hull using the edge hash. */
+					int Start = 0;
+					const int Key = HashKey(Point);
+					for (int Probe = 0; Probe < HashSize; ++Probe)
+					{
+						Start = HullHash[(Key + Probe) % HashSize];
+						if (Start != Invalid && Start != HullNext[Start])
+						{
+							break;
+						}
+					}
+
+					Start = HullPrev[Start];
+					int Visible = Start;
+					int Neighbour = HullNext[Visible];
+					while (!Orient(Point, Points[Visible], Points[Neighbour]))
+					{
+						Visible = Neighbour;
+						if (Visible == Start)
+						{
+							Visible = Invalid;
+							break;
+						}
+						Neighbour = HullNext[Visible];
+					}
+
+					/* Likely a near-duplicate point, skip it. */
+					if (Visible == Invalid)
+					{
+						continue;
+					}
+
+					/* Add the first triangle from the point and flip until Delaunay. */
+					int Tri = AddTriangle(Visible, PointIndex, HullNext[Visible], Invalid, Invalid, HullTri[Visible]);
+					HullTri[PointIndex] = Legalize(Tri + 2);
+					HullTri[Visible] = Tri;
+
+					/* Walk forward through the hull adding more triangles. */
+					int Last = HullNext[Visible];
+					Neighbour = HullNext[Last];
+					while (Orient(Point, Points[Last], Points[Neighbour]))
+					{
+						Tri = AddTriangle(Last, PointIndex, Neighbour, HullTri[PointIndex], Invalid, HullTri[Last]);
+						HullTri[PointIndex] = Legalize(Tri + 2);
+						HullNext[Last] = Last;
+						Last = Neighbour;
+						Neighbour = HullNext[Last];
+					}
+
+					/* Walk backward from the other side. */
+					if (Visible == Start)
+					{
+						Neighbour = HullPrev[Visible];
+						while (Orient(Point, Points[Neighbour], Points[Visible]))
+						{
+							Tri = AddTriangle(Neighbour, PointIndex, Visible, Invalid, HullTri[Visible], HullTri[Neighbour]);
+							Legalize(Tri + 2);
+							HullTri[Neighbour] = Tri;
+							HullNext[Visible] = Visible;
+							Visible = Neighbour;
+							Neighbour = HullPrev[Visible];
+						}
+					}
+
+					HullStart = HullPrev[PointIndex] = Visible;
+					HullNext[Visible] = HullPrev[Last] = PointIndex;
+					HullNext[PointIndex] = Last;
+
+					HullHash[HashKey(Point)] = PointIndex;
+					HullHash[HashKey(Points[Visible])] = Visible;
+				}
+
+				Triangles.resize(TrianglesLen);
+				HalfEdges.resize(TrianglesLen);
+				return true;
+			}
+
+			std::vector<int32_t> GetHull() const
+			{
+				std::vector<int32_t> Hull;
+				int Vertex = HullStart;
+				do
+				{
+					Hull.push_back(Vertex);
+					Vertex = HullNext[Vertex];
+				}
+				while (Vertex != HullStart);
+				return Hull;
+			}
+
+			const std::vector<Vec2>& Points;
+
+			/* Vertex ids, three per triangle. */
+			std::vector<int32_t> Triangles;
+
+			/* Opposite half-edge of every half-edge, Invalid on the convex hull. */
+			std::vector<int32_t> HalfEdges;
+
+		private:
+			int ClosestPoint(const Vec2& Target, int Exclude) const
+			{
+				double MinDist = std::numeric_limits<double>::infinity();
+				int Closest = Invalid;
+				for (int PointIndex = 0; PointIndex < static_cast<int>(Points.size()); ++PointIndex)
+				{
+					if (PointIndex == Exclude)
+					{
+						continue;
+					}
+					const double Dist = (Points[PointIndex] - Target).SizeSquared();
+					if (Dist < MinDist && (Exclude == Invalid || Dist > 0.))
+					{
+						Closest = PointIndex;
+						MinDist = Dist;
+					}
+				}
+				return Closest;
+			}
+
+			int HashKey(const Vec2& Point) const
+			{
+				const double Angle = PseudoAngle(Point.X - Center.X, Point.Y - Center.Y);
+				if (std::isnan(Angle))
+				{
+					return 0;
+				}
+				return static_cast<int>(std::floor(Angle * HashSize)) % HashSize;
+			}
+
+			void Link(int A, int B)
+			{
+				HalfEdges[A] = B;
+				if (B != Invalid)
+				{
+					HalfEdges[B] = A;
+				}
+			}
+
+			int AddTriangle(int V0, int V1, int V2, int A, int B, int C)
+			{
+				const int First = TrianglesLen;
+				Triangles[First] = V0;
+				Triangles[First + 1] = V1;
+				Triangles[First + 2] = V2;
+				Link(First, A);
+				Link(First + 1, B);
+				Link(First + 2, C);
+				TrianglesLen += 3;
+				return First;
+			}
+
+			/* Flips edges until the triangles around half-edge A are locally Delaunay. */
+			int Legalize(int A)
+			{
+				int AR = 0;
+				EdgeStack.clear();
+
+				while (true)
+				{
+					const int B = HalfEdges[A];
+					const int StartA = A - A % 3;
+					AR = StartA + (A + 2) % 3;
+
+					/* Convex hull edge. */
+					if (B == Invalid)
+					{
+						if (EdgeStack.empty())
+						{
+							break;
+						}
+						A = EdgeStack.back();
+						EdgeStack.pop_back();
+						continue;
+					}
+
+					const int StartB = B - B % 3;
+					const int AL = StartA + (A + 1) % 3;
+					const int BL = StartB + (B + 2) % 3;
+
+					const int P0 = Triangles[AR];
+					const int PR = Triangles[A];
+					const int PL = Triangles[AL];
+					const int P1 = Triangles[BL];
+
+					if (InCircle(Points[P0], Points[PR], Points[PL], Points[P1]))
+					{
+						Triangles[A] = P1;
+						Triangles[B] = P0;
+
+						const int HBL = HalfEdges[BL];
+
+						/* Edge swapped on the other side of the hull, fix the hull triangle reference. */
+						if (HBL == Invalid)
+						{
+							int Vertex = HullStart;
+							do
+							{
+								if (HullTri[Vertex] == BL)
+								{
+									HullTri[Vertex] = A;
+									break;
+								}
+								Vertex = HullPrev[Vertex];
+							}
+							while (Vertex != HullStart);
+						}
+						Link(A, HBL);
+						Link(B, HalfEdges[AR]);
+						Link(AR, BL);
+
+						EdgeStack.push_back(StartB + (B + 1) % 3);
+					}
+					else
+					{
+						if (EdgeStack.empty())
+						{
+							break;
+						}
+						A = EdgeStack.back();
+						EdgeStack.pop_back();
+					}
+				}
+				return AR;
+			}
+
+			std::vector<int> HullPrev;
+			std::vector<int> HullNext;
+			std::vector<int> HullTri;
+			std::vector<int> HullHash;
+			std::vector<int> EdgeStack;
+			Vec2 Center;
+			int HashSize = 0;
+			int HullStart = 0;
+			int TrianglesLen = 0;
+		};
+
+		double EdgeWeight(const std::vector<Vec2>& Points, int32_t P0, int32_t P1)
+		{
+			return (Points[P0] - Points[P1]).Size();
+		}
+	}
+
+	Triangulation Triangulate(const std::vector<Vec2>& Points)
+	{
+		Triangulation Result;
+		Result.Vertices = Points;
+		if (Points.size() < 3)
+		{
+			return Result;
+		}
+
+		SweepHull Sweep{Points};
+		if (!Sweep.Run())
+		{
+			return Result;
+		}
+
+		Result.Triangles = std::move(Sweep.Triangles);
+		Result.HalfEdges = std::move(Sweep.HalfEdges);
+		Result.Hull = Sweep.GetHull();
+
+		/* Interior edges are seen from both sides, keep the half-edge with the larger id. */
+		const int32_t NumHalfEdges = static_cast<int32_t>(Result.Triangles.size());
+		Result.Edges.reserve(NumHalfEdges / 2 + Result.Hull.size());
+		for (int32_t HalfEdge = 0; HalfEdge < NumHalfEdges; ++HalfEdge)
+		{
+			if (HalfEdge > Result.HalfEdges[HalfEdge])
+			{
+				const int32_t A = Result.Triangles[HalfEdge];
+				const int32_t B = Result.Triangles[Triangulation::NextHalfEdge(HalfEdge)];
+				Result.Edges.push_back({A, B, EdgeWeight(Points, A, B)});
+			}
+		}
+		return Result;
+	}
+}
@@ -2,19 +2,98 @@
 
 
 #include "DungeonGenerator.h"
-#include "CustomSpline.h"
-#include "DelaunayTriangulation.h"
-#include "MST.h"
-#include "StaticMeshAttributes.h"
-#include "Components/BoxComponent.h"
+#include "DungeonCore/DungeonLayoutGenerator.h"
+#include "DungeonCore/LayoutSerialization.h"
+#include "DungeonCore/SectorStreaming.h"
+#include "Async/Async.h"
+#include "Async/MappedFileHandle.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
 #include "Engine/StaticMeshActor.h"
-#include "Kismet/KismetMathLibrary.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DECLARE_STATS_GROUP(TEXT("DungeonGenerator"), STATGROUP_DungeonGenerator, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Materialize"), STAT_DungeonMaterialize, STATGROUP_DungeonGenerator);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Spawn cells ms"), STAT_DungeonSpawnMs, STATGROUP_DungeonGenerator);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Separation ms"), STAT_DungeonSeparationMs, STATGROUP_DungeonGenerator);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Select rooms ms"), STAT_DungeonSelectRoomsMs, STATGROUP_DungeonGenerator);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Triangulation ms"), STAT_DungeonTriangulationMs, STATGROUP_DungeonGenerator);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Spanning tree ms"), STAT_DungeonSpanningTreeMs, STATGROUP_DungeonGenerator);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Loop edges ms"), STAT_DungeonLoopEdgesMs, STATGROUP_DungeonGenerator);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Corridors ms"), STAT_DungeonCorridorsMs, STATGROUP_DungeonGenerator);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Generate total ms"), STAT_DungeonGenerateMs, STATGROUP_DungeonGenerator);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Separation steps"), STAT_DungeonSeparationSteps, STATGROUP_DungeonGenerator);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Cells"), STAT_DungeonCells, STATGROUP_DungeonGenerator);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rooms"), STAT_DungeonRooms, STATGROUP_DungeonGenerator);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Triangles"), STAT_DungeonTriangles, STATGROUP_DungeonGenerator);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Edges"), STAT_DungeonEdges, STATGROUP_DungeonGenerator);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Corridor tiles"), STAT_DungeonCorridorTiles, STATGROUP_DungeonGenerator);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Resident sectors"), STAT_DungeonResidentSectors, STATGROUP_DungeonGenerator);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sector jobs"), STAT_DungeonSectorJobs, STATGROUP_DungeonGenerator);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pooled actors"), STAT_DungeonPooledActors, STATGROUP_DungeonGenerator);
+DECLARE_MEMORY_STAT(TEXT("Peak generation memory"), STAT_DungeonPeakMemory, STATGROUP_DungeonGenerator);
+
+namespace
+{
+	constexpr int32 NumInstanceCustomData = 4;
+	const FLinearColor RoomColor(0.9f, 0.1f, 0.1f);
+	const FLinearColor PathColor(1.f, 1.f, 1.f);
+
+	// Items spawned between two budget checks, instances are cheap enough to batch
+	constexpr int32 ActorBatchSize = 1;
+	constexpr int32 InstanceBatchSize = 64;
+
+	// Queue is only re-sorted once the player moved this many corridor sections
+	constexpr float RefocusSections = 4.f;
+
+	// Emptied instanced components kept for reuse, sectors need two each
+	constexpr int32 MaxPooledInstances = 16;
+
+	// The separation property is cast straight to the core enum
+	static_assert(static_cast<uint8>(EDungeonSeparationMethod::Penetration) == static_cast<uint8>(DungeonCore::SeparationMethod::Penetration) &&
+	              static_cast<uint8>(EDungeonSeparationMethod::Steering) == static_cast<uint8>(DungeonCore::SeparationMethod::Steering),
+	              "EDungeonSeparationMethod has to match DungeonCore::SeparationMethod");
+
+	// Spawned geometry is matched to layout items by position, to the nearest unit
+	FIntVector ToLocationKey(const FVector& Location)
+	{
+		return FIntVector(FMath::RoundToInt(Location.X), FMath::RoundToInt(Location.Y), FMath::RoundToInt(Location.Z));
+	}
+
+	// Centred on the run and stretched along it, a one tile strip is a plain tile
+	FTransform MakeStripTransform(const DungeonCore::CorridorStrip& Strip, double SectionLength)
+	{
+		const DungeonCore::Vec3 Center = Strip.GetCenter(SectionLength);
+		const FVector Scale = Strip.bAlongY ? FVector(1., Strip.NumTiles, 1.) : FVector(Strip.NumTiles, 1., 1.);
+		return FTransform(FRotator::ZeroRotator, FVector(Center.X, Center.Y, Center.Z), Scale);
+	}
+}
+
+// State shared between the game thread and the worker running one GenerateDungeonAsync call
+struct FDungeonGenerationJob
+{
+	DungeonCore::DungeonParams Params;
+	uint32 Seed{0};
+	DungeonCore::GenerationProgress Progress;
+	std::shared_ptr<const DungeonCore::DungeonLayout> Result;
+	bool bFromCache{false};
+};
+
+// State shared between the game thread and the worker generating one streamed sector
+struct FDungeonSectorJob
+{
+	DungeonCore::GenerationProgress Progress;
+	DungeonCore::DungeonLayout Result;
+};
 
 // Sets default values
 ADungeonGenerator::ADungeonGenerator()
 {
-	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = false;
+	// Only ticks while a layout is being materialized or sectors are streamed
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 }
 
 // Called when the game starts or when spawned
@@ -23,53 +102,199 @@ void ADungeonGenerator::BeginPlay()
 	Super::BeginPlay();
 }
 
+void ADungeonGenerator::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	CancelGeneration();
+	StopSectorStreaming();
+	EmptyPool();
+	Super::EndPlay(EndPlayReason);
+}
+
 void ADungeonGenerator::GenerateDungeon()
 {
-	if (const auto World = GetWorld())
+	if (GetWorld())
+	{
+		CancelGeneration();
+		StopSectorStreaming();
+		const DungeonCore::DungeonParams Params = MakeLayoutParams();
+		const uint32 NewSeed = NextSeed();
+		const bool bFromCache = LayoutCache->Find(Params, NewSeed) != nullptr;
+		Layout = *LayoutCache->GetOrGenerate(Params, NewSeed);
+		Editor = DungeonCore::LayoutEditor();
+		Navigator.Reset();
+		LayoutParams = Params;
+		LayoutSeed = NewSeed;
+		PublishStats(bFromCache);
+		OnDungeonGenerated.Broadcast();
+		MaterializeLayout();
+	}
+}
+
+void ADungeonGenerator::GenerateDungeonAsync()
+{
+	if (!GetWorld())
+	{
+		return;
+	}
+
+	CancelGeneration();
+	StopSectorStreaming();
+	const TSharedPtr<FDungeonGenerationJob, ESPMode::ThreadSafe> Job = MakeShared<FDungeonGenerationJob, ESPMode::ThreadSafe>();
+	ActiveJob = Job;
+
+	// Everything the worker touches is captured by value, the actor is only reached back on the game thread
+	Job->Params = MakeLayoutParams();
+	Job->Seed = NextSeed();
+	TWeakObjectPtr<ADungeonGenerator> WeakThis(this);
+	Async(EAsyncExecution::ThreadPool, [Job, Cache = LayoutCache, WeakThis]()
 	{
-		bIsDungeonGenerating = true;
-		//Spawn Cells
-		for (int CellSpawned = 0; CellSpawned < NumberOfCells; ++CellSpawned)
+		Job->bFromCache = Cache->Find(Job->Params, Job->Seed) != nullptr;
+		Job->Result = Cache->GetOrGenerate(Job->Params, Job->Seed, &Job->Progress);
+		AsyncTask(ENamedThreads::GameThread, [Job, WeakThis]()
 		{
-			FActorSpawnParameters SpawnParams;
-			SpawnParams.SpawnCollisionHandlingOverride =
-				ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
-			FVector Location = GetRandomPointInCircle(SpawnRadius);
-			auto Cell = World->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), Location,
-			                                                FRotator::ZeroRotator, SpawnParams);
-			Cell->SetActorScale3D(FVector(FMath::RandRange(MinSize, MaxSize)*2,
-			                              FMath::RandRange(MinSize, MaxSize)*2,
-			                              2));
-			
-			Cell->SetMobility(EComponentMobility::Movable);
-			Cell->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
-			Cell->GetStaticMeshComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-			Cell->GetStaticMeshComponent()->SetCollisionObjectType(ECC_WorldDynamic);
-			Cell->GetStaticMeshComponent()->SetCollisionResponseToAllChannels(ECR_Block);
-			Cell->GetStaticMeshComponent()->SetStaticMesh(RoomMesh);
-			SpawnedCells.Add(Cell);
+			if (ADungeonGenerator* Generator = WeakThis.Get())
+			{
+				Generator->FinishGeneration(Job);
+			}
+		});
+	});
+}
+
+bool ADungeonGenerator::SaveDungeonLayout(const FString& FilePath) const
+{
+	if (Layout.Cells.empty())
+	{
+		return false;
+	}
+
+	const std::vector<uint8_t> Bytes = DungeonCore::WriteLayout({LayoutParams, LayoutSeed, Layout});
+	return FFileHelper::SaveArrayToFile(TArrayView<const uint8>(Bytes.data(), Bytes.size()), *FilePath);
+}
+
+bool ADungeonGenerator::LoadDungeonLayout(const FString& FilePath)
+{
+	if (!GetWorld())
+	{
+		return false;
+	}
+
+	// Read straight from a mapping of the file where the platform allows it, from a copy otherwise
+	DungeonCore::SavedLayout Saved;
+	DungeonCore::LayoutReadResult Result;
+	TUniquePtr<IMappedFileHandle> MappedFile(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FilePath));
+	TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile ? MappedFile->MapRegion() : nullptr);
+	if (MappedRegion)
+	{
+		Result = DungeonCore::ReadLayout(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize(), Saved);
+	}
+	else
+	{
+		TArray<uint8> Bytes;
+		if (!FFileHelper::LoadFileToArray(Bytes, *FilePath))
+		{
+			return false;
 		}
-		
-		bIsSeparating = true;
+		Result = DungeonCore::ReadLayout(Bytes.GetData(), Bytes.Num(), Saved);
 	}
+
+	if (Result != DungeonCore::LayoutReadResult::Ok)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Could not load dungeon layout %s: %hs"), *FilePath, DungeonCore::ToString(Result));
+		return false;
+	}
+
+	CancelGeneration();
+	StopSectorStreaming();
+
+	// The settings it was made with come along. It stays out of the layout cache, which only holds what the
+	// generator makes from them: the file may have been saved after edits or by an older generator.
+	NumberOfCells = Saved.Params.NumberOfCells;
+	MinSize = Saved.Params.MinSize;
+	MaxSize = Saved.Params.MaxSize;
+	SpawnRadius = Saved.Params.SpawnRadius;
+	MinDistance = Saved.Params.MinDistance;
+	SeparationMethod = static_cast<EDungeonSeparationMethod>(Saved.Params.Separation);
+	SeparationTolerance = Saved.Params.SeparationTolerance;
+	MaxSeparationSteps = Saved.Params.MaxSeparationSteps;
+	SnapSize = Saved.Params.SnapSize;
+	NumFloors = Saved.Params.NumFloors;
+	FloorHeight = Saved.Params.FloorHeight;
+	SectionLegnth = Saved.Params.SectionLength;
+	Seed = static_cast<int32>(Saved.Seed);
+	LayoutParams = Saved.Params;
+	LayoutSeed = Saved.Seed;
+	Layout = MoveTemp(Saved.Layout);
+	Editor = DungeonCore::LayoutEditor();
+	Navigator.Reset();
+
+	PublishStats(true);
+	OnDungeonGenerated.Broadcast();
+	MaterializeLayout();
+	return true;
+}
+
+float ADungeonGenerator::GetGenerationProgress() const
+{
+	if (ActiveJob)
+	{
+		return ActiveJob->Progress.Get();
+	}
+	return Layout.Cells.empty() ? 0.f : 1.f;
+}
+
+bool ADungeonGenerator::IsGenerating() const
+{
+	return ActiveJob.IsValid();
+}
+
+FDungeonGenerationStats ADungeonGenerator::GetLastGenerationStats() const
+{
+	return LastStats;
 }
 
 void ADungeonGenerator::ClearDungeon()
 {
-	for (const auto Cell : SpawnedCells)
+	CancelGeneration();
+	StopSectorStreaming();
+	MaterializeQueue.Clear();
+	UpdateTickEnabled();
+
+	ReleaseGeometry(Geometry, true);
+	Layout = {};
+	Editor = DungeonCore::LayoutEditor();
+	Navigator.Reset();
+	FlushPersistentDebugLines(GetWorld());
+}
+
+void ADungeonGenerator::EmptyPool()
+{
+	for (TArray<AStaticMeshActor*>* Pool : {&PooledCells, &PooledPaths})
 	{
-		Cell->Destroy();
+		for (AStaticMeshActor* MeshActor : *Pool)
+		{
+			if (IsValid(MeshActor))
+			{
+				MeshActor->Destroy();
+			}
+		}
+		Pool->Empty();
 	}
 
-	for (const auto Path : SpawnedPath)
+	for (UHierarchicalInstancedStaticMeshComponent* Instances : PooledInstances)
 	{
-		Path->Destroy();
+		if (IsValid(Instances))
+		{
+			RemoveInstanceComponent(Instances);
+			Instances->DestroyComponent();
+		}
 	}
+	PooledInstances.Empty();
+	SET_DWORD_STAT(STAT_DungeonPooledActors, 0);
+}
 
-	SpawnedCells.Empty();
-	Rooms.Empty();
-	SpawnedPath.Empty();
-	FlushPersistentDebugLines(GetWorld());
+int32 ADungeonGenerator::GetNumPooledActors() const
+{
+	return PooledCells.Num() + PooledPaths.Num();
 }
 
 // Called every frame
@@ -77,285 +302,1102 @@ void ADungeonGenerator::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	if (bIsDungeonGenerating)
+	if (MaterializeQueue.NumPending() > 0)
+	{
+		UpdateMaterializeFocus();
+		ProcessMaterializeQueue(MaterializeBudgetMs / 1000.);
+	}
+
+	if (bStreaming)
+	{
+		UpdateSectorStreaming(MaterializeBudgetMs / 1000.);
+	}
+}
+
+float ADungeonGenerator::GetMaterializationProgress() const
+{
+	return MaterializeQueue.GetProgress();
+}
+
+bool ADungeonGenerator::IsMaterializing() const
+{
+	return MaterializeQueue.NumPending() > 0;
+}
+
+void ADungeonGenerator::StartSectorStreaming()
+{
+	if (!GetWorld() || !GetWorld()->IsGameWorld())
+	{
+		return;
+	}
+
+	ClearDungeon();
+
+	// Sector components come and go, so they must not end up as the root the others are attached to
+	if (!GetRootComponent())
+	{
+		USceneComponent* Root = NewObject<USceneComponent>(this, TEXT("SectorRoot"));
+		SetRootComponent(Root);
+		Root->RegisterComponent();
+		AddInstanceComponent(Root);
+	}
+
+	DungeonCore::SectorParams Params;
+	Params.Layout = MakeLayoutParams();
+	Params.SectorSize = SectorSize;
+	Params.WorldSeed = NextSeed();
+	Streamer.Init(Params, ActiveSectorRadius);
+	bStreaming = true;
+	UpdateTickEnabled();
+}
+
+void ADungeonGenerator::StopSectorStreaming()
+{
+	if (!bStreaming)
+	{
+		return;
+	}
+	bStreaming = false;
+
+	// Finished workers find their job gone and drop the result
+	for (const auto& Job : SectorJobs)
+	{
+		Job.Value->Progress.Cancel();
+	}
+	SectorJobs.Empty();
+
+	for (auto& Sector : SectorGeometry)
+	{
+		ReleaseGeometry(Sector.Value, false);
+	}
+	SectorGeometry.Empty();
+	PendingSectors.Empty();
+	SectorQueue.Clear();
+	Streamer.Reset();
+	UpdateTickEnabled();
+}
+
+bool ADungeonGenerator::IsStreaming() const
+{
+	return bStreaming;
+}
+
+void ADungeonGenerator::UpdateSectorStreaming(double BudgetSeconds)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ADungeonGenerator::UpdateSectorStreaming);
+	const double EndTime = FPlatformTime::Seconds() + BudgetSeconds;
+
+	const FVector Focus = GetFocusLocation();
+	std::vector<DungeonCore::SectorCoord> Released;
+	Streamer.Update({Focus.X, Focus.Y}, Released);
+	for (const DungeonCore::SectorCoord& Coord : Released)
+	{
+		ReleaseSector(FIntPoint(Coord.X, Coord.Y));
+	}
+
+	// Workers for sectors that are no longer needed are cancelled, the nearest missing ones get started
+	const std::vector<DungeonCore::SectorCoord> Missing = Streamer.GetMissingLayouts();
+	TSet<FIntPoint> MissingSectors;
+	for (const DungeonCore::SectorCoord& Coord : Missing)
+	{
+		MissingSectors.Add(FIntPoint(Coord.X, Coord.Y));
+	}
+	for (auto It = SectorJobs.CreateIterator(); It; ++It)
+	{
+		if (!MissingSectors.Contains(It.Key()))
+		{
+			It.Value()->Progress.Cancel();
+			It.RemoveCurrent();
+		}
+	}
+	for (const DungeonCore::SectorCoord& Coord : Missing)
+	{
+		if (SectorJobs.Num() >= MaxSectorJobs)
+		{
+			break;
+		}
+		if (!SectorJobs.Contains(FIntPoint(Coord.X, Coord.Y)))
+		{
+			LaunchSectorJob(Coord);
+		}
+	}
+
+	for (const DungeonCore::SectorCoord& Coord : Streamer.TakeReadySectors())
+	{
+		PendingSectors.Add(FIntPoint(Coord.X, Coord.Y));
+	}
+	MaterializePendingSectors(EndTime);
+
+	SET_DWORD_STAT(STAT_DungeonResidentSectors, Streamer.NumResident());
+	SET_DWORD_STAT(STAT_DungeonSectorJobs, SectorJobs.Num());
+}
+
+void ADungeonGenerator::LaunchSectorJob(const DungeonCore::SectorCoord& Coord)
+{
+	const FIntPoint Sector(Coord.X, Coord.Y);
+	const TSharedPtr<FDungeonSectorJob, ESPMode::ThreadSafe> Job = MakeShared<FDungeonSectorJob, ESPMode::ThreadSafe>();
+	SectorJobs.Add(Sector, Job);
+
+	const DungeonCore::SectorParams Params = Streamer.GetParams();
+	TWeakObjectPtr<ADungeonGenerator> WeakThis(this);
+	Async(EAsyncExecution::ThreadPool, [Job, Params, Coord, Sector, WeakThis]()
 	{
-		if (!bIsSeparating)
+		Job->Result = DungeonCore::GenerateSectorLayout(Params, Coord, &Job->Progress);
+		AsyncTask(ENamedThreads::GameThread, [Job, Sector, WeakThis]()
 		{
-			for (const auto Cell : SpawnedCells)
+			if (ADungeonGenerator* Generator = WeakThis.Get())
 			{
-				if (Cell->GetActorScale().X > MinSize + 10 && Cell->GetActorScale().Y > MinSize + 10)
+				Generator->FinishSectorJob(Sector, Job);
+			}
+		});
+	});
+}
+
+void ADungeonGenerator::FinishSectorJob(const FIntPoint& Sector, const TSharedPtr<FDungeonSectorJob, ESPMode::ThreadSafe>& Job)
+{
+	// Same rule as FinishGeneration, only the job still registered for the sector counts
+	if (SectorJobs.FindRef(Sector) != Job)
+	{
+		return;
+	}
+	SectorJobs.Remove(Sector);
+
+	if (!Job->Progress.IsCancelled())
+	{
+		Streamer.ProvideLayout({Sector.X, Sector.Y}, MoveTemp(Job->Result));
+	}
+}
+
+void ADungeonGenerator::ReleaseSector(const FIntPoint& Sector)
+{
+	PendingSectors.Remove(Sector);
+	if (SectorQueue.NumPending() > 0 && MaterializingSector == Sector)
+	{
+		SectorQueue.Clear();
+	}
+
+	FDungeonGeometry Released;
+	if (SectorGeometry.RemoveAndCopyValue(Sector, Released))
+	{
+		ReleaseGeometry(Released, false);
+	}
+}
+
+void ADungeonGenerator::MaterializePendingSectors(double EndTime)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ADungeonGenerator::MaterializePendingSectors);
+	SCOPE_CYCLE_COUNTER(STAT_DungeonMaterialize);
+	const bool bUnbounded = MaterializeBudgetMs <= 0.f;
+	const FVector Focus = GetFocusLocation();
+
+	while (SectorQueue.NumPending() > 0 || PendingSectors.Num() > 0)
+	{
+		if (SectorQueue.NumPending() == 0)
+		{
+			MaterializingSector = PendingSectors[0];
+			PendingSectors.RemoveAt(0);
+			if (const DungeonCore::DungeonLayout* SectorLayout = Streamer.GetReadyLayout({MaterializingSector.X, MaterializingSector.Y}))
+			{
+				FDungeonGeometry& Target = SectorGeometry.FindOrAdd(MaterializingSector);
+				MergeCorridors(*SectorLayout, Streamer.GetParams().Layout.SectionLength, Target);
+				SectorQueue.Reset(*SectorLayout, OutputMode == EDungeonOutputMode::Actors,
+				                  Target.bMergedCorridors ? &Target.Strips : nullptr, Target.SectionLength);
+				SectorQueue.SetFocus({Focus.X, Focus.Y});
+			}
+			continue;
+		}
+
+		// The layout stays owned by the streamer until the sector is released, which also clears the queue
+		const DungeonCore::DungeonLayout* SectorLayout = Streamer.GetReadyLayout({MaterializingSector.X, MaterializingSector.Y});
+		MaterializeItems(SectorQueue, *SectorLayout, SectorGeometry.FindOrAdd(MaterializingSector),
+		                 bUnbounded ? TNumericLimits<double>::Max() : EndTime);
+		if (!bUnbounded && FPlatformTime::Seconds() >= EndTime)
+		{
+			break;
+		}
+	}
+}
+
+DungeonCore::DungeonParams ADungeonGenerator::MakeLayoutParams() const
+{
+	DungeonCore::DungeonParams Params;
+	Params.NumberOfCells = NumberOfCells;
+	Params.MinSize = MinSize;
+	Params.MaxSize = FMath::Max(MinSize, MaxSize);
+	Params.SpawnRadius = SpawnRadius;
+	Params.MinDistance = MinDistance;
+	Params.Separation = static_cast<DungeonCore::SeparationMethod>(SeparationMethod);
+	Params.SeparationTolerance = SeparationTolerance;
+	Params.MaxSeparationSteps = FMath::Max(1, MaxSeparationSteps);
+	Params.SnapSize = SnapSize;
+	Params.NumFloors = FMath::Max(1, NumFloors);
+	Params.FloorHeight = FloorHeight;
+	Params.SectionLength = SectionLegnth;
+
+	if (RoomMesh)
+	{
+		const FVector Extent = RoomMesh->GetBounds().BoxExtent;
+		Params.RoomMeshExtent = {Extent.X, Extent.Y, Extent.Z};
+	}
+	return Params;
+}
+
+int32 ADungeonGenerator::AddDungeonRoom(const FVector& Location, const FVector2D& HalfExtent)
+{
+	if (!BeginLayoutEdit())
+	{
+		return INDEX_NONE;
+	}
+
+	DungeonCore::LayoutChanges Changes;
+	const int32 RoomIndex = Editor.AddRoom({Location.X, Location.Y}, {HalfExtent.X, HalfExtent.Y}, GetFloorAt(Location.Z), Changes);
+	ApplyLayoutChanges(Changes);
+	return RoomIndex;
+}
+
+bool ADungeonGenerator::RemoveDungeonRoom(int32 RoomIndex)
+{
+	DungeonCore::LayoutChanges Changes;
+	if (!BeginLayoutEdit() || !Editor.RemoveRoom(RoomIndex, Changes))
+	{
+		return false;
+	}
+	ApplyLayoutChanges(Changes);
+	return true;
+}
+
+bool ADungeonGenerator::MoveDungeonRoom(int32 RoomIndex, const FVector& Location)
+{
+	DungeonCore::LayoutChanges Changes;
+	if (!BeginLayoutEdit() || !Editor.MoveRoom(RoomIndex, {Location.X, Location.Y}, Changes))
+	{
+		return false;
+	}
+	ApplyLayoutChanges(Changes);
+	return true;
+}
+
+int32 ADungeonGenerator::FindDungeonRoomAt(const FVector& Location) const
+{
+	const int32 Floor = GetFloorAt(Location.Z);
+	for (int32 RoomIndex = 0; RoomIndex < static_cast<int32>(Layout.Rooms.size()); ++RoomIndex)
+	{
+		const DungeonCore::Room& Current = Layout.GetRoom(RoomIndex);
+		if (Current.Floor == Floor && Current.Bounds.Overlap({Location.X, Location.Y}))
+		{
+			return RoomIndex;
+		}
+	}
+	return INDEX_NONE;
+}
+
+bool ADungeonGenerator::FindDungeonPath(const FVector& Start, const FVector& End, TArray<FVector>& OutWaypoints)
+{
+	OutWaypoints.Reset();
+	std::vector<DungeonCore::Vec3> Waypoints;
+	if (!BeginNavigation() || !Navigator.FindWaypoints({Start.X, Start.Y, Start.Z}, {End.X, End.Y, End.Z}, Waypoints))
+	{
+		return false;
+	}
+
+	OutWaypoints.Reserve(static_cast<int32>(Waypoints.size()));
+	for (const DungeonCore::Vec3& Waypoint : Waypoints)
+	{
+		OutWaypoints.Add(FVector(Waypoint.X, Waypoint.Y, Waypoint.Z));
+	}
+	return true;
+}
+
+float ADungeonGenerator::GetDungeonRoomDistance(int32 FromRoom, int32 ToRoom)
+{
+	return BeginNavigation() ? static_cast<float>(Navigator.GetDistance(FromRoom, ToRoom)) : -1.f;
+}
+
+FBox ADungeonGenerator::GetDungeonBounds() const
+{
+	FBox Bounds(ForceInit);
+	for (const DungeonCore::Room& Current : Layout.Rooms)
+	{
+		const DungeonCore::Cell& Source = Layout.Cells[Current.CellIndex];
+		const FVector Center(Current.GetCenter().X, Current.GetCenter().Y, Layout.GetFloorZ(Current.Floor));
+		Bounds += FBox::BuildAABB(Center, FVector(Current.GetHalfExtent().X, Current.GetHalfExtent().Y, Source.HalfExtent.Z));
+	}
+
+	const double HalfSection = LayoutParams.SectionLength / 2.;
+	for (const DungeonCore::Vec3& Tile : Layout.CorridorTiles)
+	{
+		Bounds += FBox::BuildAABB(FVector(Tile.X, Tile.Y, Tile.Z), FVector(HalfSection, HalfSection, HalfSection));
+	}
+	return Bounds;
+}
+
+uint32 ADungeonGenerator::NextSeed()
+{
+	if (bRandomizeSeed)
+	{
+		Seed = FMath::Rand();
+	}
+	return static_cast<uint32>(Seed);
+}
+
+void ADungeonGenerator::CancelGeneration()
+{
+	if (ActiveJob)
+	{
+		ActiveJob->Progress.Cancel();
+		ActiveJob.Reset();
+	}
+}
+
+void ADungeonGenerator::FinishGeneration(const TSharedPtr<FDungeonGenerationJob, ESPMode::ThreadSafe>& Job)
+{
+	// A cancelled or superseded job may still complete, only the active one gets spawned
+	if (Job != ActiveJob)
+	{
+		return;
+	}
+	ActiveJob.Reset();
+
+	if (!Job->Result || !GetWorld())
+	{
+		return;
+	}
+
+	Layout = *Job->Result;
+	Editor = DungeonCore::LayoutEditor();
+	Navigator.Reset();
+	LayoutParams = Job->Params;
+	LayoutSeed = Job->Seed;
+	PublishStats(Job->bFromCache);
+	OnDungeonGenerated.Broadcast();
+	MaterializeLayout();
+}
+
+void ADungeonGenerator::MaterializeLayout()
+{
+	MergeCorridors(Layout, LayoutParams.SectionLength, Geometry);
+
+	// Hidden filler cells are only needed by the actor path, instanced output skips them
+	MaterializeQueue.Reset(Layout, OutputMode == EDungeonOutputMode::Actors,
+	                       Geometry.bMergedCorridors ? &Geometry.Strips : nullptr, Geometry.SectionLength);
+	LastStats.NumCorridorPieces = static_cast<int32>(Geometry.bMergedCorridors ? Geometry.Strips.size() : Layout.CorridorTiles.size());
+	UpdateMaterializeFocus();
+
+	// Editor worlds do not tick actors, and a budget of zero asks for everything at once. An empty queue
+	// would never turn the tick on, it finishes here so OnDungeonMaterialized still fires.
+	if (MaterializeBudgetMs <= 0.f || !GetWorld()->IsGameWorld() || MaterializeQueue.NumPending() == 0)
+	{
+		ProcessMaterializeQueue(TNumericLimits<double>::Max());
+	}
+	else
+	{
+		UpdateTickEnabled();
+	}
+}
+
+void ADungeonGenerator::PublishStats(bool bFromCache)
+{
+	const DungeonCore::GenerationStats& Stats = Layout.Stats;
+	LastStats = FDungeonGenerationStats();
+	LastStats.SpawnMs = Stats.SpawnMs;
+	LastStats.SeparationMs = Stats.SeparationMs;
+	LastStats.SelectRoomsMs = Stats.SelectRoomsMs;
+	LastStats.TriangulationMs = Stats.TriangulationMs;
+	LastStats.SpanningTreeMs = Stats.SpanningTreeMs;
+	LastStats.LoopEdgesMs = Stats.LoopEdgesMs;
+	LastStats.CorridorsMs = Stats.CorridorsMs;
+	LastStats.GenerateMs = bFromCache ? 0.f : Stats.TotalMs;
+	LastStats.bFromCache = bFromCache;
+	LastStats.SeparationSteps = Layout.SeparationSteps;
+	LastStats.bSeparationConverged = Stats.bSeparationConverged;
+	LastStats.NumCells = static_cast<int32>(Layout.Cells.size());
+	LastStats.NumRooms = static_cast<int32>(Layout.Rooms.size());
+	LastStats.NumTriangles = Stats.NumTriangles;
+	LastStats.NumEdges = static_cast<int32>(Layout.Edges.size());
+	LastStats.NumLoopEdges = Stats.NumLoopEdges;
+	LastStats.NumCorridorTiles = static_cast<int32>(Layout.CorridorTiles.size());
+	LastStats.NumStairs = static_cast<int32>(Layout.Stairs.size());
+	LastStats.PeakMemoryBytes = static_cast<int64>(Stats.PeakBytes);
+
+	SET_FLOAT_STAT(STAT_DungeonSpawnMs, LastStats.SpawnMs);
+	SET_FLOAT_STAT(STAT_DungeonSeparationMs, LastStats.SeparationMs);
+	SET_FLOAT_STAT(STAT_DungeonSelectRoomsMs, LastStats.SelectRoomsMs);
+	SET_FLOAT_STAT(STAT_DungeonTriangulationMs, LastStats.TriangulationMs);
+	SET_FLOAT_STAT(STAT_DungeonSpanningTreeMs, LastStats.SpanningTreeMs);
+	SET_FLOAT_STAT(STAT_DungeonLoopEdgesMs, LastStats.LoopEdgesMs);
+	SET_FLOAT_STAT(STAT_DungeonCorridorsMs, LastStats.CorridorsMs);
+	SET_FLOAT_STAT(STAT_DungeonGenerateMs, LastStats.GenerateMs);
+	SET_DWORD_STAT(STAT_DungeonSeparationSteps, LastStats.SeparationSteps);
+	SET_DWORD_STAT(STAT_DungeonCells, LastStats.NumCells);
+	SET_DWORD_STAT(STAT_DungeonRooms, LastStats.NumRooms);
+	SET_DWORD_STAT(STAT_DungeonTriangles, LastStats.NumTriangles);
+	SET_DWORD_STAT(STAT_DungeonEdges, LastStats.NumEdges);
+	SET_DWORD_STAT(STAT_DungeonCorridorTiles, LastStats.NumCorridorTiles);
+	SET_MEMORY_STAT(STAT_DungeonPeakMemory, LastStats.PeakMemoryBytes);
+}
+
+bool ADungeonGenerator::BeginLayoutEdit()
+{
+	// Streamed sectors come and go with the player, only a single layout is edited
+	if (!GetWorld() || bStreaming || Layout.Rooms.empty())
+	{
+		return false;
+	}
+
+	// Queued items refer to the layout by index, which edits shuffle
+	if (MaterializeQueue.NumPending() > 0)
+	{
+		ProcessMaterializeQueue(TNumericLimits<double>::Max());
+	}
+
+	if (!Editor.IsValid())
+	{
+		Editor.Init(LayoutParams, LayoutSeed, Layout);
+	}
+	return true;
+}
+
+bool ADungeonGenerator::BeginNavigation()
+{
+	// Like edits, paths are only found on a single layout, streamed sectors are not linked to each other
+	if (bStreaming || Layout.Rooms.empty())
+	{
+		return false;
+	}
+
+	if (!Navigator.IsValid())
+	{
+		Navigator.Init(Layout, FMath::Max(1, MaxCachedPathTargets));
+	}
+	return true;
+}
+
+int32 ADungeonGenerator::GetFloorAt(double Z) const
+{
+	return Layout.FloorHeight > 0. ? FMath::FloorToInt32(Z / Layout.FloorHeight) : 0;
+}
+
+void ADungeonGenerator::ApplyLayoutChanges(const DungeonCore::LayoutChanges& Changes)
+{
+	const bool bInstanced = OutputMode == EDungeonOutputMode::Instanced;
+
+	// Edges and room indices changed, the next path query builds the graph again
+	Navigator.Reset();
+
+	// Everything going away first, so new corridor tiles do not collide with the ones they replace
+	TSet<FIntVector> RemovedRooms;
+	for (const DungeonCore::Room& Removed : Changes.RemovedRooms)
+	{
+		const FVector Location(Removed.Bounds.Origin.X, Removed.Bounds.Origin.Y, Layout.GetFloorZ(Removed.Floor));
+		Geometry.Rooms.RemoveSingleSwap(Location, false);
+		if (bInstanced)
+		{
+			RemovedRooms.Add(ToLocationKey(Location));
+			continue;
+		}
+
+		// Room actors may have been nudged out of a collision when spawned, take the nearest visible one on the room
+		int32 Nearest = INDEX_NONE;
+		double NearestDistance = FMath::Square(FMath::Max(Removed.Bounds.Extent.X, Removed.Bounds.Extent.Y));
+		for (int32 CellIndex = 0; CellIndex < Geometry.Cells.Num(); ++CellIndex)
+		{
+			const AStaticMeshActor* Cell = Geometry.Cells[CellIndex];
+			if (!IsValid(Cell) || !Cell->GetStaticMeshComponent()->IsVisible())
+			{
+				continue;
+			}
+			const double Distance = FVector::DistSquared(Cell->GetActorLocation(), Location);
+			if (Distance <= NearestDistance)
+			{
+				Nearest = CellIndex;
+				NearestDistance = Distance;
+			}
+		}
+		if (Nearest != INDEX_NONE)
+		{
+			ReleaseMeshActor(Geometry.Cells[Nearest], PooledCells);
+			Geometry.Cells.RemoveAtSwap(Nearest, 1, false);
+		}
+	}
+
+	// Merged corridors swap the strips the edit cut into for new ones, the rest of each corridor stays spawned
+	std::vector<DungeonCore::CorridorStrip> RemovedStrips;
+	std::vector<DungeonCore::CorridorStrip> AddedStrips;
+	TSet<FIntVector> RemovedPaths;
+	if (Geometry.bMergedCorridors)
+	{
+		DungeonCore::UpdateCorridorStrips(Geometry.Strips, Changes.RemovedTiles, Changes.AddedTiles, Geometry.SectionLength,
+		                                  RemovedStrips, AddedStrips);
+		for (const DungeonCore::CorridorStrip& Strip : RemovedStrips)
+		{
+			RemovedPaths.Add(ToLocationKey(MakeStripTransform(Strip, Geometry.SectionLength).GetLocation()));
+		}
+	}
+	else
+	{
+		for (const DungeonCore::Vec3& Tile : Changes.RemovedTiles)
+		{
+			RemovedPaths.Add(ToLocationKey(FVector(Tile.X, Tile.Y, Tile.Z)));
+		}
+	}
+	TSet<FIntVector> RemovedStairs;
+	for (const DungeonCore::Stairwell& Stair : Changes.RemovedStairs)
+	{
+		RemovedStairs.Add(ToLocationKey(MakeStairTransform(Stair, Layout).GetLocation()));
+	}
+
+	if (bInstanced)
+	{
+		RemoveInstancesAt(Geometry.RoomInstances, RemovedRooms);
+		RemoveInstancesAt(Geometry.PathInstances, RemovedPaths);
+		RemoveInstancesAt(Geometry.StairInstances, RemovedStairs);
+	}
+	else
+	{
+		// Stairs share the path pool and array with corridor tiles
+		RemovedPaths.Append(RemovedStairs);
+		ReleaseActorsAt(Geometry.Paths, PooledPaths, RemovedPaths);
+	}
+
+	TArray<FTransform> RoomTransforms;
+	for (const DungeonCore::Room& Added : Changes.AddedRooms)
+	{
+		const DungeonCore::Cell& LayoutCell = Layout.Cells[Added.CellIndex];
+		const FVector Location(LayoutCell.Location.X, LayoutCell.Location.Y, Layout.GetFloorZ(LayoutCell.Floor));
+		if (bInstanced)
+		{
+			RoomTransforms.Emplace(FRotator::ZeroRotator, Location,
+			                       FVector(LayoutCell.Scale.X, LayoutCell.Scale.Y, LayoutCell.Scale.Z));
+			Geometry.Rooms.Add(Location);
+		}
+		else
+		{
+			SpawnCellActor(LayoutCell, Location, Geometry);
+		}
+	}
+
+	TArray<FTransform> PathTransforms;
+	for (const DungeonCore::CorridorStrip& Strip : AddedStrips)
+	{
+		if (bInstanced)
+		{
+			PathTransforms.Add(MakeStripTransform(Strip, Geometry.SectionLength));
+		}
+		else
+		{
+			SpawnStripActor(MakeStripTransform(Strip, Geometry.SectionLength), Geometry);
+		}
+	}
+	if (!Geometry.bMergedCorridors)
+	{
+		for (const DungeonCore::Vec3& Tile : Changes.AddedTiles)
+		{
+			if (bInstanced)
+			{
+				PathTransforms.Emplace(FVector(Tile.X, Tile.Y, Tile.Z));
+			}
+			else
+			{
+				SpawnPathActor(Tile, Geometry);
+			}
+		}
+	}
+
+	TArray<FTransform> StairTransforms;
+	for (const DungeonCore::Stairwell& Stair : Changes.AddedStairs)
+	{
+		if (bInstanced)
+		{
+			StairTransforms.Add(MakeStairTransform(Stair, Layout));
+		}
+		else
+		{
+			SpawnStairActor(MakeStairTransform(Stair, Layout), Geometry);
+		}
+	}
+
+	if (bInstanced)
+	{
+		if (RoomTransforms.Num() > 0)
+		{
+			AddInstanceBatch(GetOrCreateInstances(Geometry.RoomInstances, RoomMesh, TEXT("RoomInstances")), RoomTransforms, RoomColor, 0.f);
+		}
+		if (PathTransforms.Num() > 0)
+		{
+			AddInstanceBatch(GetOrCreateInstances(Geometry.PathInstances, PathMesh, TEXT("PathInstances")), PathTransforms, PathColor, 1.f);
+		}
+		if (StairTransforms.Num() > 0)
+		{
+			AddInstanceBatch(GetOrCreateInstances(Geometry.StairInstances, GetStairMesh(), TEXT("StairInstances")),
+			                 StairTransforms, PathColor, 1.f);
+		}
+	}
+
+	// Stage timings still describe the generation the edits started from
+	LastStats.NumRooms = static_cast<int32>(Layout.Rooms.size());
+	LastStats.NumEdges = static_cast<int32>(Layout.Edges.size());
+	LastStats.NumLoopEdges = Layout.Stats.NumLoopEdges;
+	LastStats.NumCorridorTiles = static_cast<int32>(Layout.CorridorTiles.size());
+	LastStats.NumStairs = static_cast<int32>(Layout.Stairs.size());
+	LastStats.NumCorridorPieces = static_cast<int32>(Geometry.bMergedCorridors ? Geometry.Strips.size() : Layout.CorridorTiles.size());
+	SET_DWORD_STAT(STAT_DungeonRooms, LastStats.NumRooms);
+	SET_DWORD_STAT(STAT_DungeonEdges, LastStats.NumEdges);
+	SET_DWORD_STAT(STAT_DungeonCorridorTiles, LastStats.NumCorridorTiles);
+}
+
+void ADungeonGenerator::ReleaseActorsAt(TArray<AStaticMeshActor*>& Actors, TArray<AStaticMeshActor*>& Pool,
+                                        TSet<FIntVector>& Locations)
+{
+	// Each location releases one actor, tiles that never spawned because something blocked them are simply not found
+	for (int32 ActorIndex = Actors.Num() - 1; ActorIndex >= 0 && Locations.Num() > 0; --ActorIndex)
+	{
+		AStaticMeshActor* MeshActor = Actors[ActorIndex];
+		if (IsValid(MeshActor) && Locations.Remove(ToLocationKey(MeshActor->GetActorLocation())) > 0)
+		{
+			ReleaseMeshActor(MeshActor, Pool);
+			Actors.RemoveAtSwap(ActorIndex, 1, false);
+		}
+	}
+}
+
+void ADungeonGenerator::RemoveInstancesAt(UHierarchicalInstancedStaticMeshComponent* Instances, TSet<FIntVector>& Locations)
+{
+	if (!Instances || Locations.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<int32> Removed;
+	for (int32 Instance = 0; Instance < Instances->GetInstanceCount() && Locations.Num() > 0; ++Instance)
+	{
+		FTransform Transform;
+		if (Instances->GetInstanceTransform(Instance, Transform, true) &&
+			Locations.Remove(ToLocationKey(Transform.GetLocation())) > 0)
+		{
+			Removed.Add(Instance);
+		}
+	}
+	Instances->RemoveInstances(Removed);
+}
+
+FVector ADungeonGenerator::GetFocusLocation() const
+{
+	// The first local player's view point, or the dungeon centre without one
+	FVector Focus = FVector::ZeroVector;
+	if (const APlayerController* Controller = GetWorld()->GetFirstPlayerController())
+	{
+		FRotator ViewRotation;
+		Controller->GetPlayerViewPoint(Focus, ViewRotation);
+	}
+	return Focus;
+}
+
+void ADungeonGenerator::UpdateMaterializeFocus()
+{
+	const FVector Focus = GetFocusLocation();
+	MaterializeQueue.SetFocus({Focus.X, Focus.Y}, RefocusSections * SectionLegnth);
+}
+
+void ADungeonGenerator::UpdateTickEnabled()
+{
+	SetActorTickEnabled(MaterializeQueue.NumPending() > 0 || bStreaming);
+}
+
+void ADungeonGenerator::ProcessMaterializeQueue(double BudgetSeconds)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(ADungeonGenerator::ProcessMaterializeQueue);
+	SCOPE_CYCLE_COUNTER(STAT_DungeonMaterialize);
+	const double StartTime = FPlatformTime::Seconds();
+	MaterializeItems(MaterializeQueue, Layout, Geometry, StartTime + BudgetSeconds);
+	LastStats.MaterializeMs += static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.);
+
+	if (MaterializeQueue.NumPending() == 0)
+	{
+		UpdateTickEnabled();
+		OnDungeonMaterialized.Broadcast();
+	}
+}
+
+void ADungeonGenerator::MaterializeItems(DungeonCore::MaterializationQueue& Queue, const DungeonCore::DungeonLayout& Source,
+                                         FDungeonGeometry& Target, double EndTime)
+{
+	const bool bInstanced = OutputMode == EDungeonOutputMode::Instanced;
+	const int32 BatchSize = bInstanced ? InstanceBatchSize : ActorBatchSize;
+
+	TArray<FTransform> RoomTransforms;
+	TArray<FTransform> PathTransforms;
+	TArray<FTransform> StairTransforms;
+
+	// At least one batch per call so a tiny budget still makes progress
+	do
+	{
+		DungeonCore::LayoutItem Item;
+		for (int32 InBatch = 0; InBatch < BatchSize && Queue.Pop(Item); ++InBatch)
+		{
+			if (Item.Type == DungeonCore::LayoutItemType::Cell)
+			{
+				const DungeonCore::Cell& LayoutCell = Source.Cells[Item.Index];
+				const FVector Location(LayoutCell.Location.X, LayoutCell.Location.Y, Source.GetFloorZ(LayoutCell.Floor));
+				if (bInstanced)
 				{
-					UMaterialInstanceDynamic* material = UMaterialInstanceDynamic::Create(
-						Cell->GetStaticMeshComponent()->GetMaterial(0), NULL);
-					material->SetVectorParameterValue(FName(TEXT("SurfaceColor")), FLinearColor(0.9f, 0.1f, 0.1f));
-					Cell->GetStaticMeshComponent()->SetMaterial(0, material);
-			
-					Cell->SetActorLocation(RoundM(Cell->GetActorLocation(), SnapSize));
-					Rooms.Add(Cell->GetActorLocation());
-					
-				
-				}else if(UKismetMathLibrary::RandomFloat() > 0.85)
+					RoomTransforms.Emplace(FRotator::ZeroRotator, Location,
+					                       FVector(LayoutCell.Scale.X, LayoutCell.Scale.Y, LayoutCell.Scale.Z));
+					Target.Rooms.Add(Location);
+				}
+				else
 				{
-					UMaterialInstanceDynamic* material = UMaterialInstanceDynamic::Create(
-						Cell->GetStaticMeshComponent()->GetMaterial(0), NULL);
-					material->SetVectorParameterValue(FName(TEXT("SurfaceColor")), FLinearColor(0.9f, 0.1f, 0.1f));
-					Cell->GetStaticMeshComponent()->SetMaterial(0, material);
-
-					Cell->SetActorLocation(RoundM(Cell->GetActorLocation(), SnapSize));
-					Rooms.Add(Cell->GetActorLocation());
+					SpawnCellActor(LayoutCell, Location, Target);
+				}
+			}
+			else if (Item.Type == DungeonCore::LayoutItemType::Strip)
+			{
+				const FTransform Transform = MakeStripTransform(Target.Strips[Item.Index], Target.SectionLength);
+				if (bInstanced)
+				{
+					PathTransforms.Add(Transform);
 				}
 				else
 				{
-					Cell->GetStaticMeshComponent()->SetVisibility(false);
+					SpawnStripActor(Transform, Target);
 				}
 			}
-			
-			auto DT = DelaunayTriangle3D::triangulate<FVector>(Rooms);
-			auto MST = MST::MinimumSpanningTree(DT.edges, DT.edges[0].p0);
-			
-			for (auto Edge : DT.edges)
+			else if (Item.Type == DungeonCore::LayoutItemType::Stair)
 			{
-				if (UKismetMathLibrary::RandomFloat() > 0.9)
+				const FTransform Transform = MakeStairTransform(Source.Stairs[Item.Index], Source);
+				if (bInstanced)
 				{
-					MST.push_back(Edge);
+					StairTransforms.Add(Transform);
+				}
+				else
+				{
+					SpawnStairActor(Transform, Target);
 				}
 			}
-			
-			//Gen Pathways;
-			for (auto Edge : MST)
+			else
 			{
-
-				//DGEdge dgEdge = GetClosestEdge(Edge.p0, Edge.p1);
-				
-				FVector pathLoc = Edge.p1 - Edge.p0;
-				int countX = trunc(pathLoc.X / SectionLegnth);
-				int countY = trunc(pathLoc.Y / SectionLegnth);
-				int dirX = countX < 0 ? -1 : 1;
-				int dirY = countY < 0 ? -1 : 1;
-
-				countX = abs(countX) + (dirX == 1 ? 0 : 1);
-				countY = abs(countY) + (dirY == 1 ? 0 : 1);
-				
-				int TotalBlocksToSpawn = abs(countX) + abs(countY) ;
-			
-				FVector Location;
-				Location.X = Edge.p0.X + SectionLegnth * dirX;
-				Location.Y = Edge.p0.Y + SectionLegnth/2 ;
-				Location.Z = -5;
-			
-				while (TotalBlocksToSpawn > 0)
+				const DungeonCore::Vec3& Tile = Source.CorridorTiles[Item.Index];
+				if (bInstanced)
 				{
-					//spawn Y
-					if (TotalBlocksToSpawn <= abs(countY))
-					{
-						FActorSpawnParameters SpawnParams;
-						SpawnParams.bNoFail = false;
-						SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::DontSpawnIfColliding;
-				
-						Location.Y += SectionLegnth*dirY;
-						//DrawDebugBox(GetWorld(), RoundM(Location, SnapSize), FVector(SectionLegnth/2), FColor::Blue, true);
-						if (!IsOverlappingRoom(Location) && !SpawnedPath.ContainsByPredicate(
-							[&](AStaticMeshActor* path){return Location == path->GetActorLocation();}))
-						{
-							auto path = GetWorld()->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), Location,
-																	 FRotator::ZeroRotator, SpawnParams);
-						
-							path->SetMobility(EComponentMobility::Movable);
-							path->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
-							path->GetStaticMeshComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-							path->GetStaticMeshComponent()->SetCollisionObjectType(ECC_WorldDynamic);
-							path->GetStaticMeshComponent()->SetCollisionResponseToAllChannels(ECR_Block);
-							path->GetStaticMeshComponent()->SetStaticMesh(PathMesh);
-							SpawnedPath.Add(path);
-						}
-						--TotalBlocksToSpawn;
-						continue;
-					}
-			
-					//spawn x
-					FActorSpawnParameters SpawnParams;
-					SpawnParams.bNoFail = false;
-					SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::DontSpawnIfColliding;
-				
-					Location.X += SectionLegnth*dirX;
-					//DrawDebugBox(GetWorld(),  RoundM(Location, SnapSize), FVector(SectionLegnth/2), FColor::Blue, true);
-					if (!IsOverlappingRoom(Location) && !SpawnedPath.ContainsByPredicate(
-						[&](AStaticMeshActor* path){return Location == path->GetActorLocation();}))
-					{
-						auto path = GetWorld()->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), Location,
-																 FRotator::ZeroRotator, SpawnParams);
-						
-						path->SetMobility(EComponentMobility::Movable);
-						path->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
-						path->GetStaticMeshComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-						path->GetStaticMeshComponent()->SetCollisionObjectType(ECC_WorldDynamic);
-						path->GetStaticMeshComponent()->SetCollisionResponseToAllChannels(ECR_Block);
-						path->GetStaticMeshComponent()->SetStaticMesh(PathMesh);
-						SpawnedPath.Add(path);
-					}
-					--TotalBlocksToSpawn;
+					PathTransforms.Emplace(FVector(Tile.X, Tile.Y, Tile.Z));
+				}
+				else
+				{
+					SpawnPathActor(Tile, Target);
 				}
-			
-				//DrawDebugLine(GetWorld(), Edge.p0, Edge.p1, FColor::Yellow, true);
 			}
-
-			bIsDungeonGenerating = false;
 		}
-		else
+
+		if (bInstanced)
 		{
-			FVector Vel = FVector::ZeroVector;
-			for (const auto Cell : SpawnedCells)
+			if (RoomTransforms.Num() > 0)
 			{
-				//Separate
-				
-				const FVector Force = Separate(Cell);
-				Vel += Force;
-				Cell->SetActorLocation(Cell->GetActorLocation() + Force);
-				//Determine which cells can be rooms
+				AddInstanceBatch(GetOrCreateInstances(Target.RoomInstances, RoomMesh, TEXT("RoomInstances")), RoomTransforms, RoomColor, 0.f);
 			}
-
-			bIsSeparating = Vel != FVector::ZeroVector;
+			if (PathTransforms.Num() > 0)
+			{
+				AddInstanceBatch(GetOrCreateInstances(Target.PathInstances, PathMesh, TEXT("PathInstances")), PathTransforms, PathColor, 1.f);
+			}
+			if (StairTransforms.Num() > 0)
+			{
+				AddInstanceBatch(GetOrCreateInstances(Target.StairInstances, GetStairMesh(), TEXT("StairInstances")),
+				                 StairTransforms, PathColor, 1.f);
+			}
+			RoomTransforms.Reset();
+			PathTransforms.Reset();
+			StairTransforms.Reset();
 		}
 	}
+	while (Queue.NumPending() > 0 && FPlatformTime::Seconds() < EndTime);
 }
 
-FVector ADungeonGenerator::Separate(AStaticMeshActor* CurrentCell)
+void ADungeonGenerator::ReleaseGeometry(FDungeonGeometry& Target, bool bKeepComponents)
 {
-	FVector Velocity = FVector::ZeroVector;
-	int NeighborCount = 0;
+	for (const auto Cell : Target.Cells)
+	{
+		ReleaseMeshActor(Cell, PooledCells);
+	}
+
+	for (const auto Path : Target.Paths)
+	{
+		ReleaseMeshActor(Path, PooledPaths);
+	}
 
-	for (const auto Cell : SpawnedCells)
+	for (UHierarchicalInstancedStaticMeshComponent* Instances : {Target.RoomInstances, Target.PathInstances, Target.StairInstances})
 	{
-		if (Cell != CurrentCell)
+		if (!Instances)
 		{
-			FVector currentLoc = CurrentCell->GetActorLocation();
-			FVector targetLoc = Cell->GetActorLocation();
-			const float Distance = FVector::DistXY(currentLoc, targetLoc);
+			continue;
+		}
 
-			if (Distance == 0)
-			{
-				NeighborCount = 1;
-				Velocity = FVector(MinDistance, MinDistance, 0.);
-			}
-			
-			if (Distance <= MinDistance)
-			{
-				Bounds b;
-				CurrentCell->GetActorBounds(true, b.Origin, b.Extent);
-				Velocity += (currentLoc - targetLoc) / b.Extent.Length();
-				NeighborCount++;
-			}
+		if (bKeepComponents)
+		{
+			Instances->ClearInstances();
+		}
+		else
+		{
+			ReleaseInstances(Instances);
+		}
+	}
+
+	// Reset keeps the allocations for the next layout
+	Target.Cells.Reset();
+	Target.Paths.Reset();
+	Target.Rooms.Reset();
+	Target.Strips.clear();
+	if (!bKeepComponents)
+	{
+		Target.RoomInstances = nullptr;
+		Target.PathInstances = nullptr;
+		Target.StairInstances = nullptr;
+	}
+}
+
+void ADungeonGenerator::SpawnCellActor(const DungeonCore::Cell& LayoutCell, const FVector& Location,
+                                       FDungeonGeometry& Target)
+{
+	FActorSpawnParameters CellSpawnParams;
+	CellSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	AStaticMeshActor* Cell = SpawnMeshActor(RoomMesh, Location, CellSpawnParams, PooledCells);
+	if (!Cell)
+	{
+		return;
+	}
+
+	Cell->SetActorScale3D(FVector(LayoutCell.Scale.X, LayoutCell.Scale.Y, LayoutCell.Scale.Z));
+	if (LayoutCell.bIsRoom)
+	{
+		// A pooled room still carries its colour instance, only cells coming fresh or from filler duty need one
+		UMaterialInstanceDynamic* material = Cast<UMaterialInstanceDynamic>(Cell->GetStaticMeshComponent()->GetMaterial(0));
+		if (!material || material->Parent != RoomMesh->GetMaterial(0))
+		{
+			material = UMaterialInstanceDynamic::Create(RoomMesh->GetMaterial(0), NULL);
+			material->SetVectorParameterValue(FName(TEXT("SurfaceColor")), RoomColor);
+			Cell->GetStaticMeshComponent()->SetMaterial(0, material);
 		}
+		Target.Rooms.Add(Location);
 	}
+	else
+	{
+		Cell->GetStaticMeshComponent()->SetVisibility(false);
+	}
+	Target.Cells.Add(Cell);
+}
+
+void ADungeonGenerator::SpawnPathActor(const DungeonCore::Vec3& Tile, FDungeonGeometry& Target)
+{
+	FActorSpawnParameters PathSpawnParams;
+	PathSpawnParams.bNoFail = false;
+	PathSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::DontSpawnIfColliding;
 
-	if (NeighborCount == 0)
+	if (AStaticMeshActor* Path = SpawnMeshActor(PathMesh, FVector(Tile.X, Tile.Y, Tile.Z), PathSpawnParams, PooledPaths))
 	{
-		return FVector::ZeroVector;
+		Target.Paths.Add(Path);
 	}
+}
+
+void ADungeonGenerator::SpawnStairActor(const FTransform& Transform, FDungeonGeometry& Target)
+{
+	// The stairwell runs through both corridor tiles it links, it has to spawn regardless
+	FActorSpawnParameters StairSpawnParams;
+	StairSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
 
-	Velocity /= NeighborCount;
-	Velocity.Normalize(1);
-	return Velocity*100;
+	if (AStaticMeshActor* Stair = SpawnMeshActor(GetStairMesh(), Transform.GetLocation(), StairSpawnParams, PooledPaths))
+	{
+		Stair->SetActorScale3D(Transform.GetScale3D());
+		Target.Paths.Add(Stair);
+	}
 }
 
-FVector ADungeonGenerator::GetRandomPointInCircle(float radius)
+void ADungeonGenerator::SpawnStripActor(const FTransform& Transform, FDungeonGeometry& Target)
 {
-	float t = 2 * UKismetMathLibrary::GetPI() * UKismetMathLibrary::RandomFloat();
-	float u = UKismetMathLibrary::RandomFloat() + UKismetMathLibrary::RandomFloat();
-	float r = u > 1 ? 2 - u : u;
+	// Strips never overlap each other and no tile lies inside a room: the router lays corridors around rooms
+	// and the editor routes again any corridor an added or moved room lands on. A collision check would drop
+	// a whole run where the single tile version only lost one tile.
+	FActorSpawnParameters StripSpawnParams;
+	StripSpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
 
-	return FVector(RoundM(radius * r * UKismetMathLibrary::Cos(t), SnapSize),
-	               RoundM(radius * r * UKismetMathLibrary::Sin(t), SnapSize), 0);
+	if (AStaticMeshActor* Strip = SpawnMeshActor(PathMesh, Transform.GetLocation(), StripSpawnParams, PooledPaths))
+	{
+		Strip->SetActorScale3D(Transform.GetScale3D());
+		Target.Paths.Add(Strip);
+	}
 }
 
-int ADungeonGenerator::RoundM(float loc, int snapSize)
+void ADungeonGenerator::MergeCorridors(const DungeonCore::DungeonLayout& Source, double SectionLength,
+                                       FDungeonGeometry& Target) const
 {
-	return FMath::Floor(((loc + SnapSize - 1) / SnapSize)) * SnapSize;
+	Target.SectionLength = SectionLength;
+	Target.bMergedCorridors = bMergeCorridorTiles;
+	if (bMergeCorridorTiles)
+	{
+		Target.Strips = DungeonCore::MergeCorridorTiles(Source.CorridorTiles, SectionLength);
+	}
+	else
+	{
+		Target.Strips.clear();
+	}
 }
 
+UStaticMesh* ADungeonGenerator::GetStairMesh() const
+{
+	return StairMesh ? StairMesh : PathMesh;
+}
 
-FVector ADungeonGenerator::RoundM(FVector loc, int snapSize)
+FTransform ADungeonGenerator::MakeStairTransform(const DungeonCore::Stairwell& Stair,
+                                                 const DungeonCore::DungeonLayout& Source) const
 {
-	return FVector(FMath::Floor(((loc.X + SnapSize - 1) / SnapSize)) * SnapSize,
-								FMath::Floor(((loc.Y + SnapSize - 1) / SnapSize)) * SnapSize,
-								0) ;
+	// Centred between the two floors and stretched from one to the other
+	const UStaticMesh* Mesh = GetStairMesh();
+	const double MeshHeight = Mesh ? 2. * Mesh->GetBounds().BoxExtent.Z : 0.;
+	const double ScaleZ = MeshHeight > 0. ? Source.FloorHeight / MeshHeight : 1.;
+	const FVector Location(Stair.Location.X, Stair.Location.Y, Source.GetFloorZ(Stair.LowerFloor) + Source.FloorHeight / 2.);
+	return FTransform(FRotator::ZeroRotator, Location, FVector(1., 1., ScaleZ));
 }
 
+void ADungeonGenerator::AddInstanceBatch(UHierarchicalInstancedStaticMeshComponent* Instances,
+                                         const TArray<FTransform>& Transforms, const FLinearColor& Color, float Type)
+{
+	if (Transforms.IsEmpty())
+	{
+		return;
+	}
+
+	const int32 FirstInstance = Instances->GetInstanceCount();
+	Instances->AddInstances(Transforms, false, true);
 
-Bounds ADungeonGenerator::GetRoomExtentByLocation(FVector Location)
+	const float CustomData[NumInstanceCustomData] = {Color.R, Color.G, Color.B, Type};
+	for (int32 Instance = FirstInstance; Instance < Instances->GetInstanceCount(); ++Instance)
+	{
+		Instances->SetCustomData(Instance, MakeArrayView(CustomData, NumInstanceCustomData), false);
+	}
+	Instances->MarkRenderStateDirty();
+}
+
+UHierarchicalInstancedStaticMeshComponent* ADungeonGenerator::GetOrCreateInstances(
+	UHierarchicalInstancedStaticMeshComponent*& Instances, UStaticMesh* Mesh, FName Name)
 {
-	const auto room = *SpawnedCells.FindByPredicate(
-			[Location](const AStaticMeshActor* MeshActor){return MeshActor->GetActorLocation() == Location;});
-	Bounds bounds;
-	room->GetActorBounds(true, bounds.Origin, bounds.Extent);
-	return bounds;
+	if (!Instances && PooledInstances.Num() > 0)
+	{
+		Instances = PooledInstances.Pop(false);
+		Instances->SetVisibility(true);
+	}
+
+	if (!Instances)
+	{
+		// Sectors each get their own components, so the name only serves as a prefix
+		Instances = NewObject<UHierarchicalInstancedStaticMeshComponent>(
+			this, MakeUniqueObjectName(this, UHierarchicalInstancedStaticMeshComponent::StaticClass(), Name));
+		Instances->NumCustomDataFloats = NumInstanceCustomData;
+		Instances->SetMobility(GetRootComponent() ? GetRootComponent()->Mobility.GetValue() : EComponentMobility::Static);
+		Instances->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+		Instances->SetCollisionObjectType(ECC_WorldDynamic);
+		Instances->SetCollisionResponseToAllChannels(ECR_Block);
+
+		if (GetRootComponent())
+		{
+			Instances->SetupAttachment(GetRootComponent());
+		}
+		else
+		{
+			SetRootComponent(Instances);
+		}
+		Instances->RegisterComponent();
+		AddInstanceComponent(Instances);
+	}
+
+	Instances->SetStaticMesh(Mesh);
+	return Instances;
 }
 
-DGEdge ADungeonGenerator::GetClosestEdge(FVector start, FVector end)
+AStaticMeshActor* ADungeonGenerator::SpawnMeshActor(UStaticMesh* Mesh, const FVector& Location,
+                                                    const FActorSpawnParameters& SpawnParams,
+                                                    TArray<AStaticMeshActor*>& Pool)
 {
-	Bounds b0 = GetRoomExtentByLocation(start);
-	Bounds b1 = GetRoomExtentByLocation(end);
-	
-	TArray<DGEdge> sortarr;
+	if (Pool.Num() > 0)
+	{
+		return ReuseMeshActor(Mesh, Location, SpawnParams, Pool);
+	}
 
-	//start bound
-	FVector p01 = FVector( start.X ,start.Y - b0.Extent.Y, start.Z);
-	FVector p02 = FVector( start.X + b0.Extent.X, start.Y, start.Z);
-	FVector p03 = FVector( start.X ,start.Y + b0.Extent.Y, start.Z);
-	FVector p04 = FVector( start.X - b0.Extent.X, start.Y, start.Z);
+	auto MeshActor = GetWorld()->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), Location,
+	                                                          FRotator::ZeroRotator, SpawnParams);
+	if (!MeshActor)
+	{
+		return nullptr;
+	}
+	++LastStats.ActorsSpawned;
 
-	//end bounds
-	FVector p11 = FVector( end.X ,end.Y - b1.Extent.Y, end.Z);
-	FVector p12 = FVector( end.X + b1.Extent.X, end.Y, end.Z);
-	FVector p13 = FVector( end.X ,end.Y + b1.Extent.Y, end.Z);
-	FVector p14 = FVector( end.X - b1.Extent.X, end.Y, end.Z);
-	
-	// FVector P02P14 = FVector(end.X - b1.Extent.X, end.Y, end.Z) - FVector( start.X + b0.Extent.X, start.Y, start.Z);
-	// FVector P02P13 = FVector(end.X, end.Y + b1.Extent.Y, end.Z) - FVector( start.X + b0.Extent.X, start.Y, start.Z);
-	// FVector P01P14 = FVector(end.X - b1.Extent.X, end.Y, end.Z) - FVector( start.X ,start.Y - b0.Extent.Y, start.Z);
-	// FVector P01P13 = FVector(end.X, end.Y + b1.Extent.Y, end.Z) - FVector( start.X, start.Y - b0.Extent.Y, start.Z);
+	MeshActor->SetMobility(EComponentMobility::Movable);
+	MeshActor->GetStaticMeshComponent()->SetMobility(EComponentMobility::Movable);
+	MeshActor->GetStaticMeshComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	MeshActor->GetStaticMeshComponent()->SetCollisionObjectType(ECC_WorldDynamic);
+	MeshActor->GetStaticMeshComponent()->SetCollisionResponseToAllChannels(ECR_Block);
+	MeshActor->GetStaticMeshComponent()->SetStaticMesh(Mesh);
+	return MeshActor;
+}
 
-	sortarr.Add({p01, p11, static_cast<int>(FVector::Distance(p11, p01))});
-	sortarr.Add({p01, p12, static_cast<int>(FVector::Distance(p12, p01))});
-	sortarr.Add({p01, p13, static_cast<int>(FVector::Distance(p13, p01))});
-	sortarr.Add({p01, p14, static_cast<int>(FVector::Distance(p14, p01))});
-	
-	sortarr.Add({p02, p11, static_cast<int>(FVector::Distance(p11, p02))});
-	sortarr.Add({p02, p12, static_cast<int>(FVector::Distance(p12, p02))});
-	sortarr.Add({p02, p13, static_cast<int>(FVector::Distance(p13, p02))});
-	sortarr.Add({p02, p14, static_cast<int>(FVector::Distance(p14, p02))});
-	
-	sortarr.Add({p03, p11, static_cast<int>(FVector::Distance(p11, p03))});
-	sortarr.Add({p03, p12, static_cast<int>(FVector::Distance(p12, p03))});
-	sortarr.Add({p03, p13, static_cast<int>(FVector::Distance(p13, p03))});
-	sortarr.Add({p03, p14, static_cast<int>(FVector::Distance(p14, p03))});
-	
-	sortarr.Add({p04, p11, static_cast<int>(FVector::Distance(p11, p04))});
-	sortarr.Add({p04, p12, static_cast<int>(FVector::Distance(p12, p04))});
-	sortarr.Add({p04, p13, static_cast<int>(FVector::Distance(p13, p04))});
-	sortarr.Add({p04, p14, static_cast<int>(FVector::Distance(p14, p04))});
+AStaticMeshActor* ADungeonGenerator::ReuseMeshActor(UStaticMesh* Mesh, const FVector& Location,
+                                                    const FActorSpawnParameters& SpawnParams,
+                                                    TArray<AStaticMeshActor*>& Pool)
+{
+	AStaticMeshActor* MeshActor = Pool.Pop(false);
+	SET_DWORD_STAT(STAT_DungeonPooledActors, GetNumPooledActors());
+	if (!IsValid(MeshActor))
+	{
+		// Destroyed behind our back, e.g. by a level reload, fall back to the next one or a fresh one
+		return SpawnMeshActor(Mesh, Location, SpawnParams, Pool);
+	}
+
+	// Back to what SpawnMeshActor hands out, room colour and visibility are set again by the caller
+	UStaticMeshComponent* MeshComponent = MeshActor->GetStaticMeshComponent();
+	MeshComponent->SetStaticMesh(Mesh);
+	MeshComponent->SetVisibility(true);
+	MeshActor->SetActorScale3D(FVector::OneVector);
+	MeshActor->SetActorLocation(Location, false, nullptr, ETeleportType::ResetPhysics);
+	MeshActor->SetActorEnableCollision(true);
 
-	sortarr.Sort();
+	// Same rule SpawnActor applies, corridor tiles never go where something already blocks
+	if (SpawnParams.SpawnCollisionHandlingOverride == ESpawnActorCollisionHandlingMethod::DontSpawnIfColliding &&
+		GetWorld()->EncroachingBlockingGeometry(MeshActor, Location, FRotator::ZeroRotator))
+	{
+		ReleaseMeshActor(MeshActor, Pool);
+		return nullptr;
+	}
 
-	return sortarr[0];
+	++LastStats.ActorsReused;
+	return MeshActor;
 }
 
-bool ADungeonGenerator::IsOverlappingRoom(FVector loc)
+void ADungeonGenerator::ReleaseMeshActor(AStaticMeshActor* MeshActor, TArray<AStaticMeshActor*>& Pool)
 {
-	TArray<AStaticMeshActor*> rooms = SpawnedCells.FilterByPredicate([](AStaticMeshActor* cell)
-											  {return cell->GetStaticMeshComponent()->IsVisible(); });
-	
-	for (auto Room : rooms)
+	if (!IsValid(MeshActor))
 	{
-		Bounds b;
+		return;
+	}
 
-		Room->GetActorBounds(true, b.Origin, b.Extent);
+	if (GetNumPooledActors() >= MaxPooledActors)
+	{
+		MeshActor->Destroy();
+		return;
+	}
 
-		if(b.Overlap(loc))
-		{
-			return true;
-		}
+	// Component visibility rather than actor hiding, so pooled actors also vanish from editor viewports
+	MeshActor->GetStaticMeshComponent()->SetVisibility(false);
+	MeshActor->SetActorEnableCollision(false);
+	Pool.Add(MeshActor);
+	SET_DWORD_STAT(STAT_DungeonPooledActors, GetNumPooledActors());
+}
+
+void ADungeonGenerator::ReleaseInstances(UHierarchicalInstancedStaticMeshComponent* Instances)
+{
+	if (PooledInstances.Num() >= MaxPooledInstances)
+	{
+		RemoveInstanceComponent(Instances);
+		Instances->DestroyComponent();
+		return;
 	}
 
-	return false;
+	Instances->ClearInstances();
+	Instances->SetVisibility(false);
+	PooledInstances.Add(Instances);
 }
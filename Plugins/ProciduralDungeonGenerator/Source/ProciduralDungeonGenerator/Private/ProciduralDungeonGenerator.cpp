@@ -1,18 +1,27 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "ProciduralDungeonGenerator.h"
+#include "Async/ParallelFor.h"
+#include "DungeonCore/Parallel.h"
 
 #define LOCTEXT_NAMESPACE "FProciduralDungeonGeneratorModule"
 
 void FProciduralDungeonGeneratorModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+
+	// Run DungeonCore's parallel loops on the task graph instead of its own std::threads
+	DungeonCore::SetParallelExecutor([](int32_t NumChunks, const std::function<void(int32_t)>& Chunk)
+	{
+		ParallelFor(NumChunks, [&Chunk](int32 Index) { Chunk(Index); });
+	});
 }
 
 void FProciduralDungeonGeneratorModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	DungeonCore::SetParallelExecutor(&DungeonCore::ThreadParallelExecutor);
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -7,6 +7,9 @@ public class ProciduralDungeonGenerator : ModuleRules
 	public ProciduralDungeonGenerator(ReadOnlyTargetRules Target) : base(Target)
 	{
 		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		// Routes the DungeonCore trace scopes to the engine profiler, see Private/DungeonCore/DungeonTrace.h
+		PrivateDefinitions.Add("DUNGEONCORE_WITH_ENGINE=1");
 		
 		PublicIncludePaths.AddRange(
 			new string[] {
@@ -4,6 +4,8 @@
 #include <iostream>
 #include <vector>
 
+#include "DungeonCore/Triangulation.h"
+
 namespace DelaunayTriangle3D
 {
 	constexpr double eps = 1e-4;
@@ -44,7 +46,7 @@ namespace DelaunayTriangle3D
 		using Node = FVector;
 		Node p0, p1, p2;
 		Edge<T> e0, e1, e2;
-		Circle<float> circle;
+		Circle<double> circle;
 
 		Triangle(const Node& _p0, const Node& _p1, const Node& _p2)
 			: p0{_p0},
@@ -80,108 +82,37 @@ namespace DelaunayTriangle3D
 		std::vector<Edge<T>> edges;
 	};
 
+	/* Thin wrapper over the O(n log n) DungeonCore::Triangulate, Z is ignored. */
 	template <typename T>
 	Delaunay<T> triangulate(const TArray<FVector>& points)
 	{
 		using Node = FVector;
-		if (points.Num() < 3)
-		{
-			return Delaunay<T>{};
-		}
-		auto xmin = points[0].X;
-		auto xmax = xmin;
-		auto ymin = points[0].Y;
-		auto ymax = ymin;
+
+		std::vector<DungeonCore::Vec2> nodes;
+		nodes.reserve(points.Num());
 		for (const auto& pt : points)
 		{
-			xmin = FMath::Min(xmin, pt.X);
-			xmax = FMath::Max(xmax, pt.X);
-			ymin = FMath::Min(ymin, pt.Y);
-			ymax = FMath::Max(ymax, pt.Y);}
-
-		const auto dx = xmax - xmin;
-		const auto dy = ymax - ymin;
-		const auto dmax = std::max(dx, dy);
-		const auto midx = (xmin + xmax) / 2.;
-		const auto midy = (ymin + ymax) / 2.;
-
-		/* Init Delaunay triangulation. */
-		auto d = Delaunay<T>{};
+			nodes.push_back({pt.X, pt.Y});
+		}
 
-		const auto p0 = Node(midx - 20 * dmax, midy - dmax, 0.);
-		const auto p1 = Node(midx, midy + 20 * dmax, 0);
-		const auto p2 = Node(midx + 20 * dmax, midy - dmax, 0);
-		d.triangles.push_back(Triangle<T>{p0, p1, p2});
+		const DungeonCore::Triangulation result = DungeonCore::Triangulate(nodes);
 
-		for (const auto& pt : points)
+		const auto vertex = [&](int32_t id) { return Node(nodes[id].X, nodes[id].Y, 0.); };
+
+		auto d = Delaunay<T>{};
+		d.triangles.reserve(result.NumTriangles());
+		for (int32_t t = 0; t < result.NumTriangles(); ++t)
 		{
-			std::vector<Edge<T>> edges;
-			std::vector<Triangle<T>> tmps;
-			for (const auto& tri : d.triangles)
-			{
-				/* Check if the point is inside the triangle circumcircle. */
-				const auto dist = (tri.circle.x - pt.X) * (tri.circle.x - pt.X) +
-					(tri.circle.y - pt.Y) * (tri.circle.y - pt.Y);
-				if ((dist - tri.circle.radius) <= eps)
-				{
-					edges.push_back(tri.e0);
-					edges.push_back(tri.e1);
-					edges.push_back(tri.e2);
-				}
-				else
-				{
-					tmps.push_back(tri);
-				}
-			}
-
-			/* Delete duplicate edges. */
-			std::vector<bool> remove(edges.size(), false);
-			for (auto it1 = edges.begin(); it1 != edges.end(); ++it1)
-			{
-				for (auto it2 = edges.begin(); it2 != edges.end(); ++it2)
-				{
-					if (it1 == it2)
-					{
-						continue;
-					}
-					if (*it1 == *it2)
-					{
-						remove[std::distance(edges.begin(), it1)] = true;
-						remove[std::distance(edges.begin(), it2)] = true;
-					}
-				}
-			}
-
-			edges.erase(
-				std::remove_if(edges.begin(), edges.end(),
-							   [&](const auto& e) { return remove[&e - &edges[0]]; }),
-				edges.end());
-
-			/* Update triangulation. */
-			for (const auto& e : edges)
-			{
-				tmps.push_back({e.p0, e.p1, {pt.X, pt.Y, 0}});
-			}
-			d.triangles = tmps;
+			d.triangles.push_back({vertex(result.Triangles[3 * t]),
+			                       vertex(result.Triangles[3 * t + 1]),
+			                       vertex(result.Triangles[3 * t + 2])});
 		}
 
-		/* Remove original super triangle. */
-		d.triangles.erase(
-			std::remove_if(d.triangles.begin(), d.triangles.end(),
-						   [&](const auto& tri)
-						   {
-							   return ((tri.p0 == p0 || tri.p1 == p0 || tri.p2 == p0) ||
-								   (tri.p0 == p1 || tri.p1 == p1 || tri.p2 == p1) ||
-								   (tri.p0 == p2 || tri.p1 == p2 || tri.p2 == p2));
-						   }),
-			d.triangles.end());
-
-		/* Add edges. */
-		for (const auto& tri : d.triangles)
+		/* Add edges, each undirected edge once. */
+		d.edges.reserve(result.Edges.size());
+		for (const auto& e : result.Edges)
 		{
-			d.edges.push_back(tri.e0);
-			d.edges.push_back(tri.e1);
-			d.edges.push_back(tri.e2);
+			d.edges.push_back({vertex(e.A), vertex(e.B), static_cast<int>(e.Weight)});
 		}
 		return d;
 	}
@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DungeonBatchCommandlet.generated.h"
+
+// Generates dungeons offline for content validation and pre-generation, no world or rendering needed:
+//
+//   UnrealEditor-Cmd Project.uproject -run=DungeonBatch -nullrhi -FirstSeed=1 -Count=10000 -Cells=100,400
+//                    [-Generator=/Game/BP_Dungeon.BP_Dungeon_C] [-Floors=N] [-Radius=R] [-MinDistance=D]
+//                    [-Steps=N] [-Tolerance=T] [-Steering] [-Out=Dir] [-SaveLayouts]
+//
+// Settings come from the Generator class defaults, or the DungeonCore defaults, with the switches on top.
+// Every seed is run for every cell count, whole dungeons spread over all cores. Writes stats.csv with one
+// row per dungeon to Out, Saved/DungeonBatch by default, and with -SaveLayouts every layout in the format
+// LoadDungeonLayout reads. Returns non zero if the arguments are bad or a file could not be written.
+UCLASS()
+class PROCIDURALDUNGEONGENERATOR_API UDungeonBatchCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UDungeonBatchCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
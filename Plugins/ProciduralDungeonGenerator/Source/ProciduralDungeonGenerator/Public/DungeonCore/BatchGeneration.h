@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "DungeonTypes.h"
+
+// Many independent layouts generated at once, for offline sweeps and pre-generation. Only one layout per
+// thread is alive at a time, callers keep what they need of each as it is handed over.
+namespace DungeonCore
+{
+	struct BatchEntry
+	{
+		DungeonParams Params;
+		uint32_t Seed = 0;
+	};
+
+	/* What a sweep keeps of a layout once it is dropped, enough to spot outliers and regressions. */
+	struct BatchSummary
+	{
+		int NumCells = 0;
+		int NumRooms = 0;
+		int NumEdges = 0;
+		int NumCorridorTiles = 0;
+		int NumStairs = 0;
+		int SeparationSteps = 0;
+		GenerationStats Stats;
+	};
+
+	BatchSummary Summarize(const DungeonLayout& Layout);
+
+	/* Called once per entry on the thread that generated it, possibly several at once. */
+	using BatchLayoutCallback = std::function<void(size_t EntryIndex, const DungeonLayout& Layout)>;
+
+	/*
+	 * Runs GenerateLayout for every entry, entries spread over the parallel executor and each layout
+	 * generated serially within its thread. Layouts are the same as generating the entries one by one.
+	 * Returns the summaries in entry order.
+	 */
+	std::vector<BatchSummary> GenerateBatch(const std::vector<BatchEntry>& Entries,
+	                                        const BatchLayoutCallback& OnLayout = {});
+}
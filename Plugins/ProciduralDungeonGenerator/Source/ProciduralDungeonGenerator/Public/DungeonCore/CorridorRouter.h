@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "DungeonTypes.h"
+
+namespace DungeonCore
+{
+	class OccupancyGrid;
+
+	struct CorridorRouterSettings
+	{
+		/* Cost of walking an existing corridor tile, a new tile costs 1. Lower values merge corridors more. */
+		double ReuseCost = 0.3;
+
+		/* Added on every change of direction, keeps corridors from zigzagging. */
+		double TurnCost = 0.5;
+
+		/* Tiles searched around the two rooms, doubled up to MaxWidenings times while routes run into the edge. */
+		int32_t Margin = 8;
+		int32_t MaxWidenings = 3;
+	};
+
+	/*
+	 * A* on the corridor tile grid, tile centres sit at (i + 0.5, j + 0.5) * SectionLength. Routes leave the
+	 * start room from any of its edge tiles and end on the first tile inside the target room, never cross
+	 * another room of the occupancy grid, and prefer walking corridors laid before. Reusing existing tiles is
+	 * cheaper than laying new ones, so the grid is not uniform cost and jump point search does not apply.
+	 *
+	 * Node records and the open list live in buffers kept between calls, a router reused for every corridor
+	 * of a layout only allocates while its search window grows past the largest one seen.
+	 */
+	class CorridorRouter
+	{
+	public:
+		void Reset(double InSectionLength, const CorridorRouterSettings& InSettings = {});
+
+		/*
+		 * Appends the tiles of a route from From to To that are neither inside a room nor already placed,
+		 * and adds them to Occupancy. RouteTiles, if given, also gets the placed tiles the route reuses.
+		 * Returns false and appends nothing if no route exists in the window.
+		 */
+		bool Route(const Bounds2D& From, const Bounds2D& To, double TileZ, OccupancyGrid& Occupancy,
+		           std::vector<Vec3>& Tiles, std::vector<Vec3>* RouteTiles = nullptr);
+
+		/* Nodes expanded by the last Route call, summed over its widenings. */
+		size_t GetNumExpanded() const { return NumExpanded; }
+
+		size_t GetAllocatedBytes() const;
+
+	private:
+		enum class NodeKind : uint8_t
+		{
+			Open,
+			Reuse,
+			Blocked,
+			Goal
+		};
+
+		struct Node
+		{
+			double Cost;
+			int32_t Parent;
+			uint32_t Stamp;
+			NodeKind Kind;
+			uint8_t Direction;
+			bool bClosed;
+		};
+
+		struct OpenEntry
+		{
+			double Estimate;
+			double Cost;
+			int32_t Index;
+		};
+
+		struct Window
+		{
+			int32_t MinX;
+			int32_t MinY;
+			int32_t Width;
+			int32_t Height;
+		};
+
+		/* bOutHitWindowEdge tells whether the search was cut short by the window or ran out of reachable tiles. */
+		bool Search(const Window& Area, const Bounds2D& From, const Bounds2D& To, double TileZ,
+		            OccupancyGrid& Occupancy, std::vector<Vec3>& Tiles, std::vector<Vec3>* RouteTiles,
+		            bool& bOutHitWindowEdge);
+
+		/* Initializes the node on first touch in the current search. */
+		Node& Touch(const Window& Area, int32_t Index, const Bounds2D& To, double TileZ, const OccupancyGrid& Occupancy);
+
+		int32_t ToGrid(double Coord) const { return static_cast<int32_t>(std::floor(Coord * InvSectionLength)); }
+		double ToWorld(int32_t Grid) const { return (Grid + 0.5) * SectionLength; }
+
+		std::vector<Node> Nodes;
+		std::vector<OpenEntry> Open;
+		std::vector<int32_t> Path;
+
+		CorridorRouterSettings Settings;
+		double SectionLength = 100.;
+		double InvSectionLength = 0.01;
+		uint32_t Stamp = 0;
+		size_t NumExpanded = 0;
+	};
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "DungeonTypes.h"
+
+// Corridor tiles merged into straight runs, so a corridor spawns as a few scaled pieces with one collision
+// box each rather than one piece per tile.
+namespace DungeonCore
+{
+	struct CorridorStrip
+	{
+		/* Centre of the first tile, the others follow SectionLength apart along X, or along Y if bAlongY. */
+		Vec3 First;
+		int32_t NumTiles = 1;
+		bool bAlongY = false;
+
+		Vec3 GetTile(int32_t TileIndex, double SectionLength) const;
+		Vec3 GetCenter(double SectionLength) const;
+
+		/* Index of Tile along the strip, -1 if the strip does not cover it. */
+		int32_t FindTile(const Vec3& Tile, double SectionLength) const;
+	};
+
+	/*
+	 * Covers every tile with exactly one strip. The longest runs along either axis are taken first, so a
+	 * corner or crossing tile goes to the longer corridor and the other one stops next to it. Tiles with no
+	 * free neighbour in line become single tile strips.
+	 */
+	std::vector<CorridorStrip> MergeCorridorTiles(const std::vector<Vec3>& Tiles, double SectionLength);
+
+	/*
+	 * Patches Strips after a layout edit. Strips holding a removed tile are taken out, and what is left of
+	 * them is merged again with the added tiles. All other strips stay as they are, so the result covers the
+	 * same tiles as merging from scratch but may use a few more strips. Changed strips are appended to Strips
+	 * and reported in AddedStrips, the ones taken out in RemovedStrips.
+	 */
+	void UpdateCorridorStrips(std::vector<CorridorStrip>& Strips, const std::vector<Vec3>& RemovedTiles,
+	                          const std::vector<Vec3>& AddedTiles, double SectionLength,
+	                          std::vector<CorridorStrip>& RemovedStrips, std::vector<CorridorStrip>& AddedStrips);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "DungeonTypes.h"
+#include "Random.h"
+
+// Engine independent dungeon layout pipeline. Every stage works on a DungeonLayout in place so
+// callers can run the whole thing with GenerateLayout or step through the stages themselves.
+namespace DungeonCore
+{
+	/* Stream ids handed to RandomEngine by GenerateLayout, one per stage that draws random numbers. */
+	enum class RandomStage : uint64_t
+	{
+		SpawnCells = 1,
+		SelectRooms,
+		ConnectRooms,
+		/* Loop edges of rooms added by a LayoutEditor. */
+		EditRooms
+	};
+
+	/*
+	 * Lets another thread follow and cancel a GenerateLayout call. Progress only moves forward and reaches
+	 * 1 once corridors are built. After a cancel the stages return early and the layout is incomplete.
+	 */
+	class GenerationProgress
+	{
+	public:
+		void Cancel() { bCancelled.store(true, std::memory_order_relaxed); }
+		bool IsCancelled() const { return bCancelled.load(std::memory_order_relaxed); }
+
+		float Get() const { return Progress.load(std::memory_order_relaxed); }
+		void Set(float Value) { Progress.store(Value, std::memory_order_relaxed); }
+
+	private:
+		std::atomic<bool> bCancelled{false};
+		std::atomic<float> Progress{0.f};
+	};
+
+	struct Segment
+	{
+		Vec2 Start;
+		Vec2 End;
+		int Weight;
+	};
+
+	/* Uniform float in [0, 1). */
+	float RandomFloat(RandomEngine& Rng);
+
+	/* Uniform integer in [Min, Max], Min without drawing if Max <= Min. */
+	int RandRange(RandomEngine& Rng, int Min, int Max);
+
+	int RoundM(double Loc, int SnapSize);
+	Vec2 RoundM(const Vec2& Loc, int SnapSize);
+	Vec2 GetRandomPointInCircle(RandomEngine& Rng, float Radius, int SnapSize);
+
+	/* Scatters NumberOfCells randomly sized cells inside SpawnRadius, dealt round robin over the floors. */
+	void SpawnCells(const DungeonParams& Params, RandomEngine& Rng, DungeonLayout& Layout);
+
+	/* Runs a SeparationSolver with Params.Separation until the cells settle, MaxSeparationSteps is hit or Progress is cancelled. */
+	void SeparateCells(const DungeonParams& Params, DungeonLayout& Layout, GenerationProgress* Progress = nullptr);
+
+	/* Room table entry for an already snapped cell, Main if the cell is large enough to be picked by size. */
+	Room MakeRoom(const DungeonParams& Params, const DungeonLayout& Layout, int CellIndex);
+
+	/* Flags large cells, plus a random share of the small ones, as rooms, snaps them and fills the room table. */
+	void SelectRooms(const DungeonParams& Params, RandomEngine& Rng, DungeonLayout& Layout);
+
+	/*
+	 * Triangulates the rooms of each floor, and the rooms of every two adjacent floors together for the
+	 * edges between them, keeps the spanning tree of all those edges and adds back some random loop edges.
+	 * A single floor gives exactly the edges of one triangulation of all rooms.
+	 */
+	void ConnectRooms(RandomEngine& Rng, DungeonLayout& Layout);
+
+	/*
+	 * Routes a corridor along every edge, spanning tree first so loop edges can reuse its tiles. An edge
+	 * between floors gets a stairwell climbing out of the lower room, with a corridor to the upper room
+	 * when the stair does not land inside it.
+	 */
+	void BuildCorridors(const DungeonParams& Params, DungeonLayout& Layout);
+
+	class CorridorRouter;
+	class OccupancyGrid;
+
+	/*
+	 * Corridor of one edge as BuildCorridors lays it, with its stairwell if the edge changes floor. Occupancy
+	 * holds one grid per floor. New tiles and the stairwell are appended to Layout, RouteTiles, if given, gets
+	 * every corridor tile the edge walks, laid now or before.
+	 */
+	void BuildEdgeCorridor(const DungeonParams& Params, const RoomEdge& Edge, CorridorRouter& Router,
+	                       std::vector<OccupancyGrid>& Occupancy, DungeonLayout& Layout,
+	                       std::vector<Vec3>* RouteTiles = nullptr);
+
+	/* Z of the corridor tiles laid on Floor. */
+	double GetCorridorZ(const DungeonLayout& Layout, int Floor);
+
+	/*
+	 * Routes one corridor between two areas on the same floor with Router around the rooms of Occupancy,
+	 * falling back to LayCorridor between their centres if no route is found. New tiles are appended to Tiles,
+	 * RouteTiles as for BuildEdgeCorridor.
+	 */
+	void RouteCorridor(const Bounds2D& From, const Bounds2D& To, double TileZ, double SectionLength,
+	                   CorridorRouter& Router, OccupancyGrid& Occupancy, std::vector<Vec3>& Tiles,
+	                   std::vector<Vec3>* RouteTiles = nullptr);
+
+	/*
+	 * Walks one L shaped corridor from From to To, X run first, and appends the tiles that are neither
+	 * inside a room of Occupancy nor already placed in it.
+	 */
+	void LayCorridor(const Vec2& From, const Vec2& To, double TileZ, double SectionLength, OccupancyGrid& Occupancy,
+	                 std::vector<Vec3>& Tiles, std::vector<Vec3>* RouteTiles = nullptr);
+
+	/* Any room on any floor. */
+	bool IsOverlappingRoom(const DungeonLayout& Layout, const Vec2& Loc);
+
+	/* Shortest segment between the side midpoints of two rooms. */
+	Segment GetClosestEdge(const DungeonLayout& Layout, int RoomA, int RoomB);
+
+	/*
+	 * Runs every stage, each with its own RandomEngine seeded from Seed and its RandomStage. The result
+	 * only depends on Params and Seed, and a stage's draws do not shift when another stage draws more.
+	 * Progress, if given, is updated between stages and checked for cancellation.
+	 */
+	DungeonLayout GenerateLayout(const DungeonParams& Params, uint32_t Seed, GenerationProgress* Progress = nullptr);
+}
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Plain data types shared by the engine independent generation core. Nothing in
+// DungeonCore may include engine headers so it can be built and tested standalone.
+namespace DungeonCore
+{
+	struct Vec2
+	{
+		double X = 0.;
+		double Y = 0.;
+
+		Vec2() = default;
+		Vec2(double InX, double InY) : X{InX}, Y{InY}
+		{
+		}
+
+		Vec2 operator+(const Vec2& Other) const { return {X + Other.X, Y + Other.Y}; }
+		Vec2 operator-(const Vec2& Other) const { return {X - Other.X, Y - Other.Y}; }
+		Vec2 operator*(double Scale) const { return {X * Scale, Y * Scale}; }
+		Vec2 operator/(double Scale) const { return {X / Scale, Y / Scale}; }
+		Vec2& operator+=(const Vec2& Other) { X += Other.X; Y += Other.Y; return *this; }
+		Vec2& operator/=(double Scale) { X /= Scale; Y /= Scale; return *this; }
+		bool operator==(const Vec2& Other) const { return X == Other.X && Y == Other.Y; }
+		bool operator!=(const Vec2& Other) const { return !(*this == Other); }
+
+		double SizeSquared() const { return X * X + Y * Y; }
+		double Size() const { return std::sqrt(SizeSquared()); }
+	};
+
+	struct Vec3
+	{
+		double X = 0.;
+		double Y = 0.;
+		double Z = 0.;
+
+		Vec3() = default;
+		Vec3(double InX, double InY, double InZ) : X{InX}, Y{InY}, Z{InZ}
+		{
+		}
+
+		bool operator==(const Vec3& Other) const { return X == Other.X && Y == Other.Y && Z == Other.Z; }
+		bool operator!=(const Vec3& Other) const { return !(*this == Other); }
+
+		double Size() const { return std::sqrt(X * X + Y * Y + Z * Z); }
+	};
+
+	struct Bounds2D
+	{
+		Vec2 Origin;
+		Vec2 Extent;
+
+		bool Overlap(const Vec2& Pos) const
+		{
+			return (Pos.X > Origin.X - Extent.X && Pos.X < Origin.X + Extent.X) &&
+				(Pos.Y > Origin.Y - Extent.Y && Pos.Y < Origin.Y + Extent.Y);
+		}
+	};
+
+	/* A candidate cell. Scale mirrors the actor scale, HalfExtent the resulting world bounds. */
+	struct Cell
+	{
+		Vec2 Location;
+		Vec3 Scale;
+		Vec3 HalfExtent;
+		bool bIsRoom = false;
+
+		/* Storey the cell sits on, cells only push apart and rooms only overlap within a floor. */
+		int Floor = 0;
+
+		Bounds2D GetBounds() const { return {Location, {HalfExtent.X, HalfExtent.Y}}; }
+	};
+
+	enum class RoomType : uint8_t
+	{
+		/* Picked for its size. */
+		Main,
+		/* One of the small cells picked at random. */
+		Side
+	};
+
+	/*
+	 * Entry of the room table, filled once when rooms are selected so later stages read a room's
+	 * footprint from one contiguous array instead of going back to its cell.
+	 */
+	struct Room
+	{
+		/* Index into DungeonLayout::Cells. */
+		int CellIndex = 0;
+		Bounds2D Bounds;
+		RoomType Type = RoomType::Side;
+		int Floor = 0;
+
+		const Vec2& GetCenter() const { return Bounds.Origin; }
+		const Vec2& GetHalfExtent() const { return Bounds.Extent; }
+
+		bool operator==(const Room& Other) const
+		{
+			return CellIndex == Other.CellIndex && Bounds.Origin == Other.Bounds.Origin &&
+				Bounds.Extent == Other.Bounds.Extent && Type == Other.Type && Floor == Other.Floor;
+		}
+		bool operator!=(const Room& Other) const { return !(*this == Other); }
+	};
+
+	/* Connection between two rooms, indices refer to DungeonLayout::Rooms. */
+	struct RoomEdge
+	{
+		int A = 0;
+		int B = 0;
+		double Weight = 0.;
+		bool bIsLoop = false;
+	};
+
+	/* Vertical link at a tile centre, from LowerFloor up to the floor above. */
+	struct Stairwell
+	{
+		Vec2 Location;
+		int LowerFloor = 0;
+
+		bool operator==(const Stairwell& Other) const
+		{
+			return Location == Other.Location && LowerFloor == Other.LowerFloor;
+		}
+		bool operator!=(const Stairwell& Other) const { return !(*this == Other); }
+	};
+
+	enum class SeparationMethod : uint8_t
+	{
+		/* Pushes overlapping cells apart by their penetration depth until no overlap is deeper than the tolerance. */
+		Penetration,
+		/* Fixed length steps away from every centre closer than MinDistance, what layouts were first made with. */
+		Steering
+	};
+
+	struct DungeonParams
+	{
+		int NumberOfCells = 100;
+		int MinSize = 2;
+		int MaxSize = 8;
+		float SpawnRadius = 2000.f;
+		float MinDistance = 1200.f;
+		int SnapSize = 5;
+		float SectionLength = 100.f;
+
+		/* Half extent of the room mesh at unit scale. */
+		Vec3 RoomMeshExtent{50., 50., 50.};
+
+		/* Iteration cap of the separation solver, it stops there even if cells still overlap. */
+		int MaxSeparationSteps = 2000;
+
+		SeparationMethod Separation = SeparationMethod::Penetration;
+
+		/* Deepest overlap Penetration leaves between two cells on a floor. */
+		float SeparationTolerance = 1.f;
+
+		/* Cells are dealt round robin over this many storeys, FloorHeight apart, and linked by stairwells. */
+		int NumFloors = 1;
+		float FloorHeight = 600.f;
+
+		bool operator==(const DungeonParams& Other) const
+		{
+			return NumberOfCells == Other.NumberOfCells && MinSize == Other.MinSize && MaxSize == Other.MaxSize &&
+				SpawnRadius == Other.SpawnRadius && MinDistance == Other.MinDistance && SnapSize == Other.SnapSize &&
+				SectionLength == Other.SectionLength && RoomMeshExtent == Other.RoomMeshExtent &&
+				MaxSeparationSteps == Other.MaxSeparationSteps && NumFloors == Other.NumFloors &&
+				FloorHeight == Other.FloorHeight && Separation == Other.Separation &&
+				SeparationTolerance == Other.SeparationTolerance;
+		}
+		bool operator!=(const DungeonParams& Other) const { return !(*this == Other); }
+	};
+
+	template <typename ElementType>
+	size_t GetAllocatedBytes(const std::vector<ElementType>& Vector)
+	{
+		return Vector.capacity() * sizeof(ElementType);
+	}
+
+	/* Where the time of one generation went, each stage adds its own figures as it runs. */
+	struct GenerationStats
+	{
+		double SpawnMs = 0.;
+		double SeparationMs = 0.;
+		double SelectRoomsMs = 0.;
+		double TriangulationMs = 0.;
+		double SpanningTreeMs = 0.;
+		double LoopEdgesMs = 0.;
+		double CorridorsMs = 0.;
+
+		/* Whole GenerateLayout call, including work not covered by a stage. */
+		double TotalMs = 0.;
+
+		int NumTriangles = 0;
+		int NumLoopEdges = 0;
+
+		/* False if separation stopped at MaxSeparationSteps or was cancelled with cells still overlapping. */
+		bool bSeparationConverged = false;
+
+		/* Largest footprint seen of the layout plus the scratch data of the stage running at the time. */
+		size_t PeakBytes = 0;
+	};
+
+	struct DungeonLayout
+	{
+		std::vector<Cell> Cells;
+
+		/* The cells chosen as rooms, in selection order. */
+		std::vector<Room> Rooms;
+
+		/* Spanning tree followed by the extra loop edges, in no particular order once a LayoutEditor has edited the layout. */
+		std::vector<RoomEdge> Edges;
+
+		/* Centres of the corridor tiles, SectionLength apart, Z includes the floor height. */
+		std::vector<Vec3> CorridorTiles;
+
+		/* One per edge between rooms on adjacent floors, its tile is in CorridorTiles on a floor where it lies outside the rooms. */
+		std::vector<Stairwell> Stairs;
+
+		int NumFloors = 1;
+		double FloorHeight = 0.;
+
+		int SeparationSteps = 0;
+
+		GenerationStats Stats;
+
+		const Room& GetRoom(int RoomIndex) const { return Rooms[RoomIndex]; }
+
+		/* World Z of a floor's ground, rooms stand on it and corridor tiles sit just below. */
+		double GetFloorZ(int Floor) const { return Floor * FloorHeight; }
+
+		size_t GetAllocatedBytes() const
+		{
+			return DungeonCore::GetAllocatedBytes(Cells) + DungeonCore::GetAllocatedBytes(Rooms) +
+				DungeonCore::GetAllocatedBytes(Edges) + DungeonCore::GetAllocatedBytes(CorridorTiles) +
+				DungeonCore::GetAllocatedBytes(Stairs);
+		}
+	};
+}
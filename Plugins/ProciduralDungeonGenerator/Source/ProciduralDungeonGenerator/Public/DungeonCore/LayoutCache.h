@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "DungeonTypes.h"
+
+namespace DungeonCore
+{
+	class GenerationProgress;
+
+	/*
+	 * Keeps the last few layouts keyed by (Params, Seed). GenerateLayout is a pure function of both,
+	 * so a hit skips separation, triangulation and corridors entirely. Least recently used entries are
+	 * evicted once Capacity is reached. Safe to share between threads, generation runs unlocked.
+	 */
+	class LayoutCache
+	{
+	public:
+		explicit LayoutCache(size_t InCapacity = 8) : Capacity{InCapacity}
+		{
+		}
+
+		/* Cached layout or nullptr. */
+		std::shared_ptr<const DungeonLayout> Find(const DungeonParams& Params, uint32_t Seed);
+
+		/* Cancelled runs are not cached and return nullptr. */
+		std::shared_ptr<const DungeonLayout> GetOrGenerate(const DungeonParams& Params, uint32_t Seed,
+		                                                   GenerationProgress* Progress = nullptr);
+
+		void Add(const DungeonParams& Params, uint32_t Seed, std::shared_ptr<const DungeonLayout> Layout);
+
+		void SetCapacity(size_t InCapacity);
+		void Clear();
+		size_t Num() const;
+
+	private:
+		struct Entry
+		{
+			DungeonParams Params;
+			uint32_t Seed;
+			uint64_t LastUsed;
+			std::shared_ptr<const DungeonLayout> Layout;
+		};
+
+		void EvictToCapacity();
+
+		/* A handful of entries, a linear scan beats hashing the params. */
+		std::vector<Entry> Entries;
+		size_t Capacity;
+		uint64_t UseCounter = 0;
+		mutable std::mutex Mutex;
+	};
+}
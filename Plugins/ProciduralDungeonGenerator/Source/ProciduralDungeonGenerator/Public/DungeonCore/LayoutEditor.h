@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "CorridorRouter.h"
+#include "DungeonTypes.h"
+#include "OccupancyGrid.h"
+#include "Random.h"
+#include "Triangulation.h"
+
+// Local edits on a finished layout. Adding, removing or moving a room re-triangulates, reconnects and
+// re-routes only around that room, every other edge keeps its corridor tile for tile.
+namespace DungeonCore
+{
+	/* What one edit changed, so spawned geometry can be patched instead of rebuilt. */
+	struct LayoutChanges
+	{
+		/* Rooms as they were before and are after the edit, a moved room shows up in both. */
+		std::vector<Room> RemovedRooms;
+		std::vector<Room> AddedRooms;
+
+		/* A tile or stairwell taken out and laid again in the same edit shows up in neither. */
+		std::vector<Vec3> RemovedTiles;
+		std::vector<Vec3> AddedTiles;
+		std::vector<Stairwell> RemovedStairs;
+		std::vector<Stairwell> AddedStairs;
+
+		void Clear();
+	};
+
+	/*
+	 * Keeps a layout connected while rooms come and go. A new room is triangulated against its nearest
+	 * rooms on its floor, joins the spanning tree through the closest of them and keeps some of the other
+	 * triangle edges as loops, with the odds ConnectRooms uses. Removing a room drops its edges and joins
+	 * the pieces of the spanning tree it held together through their shortest links, so the tree stays
+	 * spanning but, like any local repair, not always minimal. Corridor tiles are reference counted by
+	 * the edges walking them and only disappear with the last one.
+	 *
+	 * The cost of an edit follows the corridors it lays and removes. Finding a room's neighbours and
+	 * fixing up indices scans flat arrays of rooms and edges, which is cheap next to routing.
+	 */
+	class LayoutEditor
+	{
+	public:
+		/*
+		 * Starts editing Layout, which has to outlive the editor and only change through it from now on.
+		 * Lays its corridors again once to learn which tiles each edge walks, they come out exactly as
+		 * BuildCorridors made them. Seed picks the loop edges of rooms added or moved later.
+		 */
+		void Init(const DungeonParams& InParams, uint32_t Seed, DungeonLayout& InLayout);
+
+		bool IsValid() const { return Layout != nullptr; }
+		const DungeonLayout* GetLayout() const { return Layout; }
+
+		/*
+		 * Index of the new room, -1 if Floor is not in the layout, the extent is empty or the room would
+		 * overlap another on its floor. Location is snapped. Corridors running where the room now stands
+		 * are routed again around it.
+		 */
+		int AddRoom(const Vec2& Location, const Vec2& HalfExtent, int Floor, LayoutChanges& Changes);
+
+		/* The room's cell turns back into a filler cell and the last room takes over its index. */
+		bool RemoveRoom(int RoomIndex, LayoutChanges& Changes);
+
+		/*
+		 * Same as removing and adding it again, except the room keeps its index and cell. False, and the
+		 * layout untouched, if the room would overlap another.
+		 */
+		bool MoveRoom(int RoomIndex, const Vec2& Location, LayoutChanges& Changes);
+
+		size_t GetAllocatedBytes() const;
+
+	private:
+		struct TileRef
+		{
+			int32_t Index;
+			int32_t Refs;
+		};
+
+		struct TileHash
+		{
+			size_t operator()(const Vec3& Tile) const;
+		};
+
+		/* Every corridor tile the edge walks, laid by it or by an edge before it, and its stairwell if any. */
+		struct EdgeRoute
+		{
+			std::vector<Vec3> Tiles;
+			int32_t Stair = -1;
+		};
+
+		void AddEdge(int32_t A, int32_t B, double Weight, bool bIsLoop, LayoutChanges& Changes);
+		void RemoveEdge(int32_t EdgeIndex, LayoutChanges& Changes);
+
+		/* Lays the edge's corridor and counts it as walking every tile of its route. */
+		void LayRoute(int32_t EdgeIndex, LayoutChanges& Changes);
+
+		/* Drops every edge of the room and joins what it left apart. */
+		void Detach(int32_t RoomIndex, LayoutChanges& Changes);
+
+		/* Routes again, around the room, every edge walking a corridor tile the room covers. */
+		void RerouteAround(int32_t RoomIndex, LayoutChanges& Changes);
+
+		/* Connects a room that has no edges yet. */
+		void Attach(int32_t RoomIndex, LayoutChanges& Changes);
+
+		/*
+		 * Edges a room without any would get, its triangle edges among its nearest rooms on the same floor
+		 * and the nearest room of each adjacent floor. Shortest first.
+		 */
+		std::vector<IndexEdge> FindCandidates(int32_t RoomIndex) const;
+
+		/* Tree edges until the rooms other than Skip are one tree again, for what Detach's local repair cannot join. */
+		void JoinTreeComponents(int32_t Skip, LayoutChanges& Changes);
+
+		/* True if Bounds shares floor area with a room on Floor other than Skip. */
+		bool OverlapsRoom(const Bounds2D& Bounds, int Floor, int32_t Skip) const;
+
+		void ReleaseTile(const Vec3& Tile, LayoutChanges& Changes);
+		void RemoveStair(int32_t StairIndex, LayoutChanges& Changes);
+
+		/* Weight ConnectRooms gives an edge between two rooms, negative if they are more than one floor apart. */
+		double GetLinkWeight(int32_t A, int32_t B) const;
+
+		int GetTileFloor(const Vec3& Tile) const;
+
+		DungeonParams Params;
+		DungeonLayout* Layout = nullptr;
+		RandomEngine Rng;
+		CorridorRouter Router;
+
+		/* One grid per floor, rooms in them by the ids in RoomOccupancy. */
+		std::vector<OccupancyGrid> Occupancy;
+		std::vector<int32_t> RoomOccupancy;
+
+		/* Parallel to Layout's Rooms, Edges and Stairs. */
+		std::vector<std::vector<int32_t>> RoomEdges;
+		std::vector<EdgeRoute> Routes;
+		std::vector<int32_t> StairEdges;
+
+		/* Live corridor tiles, by position, with their index in Layout's CorridorTiles. */
+		std::unordered_map<Vec3, TileRef, TileHash> Tiles;
+	};
+}
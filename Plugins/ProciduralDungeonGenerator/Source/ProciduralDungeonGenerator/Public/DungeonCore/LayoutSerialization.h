@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "DungeonTypes.h"
+
+// Versioned binary format for finished layouts, so a dungeon can be loaded without running the pipeline.
+// Every value is written little-endian byte by byte, the blob reads back the same on any platform.
+namespace DungeonCore
+{
+	/* Bump when the payload layout changes, older readers refuse newer blobs. 2 added floors and stairwells. */
+	constexpr uint16_t LayoutFormatVersion = 3;
+
+	/* Everything needed to restore a dungeon, the inputs are kept so it can be regenerated or re-cached. */
+	struct SavedLayout
+	{
+		DungeonParams Params;
+		uint32_t Seed = 0;
+		DungeonLayout Layout;
+	};
+
+	enum class LayoutReadResult : uint8_t
+	{
+		Ok,
+		/* Shorter than its header or its payload claims. */
+		Truncated,
+		BadMagic,
+		UnsupportedVersion,
+		ChecksumMismatch,
+		/* Checksum matched but the content is inconsistent, e.g. an index out of range. */
+		Corrupt
+	};
+
+	/*
+	 * Header (magic, version, flags, payload size, FNV-1a of the payload) followed by the params, the seed
+	 * and the layout. Cells drop their half extent when it follows from the params, and their floor when
+	 * there is only one, rooms are only stored as indices and corridor tiles are grouped into straight runs
+	 * one SectionLength apart. Reading gives back a layout equal to the one written, generation stats
+	 * aside. Version 1 blobs still read, as single floor layouts, and blobs before version 3 as separated by
+	 * steering.
+	 */
+	std::vector<uint8_t> WriteLayout(const SavedLayout& Saved);
+
+	/* Reads from memory the caller owns, e.g. a mapped file. Out is left untouched unless Ok is returned. */
+	LayoutReadResult ReadLayout(const uint8_t* Data, size_t Size, SavedLayout& Out);
+
+	const char* ToString(LayoutReadResult Result);
+}
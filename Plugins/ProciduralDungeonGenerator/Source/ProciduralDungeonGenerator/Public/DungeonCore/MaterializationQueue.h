@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CorridorStrips.h"
+#include "DungeonTypes.h"
+
+namespace DungeonCore
+{
+	enum class LayoutItemType : uint8_t
+	{
+		/* Index into DungeonLayout::Cells. */
+		Cell,
+		/* Index into DungeonLayout::CorridorTiles. */
+		Corridor,
+		/* Index into DungeonLayout::Stairs, handed out with the corridor tiles. */
+		Stair,
+		/* Index into the strips given to Reset, handed out in place of the corridor tiles. */
+		Strip
+	};
+
+	struct LayoutItem
+	{
+		LayoutItemType Type;
+		int32_t Index;
+	};
+
+	/*
+	 * Hands out the pieces of a layout one at a time so the caller can spawn them over several frames.
+	 * Cells all come before corridor tiles, so tiles test for collision against the same rooms as when
+	 * everything spawns at once. Within each group the items nearest the focus come first.
+	 */
+	class MaterializationQueue
+	{
+	public:
+		/* With Strips, the layout's corridor tiles merged by MergeCorridorTiles, those come out instead of the tiles. */
+		void Reset(const DungeonLayout& Layout, bool bIncludeFillerCells, const std::vector<CorridorStrip>* Strips = nullptr,
+		           double SectionLength = 0.);
+		void Clear();
+
+		/*
+		 * Reorders what is left nearest to Focus first. Does nothing while Focus stays within
+		 * RefocusDistance of the position last sorted for, so it can be called every frame.
+		 */
+		void SetFocus(const Vec2& Focus, double RefocusDistance = 0.);
+
+		/* Takes the next item, false once the queue is empty. */
+		bool Pop(LayoutItem& Item);
+
+		size_t NumPending() const { return Cells.size() + Corridors.size(); }
+		size_t NumTotal() const { return Total; }
+
+		/* Share of items popped since Reset, 1 when there was nothing to do. */
+		float GetProgress() const;
+
+	private:
+		struct Entry
+		{
+			LayoutItem Item;
+			Vec2 Location;
+			double DistanceSquared;
+		};
+
+		static void SortFarthestFirst(std::vector<Entry>& Entries, const Vec2& Focus);
+
+		/* Pending items, sorted farthest first so Pop takes from the back. */
+		std::vector<Entry> Cells;
+		std::vector<Entry> Corridors;
+
+		Vec2 LastFocus;
+		bool bHasFocus = false;
+		size_t Total = 0;
+	};
+}
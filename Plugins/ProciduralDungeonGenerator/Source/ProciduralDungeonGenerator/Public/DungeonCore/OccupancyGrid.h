@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "DungeonTypes.h"
+
+namespace DungeonCore
+{
+	/*
+	 * Hashed cell map at corridor tile resolution used while laying corridors. Room bounds are rasterized
+	 * once, placed tiles are added as they go, so both the "inside a room" and the "tile already placed"
+	 * checks only look at the handful of entries sharing the grid cell of the query.
+	 */
+	class OccupancyGrid
+	{
+	public:
+		void Init(const DungeonLayout& Layout, double InCellSize);
+
+		/* Empties the grid, rooms of several layouts can then be added to the same one. */
+		void Reset(double InCellSize);
+		void AddRooms(const DungeonLayout& Layout);
+
+		/* Only the rooms standing on Floor, a multi-floor layout keeps one grid per floor. */
+		void AddRooms(const DungeonLayout& Layout, int Floor);
+
+		/* Returns an id for RemoveRoom, rooms are numbered in the order they are added from 0. */
+		int32_t AddRoom(const Bounds2D& Bounds);
+
+		/* Removed rooms and tiles are unlinked from the grid, their storage is only freed by Reset. */
+		void RemoveRoom(int32_t RoomId);
+		bool RemoveTile(const Vec3& Tile);
+
+		/* Same result as IsOverlappingRoom(Layout, Loc) for the layout passed to Init. */
+		bool IsInsideRoom(const Vec2& Loc) const;
+
+		bool HasTile(const Vec3& Tile) const;
+
+		/* Records Tile as placed, returns false if it already was. */
+		bool AddTile(const Vec3& Tile);
+
+		/* Estimate, the hash maps are counted as one node per entry plus the bucket array. */
+		size_t GetAllocatedBytes() const;
+
+	private:
+		struct Link
+		{
+			int32_t Item;
+			int32_t Next;
+		};
+
+		static uint64_t MakeKey(int32_t GridX, int32_t GridY)
+		{
+			return static_cast<uint64_t>(static_cast<uint32_t>(GridX)) << 32 | static_cast<uint32_t>(GridY);
+		}
+
+		/* Drops the first link to Item from the list at Key, true if there was one. */
+		static bool Unlink(std::unordered_map<uint64_t, int32_t>& Heads, std::vector<Link>& Links, uint64_t Key,
+		                   const std::function<bool(int32_t)>& IsItem);
+
+		int32_t ToGrid(double Coord) const { return static_cast<int32_t>(std::floor(Coord * InvCellSize)); }
+		uint64_t KeyOf(double X, double Y) const { return MakeKey(ToGrid(X), ToGrid(Y)); }
+
+		/* Grid cell -> head of a singly linked list in RoomLinks / TileLinks, -1 terminated. */
+		std::unordered_map<uint64_t, int32_t> RoomHeads;
+		std::unordered_map<uint64_t, int32_t> TileHeads;
+		std::vector<Link> RoomLinks;
+		std::vector<Link> TileLinks;
+
+		std::vector<Bounds2D> RoomBounds;
+		std::vector<Vec3> Tiles;
+		double InvCellSize = 1.;
+	};
+}
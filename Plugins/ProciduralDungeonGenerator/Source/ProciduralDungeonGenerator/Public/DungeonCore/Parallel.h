@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace DungeonCore
+{
+	/* Runs Chunk(0) .. Chunk(NumChunks - 1), in any order and on any threads, and returns once all are done. */
+	using ParallelExecutor = void (*)(int32_t NumChunks, const std::function<void(int32_t)>& Chunk);
+
+	/*
+	 * Replaces the executor used by ParallelForRange. The default spreads chunks over std::threads, the
+	 * engine module installs one backed by the task graph. nullptr runs everything on the calling thread.
+	 */
+	void SetParallelExecutor(ParallelExecutor Executor);
+	ParallelExecutor GetParallelExecutor();
+
+	/*
+	 * Executor that spreads chunks over std::thread::hardware_concurrency() threads, the calling one and
+	 * workers started on first use that stay alive for the rest of the process.
+	 */
+	void ThreadParallelExecutor(int32_t NumChunks, const std::function<void(int32_t)>& Chunk);
+
+	/*
+	 * Calls Body(Begin, End) over [0, Num) in chunks of ChunkSize. The split only depends on Num and
+	 * ChunkSize, so callers that write per index results get the same output for any thread count.
+	 */
+	void ParallelForRange(int32_t Num, int32_t ChunkSize, const std::function<void(int32_t, int32_t)>& Body);
+
+	/*
+	 * While one is alive, ParallelForRange runs inline on the thread that created it. For work that is
+	 * already spread over the cores one item per thread, where nested loops would only oversubscribe.
+	 */
+	class ScopedSerialParallelFor
+	{
+	public:
+		ScopedSerialParallelFor();
+		~ScopedSerialParallelFor();
+
+		ScopedSerialParallelFor(const ScopedSerialParallelFor&) = delete;
+		ScopedSerialParallelFor& operator=(const ScopedSerialParallelFor&) = delete;
+	};
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace DungeonCore
+{
+	/*
+	 * PCG32 (XSH RR) generator. Unlike std::mt19937 paired with the std distributions, the sequence
+	 * including RandomFloat and RandRange is specified here, so a seed yields the same dungeon on every
+	 * compiler and platform. Each stream id selects an independent sequence for the same seed.
+	 * Satisfies UniformRandomBitGenerator so it can still drive std distributions in tools and tests.
+	 */
+	class RandomEngine
+	{
+	public:
+		using result_type = uint32_t;
+
+		explicit RandomEngine(uint64_t Seed = 0, uint64_t Stream = 0)
+		{
+			Increment = Stream << 1u | 1u;
+			State = 0;
+			Next();
+			State += Seed;
+			Next();
+		}
+
+		static constexpr result_type min() { return 0; }
+		static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+		result_type operator()() { return Next(); }
+
+		uint32_t Next()
+		{
+			const uint64_t OldState = State;
+			State = OldState * 6364136223846793005ull + Increment;
+			const uint32_t XorShifted = static_cast<uint32_t>(((OldState >> 18u) ^ OldState) >> 27u);
+			const uint32_t Rotation = static_cast<uint32_t>(OldState >> 59u);
+			return XorShifted >> Rotation | XorShifted << ((32u - Rotation) & 31u);
+		}
+
+		/* Uniform in [0, 1), 24 random bits so every value is exact in a float. */
+		float NextFloat() { return static_cast<float>(Next() >> 8) * (1.f / 16777216.f); }
+
+		/* Uniform in [0, Bound) without modulo bias, Bound must be non zero. */
+		uint32_t NextBounded(uint32_t Bound)
+		{
+			const uint32_t Threshold = (0u - Bound) % Bound;
+			for (;;)
+			{
+				const uint32_t Value = Next();
+				if (Value >= Threshold)
+				{
+					return Value % Bound;
+				}
+			}
+		}
+
+	private:
+		uint64_t State;
+		uint64_t Increment;
+	};
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "DungeonTypes.h"
+#include "SpatialGrid.h"
+
+// Coarse navigation over a finished layout. Long trips are planned room to room on the graph of spanning
+// tree and loop edges, leaving only the walk between two neighbouring waypoints to fine navigation.
+namespace DungeonCore
+{
+	/*
+	 * Room graph of a layout with shortest distances cached per target room. The first query towards a
+	 * room runs Dijkstra from it over the whole graph, every later query towards it, from any room, only
+	 * walks down that distance field. Agents mostly head for the same few places, so the least recently
+	 * used fields are dropped past MaxCachedTargets.
+	 *
+	 * Keeps its own copy of what it needs from the layout, it has to be built again after the layout
+	 * changes. Queries fill the cache and are not safe to run from several threads at once.
+	 */
+	class RoomNavigator
+	{
+	public:
+		/* Edges are weighted by their Weight, the centre distance ConnectRooms gave them. */
+		void Init(const DungeonLayout& Layout, size_t InMaxCachedTargets = 64);
+
+		void Reset();
+
+		bool IsValid() const { return !Rooms.empty(); }
+		int32_t GetNumRooms() const { return static_cast<int32_t>(Rooms.size()); }
+
+		/* Floor Z falls in, the same way the layout stacks them. */
+		int GetFloorAt(double Z) const;
+
+		/* Room covering Location on Floor, or failing that the one whose bounds are closest. -1 if the floor has none. */
+		int32_t FindRoom(const Vec2& Location, int Floor) const;
+
+		/* Length of the shortest walk over the room graph, negative if To cannot be reached from From. */
+		double GetDistance(int32_t From, int32_t To);
+
+		/* Rooms on the shortest walk, both ends included. False, and OutRooms empty, if there is none. */
+		bool FindRoomPath(int32_t From, int32_t To, std::vector<int32_t>& OutRooms);
+
+		/*
+		 * Waypoints from Start to End: the centre of every room passed through, at floor height, with both
+		 * ends of the stairwell before each change of floor, and End itself last. Start and End snap to the
+		 * room they are in or closest to. False, and OutWaypoints empty, if the rooms are not connected.
+		 */
+		bool FindWaypoints(const Vec3& Start, const Vec3& End, std::vector<Vec3>& OutWaypoints);
+
+		size_t GetNumCachedTargets() const { return Fields.size(); }
+		size_t GetAllocatedBytes() const;
+
+	private:
+		struct Link
+		{
+			int32_t Room;
+
+			/* Stairwell climbed on the way, -1 between rooms on the same floor. */
+			int32_t Stair;
+			double Weight;
+		};
+
+		struct DistanceField
+		{
+			int32_t Target;
+			uint64_t LastUsed;
+			std::vector<double> Distances;
+		};
+
+		/* Distances from every room to Target, computed on first use. */
+		const std::vector<double>& GetField(int32_t Target);
+
+		/* Stairwell of an edge between adjacent floors, the one on its lower floor closest to both rooms. */
+		int32_t FindStair(int32_t A, int32_t B) const;
+
+		std::vector<Room> Rooms;
+		std::vector<Stairwell> Stairs;
+		double FloorHeight = 0.;
+
+		/* Neighbours of room R are Links[LinkStart[R]] to Links[LinkStart[R + 1]]. */
+		std::vector<int32_t> LinkStart;
+		std::vector<Link> Links;
+
+		/* Room centres layered by floor, cells wide enough that a room covering a point is always visited. */
+		SpatialGrid RoomGrid;
+
+		std::vector<DistanceField> Fields;
+		size_t MaxCachedTargets = 64;
+		uint64_t UseCounter = 0;
+	};
+}
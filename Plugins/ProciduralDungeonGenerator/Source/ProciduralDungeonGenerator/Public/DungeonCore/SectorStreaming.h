@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "DungeonLayoutGenerator.h"
+#include "DungeonTypes.h"
+
+// Splits an unbounded dungeon into square sectors that are generated, stitched and released on their own.
+// A sector's layout only depends on the world seed and its coordinate, so any subset of sectors can be
+// produced in any order and still join up with its neighbours.
+namespace DungeonCore
+{
+	struct SectorCoord
+	{
+		int32_t X = 0;
+		int32_t Y = 0;
+
+		bool operator==(const SectorCoord& Other) const { return X == Other.X && Y == Other.Y; }
+		bool operator!=(const SectorCoord& Other) const { return !(*this == Other); }
+	};
+
+	struct SectorCoordHash
+	{
+		size_t operator()(const SectorCoord& Coord) const
+		{
+			return static_cast<size_t>(static_cast<uint64_t>(static_cast<uint32_t>(Coord.X)) << 32 |
+				static_cast<uint32_t>(Coord.Y));
+		}
+	};
+
+	struct SectorParams
+	{
+		/* Used for every sector, SpawnRadius and NumberOfCells are per sector. */
+		DungeonParams Layout;
+
+		/* Side of a sector in world units, keep it well above twice the spawn radius. */
+		double SectorSize = 12000.;
+
+		uint32_t WorldSeed = 0;
+	};
+
+	uint32_t GetSectorSeed(uint32_t WorldSeed, const SectorCoord& Coord);
+	SectorCoord GetSectorAt(double SectorSize, const Vec2& Location);
+	Vec2 GetSectorCenter(double SectorSize, const SectorCoord& Coord);
+
+	/*
+	 * Layout of one sector in world space, centred on the sector. Rooms whose bounds leave the sector after
+	 * separation are turned back into filler cells, so rooms of neighbouring sectors can never overlap.
+	 */
+	DungeonLayout GenerateSectorLayout(const SectorParams& Params, const SectorCoord& Coord,
+	                                   GenerationProgress* Progress = nullptr);
+
+	/*
+	 * Corridor tiles joining the closest pair of rooms between two neighbouring sector layouts, avoiding
+	 * the rooms of both. Empty if either sector has no rooms.
+	 */
+	std::vector<Vec3> BuildSectorStitch(const SectorParams& Params, const DungeonLayout& A, const DungeonLayout& B);
+
+	/*
+	 * Tracks which sectors are active around a focus point. Layouts are provided from outside, so the caller
+	 * decides where GenerateSectorLayout runs. A sector is ready once its own layout and those of its east and
+	 * north neighbours are known: it then owns the stitches towards both, appended to its corridor tiles.
+	 * Only active sectors and their east and north neighbours stay resident.
+	 */
+	class SectorStreamer
+	{
+	public:
+		void Init(const SectorParams& InParams, int32_t InActiveRadius);
+		void Reset();
+
+		/* Activates the (2 * ActiveRadius + 1)^2 sectors around Focus, OutReleased gets the ones that left. */
+		void Update(const Vec2& Focus, std::vector<SectorCoord>& OutReleased);
+
+		/* Sectors that need a layout and have none yet, nearest the focus first. */
+		std::vector<SectorCoord> GetMissingLayouts() const;
+
+		/* Ignored if the sector is no longer needed or already has a layout. */
+		void ProvideLayout(const SectorCoord& Coord, DungeonLayout&& Layout);
+
+		/* Active sectors that became ready since the last call, nearest the focus first. */
+		std::vector<SectorCoord> TakeReadySectors();
+
+		/* Stitched layout of a ready active sector, null otherwise. Stays valid until the sector is released. */
+		const DungeonLayout* GetReadyLayout(const SectorCoord& Coord) const;
+
+		bool IsActive(const SectorCoord& Coord) const;
+		size_t NumActive() const;
+		size_t NumResident() const { return Sectors.size(); }
+		const SectorParams& GetParams() const { return Params; }
+
+	private:
+		struct SectorState
+		{
+			DungeonLayout Layout;
+			bool bHasLayout = false;
+			bool bActive = false;
+			bool bStitched = false;
+			bool bReported = false;
+		};
+
+		bool IsNeeded(const SectorCoord& Coord) const;
+		void TryStitch(const SectorCoord& Coord);
+		void SortNearestFirst(std::vector<SectorCoord>& Coords) const;
+
+		std::unordered_map<SectorCoord, SectorState, SectorCoordHash> Sectors;
+		SectorParams Params;
+		SectorCoord FocusSector;
+		int32_t ActiveRadius = 1;
+		bool bHasFocus = false;
+	};
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "DungeonTypes.h"
+#include "SpatialGrid.h"
+
+namespace DungeonCore
+{
+	struct SeparationSettings
+	{
+		SeparationMethod Method = SeparationMethod::Penetration;
+
+		/* Centre distance Steering keeps cells apart by. */
+		float MinDistance = 0.f;
+
+		/* Penetration is done once no two cells on a floor overlap by more than this. */
+		float Tolerance = 1.f;
+
+		int32_t MaxIterations = 2000;
+	};
+
+	struct SeparationResult
+	{
+		/* Steps that moved cells, the one finding nothing left to do is not counted. */
+		int32_t Iterations = 0;
+
+		bool bConverged = false;
+
+		/* Deepest overlap between two cells on a floor as of the last step, Penetration only. */
+		double MaxPenetration = 0.;
+	};
+
+	/*
+	 * Cell separation over flat position and extent buffers. Every step computes all moves from the
+	 * positions at the start of the step, in parallel, and then applies them, so the result does not
+	 * depend on the thread count. Cells are only written back on Commit. Each floor is its own layer of
+	 * the broad phase, cells on different floors never push each other.
+	 *
+	 * Penetration moves both cells of an overlapping pair out by the overlap along the axis it is shallowest
+	 * on, so a lone pair is resolved in a single step and a hundred cells in a few dozen. Steering takes a
+	 * fixed length step away from every close centre, only stops once no centre moves and can take hundreds.
+	 */
+	class SeparationSolver
+	{
+	public:
+		void Init(const std::vector<Cell>& Cells, const SeparationSettings& InSettings);
+
+		/* Steering with no iteration cap, as the solver used to work. */
+		void Init(const std::vector<Cell>& Cells, float InMinDistance);
+
+		/* Moves every cell once, returns false once nothing moved. */
+		bool Step();
+
+		/*
+		 * Steps until the cells settle, the iteration cap is hit or at least BudgetMs went by, 0 or less for no
+		 * time limit. Can be called again to carry on, the cells end up the same however the work is sliced.
+		 */
+		const SeparationResult& Solve(double BudgetMs = 0.);
+
+		bool IsDone() const { return bDone; }
+		const SeparationResult& GetResult() const { return Result; }
+
+		/* Writes the solved positions back into Cells. */
+		void Commit(std::vector<Cell>& Cells) const;
+
+		int32_t GetNumCells() const { return static_cast<int32_t>(Positions.size()); }
+		const std::vector<Vec2>& GetPositions() const { return Positions; }
+
+		size_t GetAllocatedBytes() const
+		{
+			return DungeonCore::GetAllocatedBytes(Positions) + DungeonCore::GetAllocatedBytes(Extents) +
+				DungeonCore::GetAllocatedBytes(ExtentSizes) + DungeonCore::GetAllocatedBytes(Floors) +
+				DungeonCore::GetAllocatedBytes(Forces) + DungeonCore::GetAllocatedBytes(Penetrations) +
+				Grid.GetAllocatedBytes();
+		}
+
+	private:
+		bool StepSteering();
+		bool StepPenetration();
+
+		/* Steering force pushing a cell away from every neighbour closer than MinDistance. */
+		Vec2 Separate(int32_t CellIndex) const;
+
+		/* Sum of the overlaps pushing a cell out of its neighbours, the deepest of them in Penetration. */
+		Vec2 Resolve(int32_t CellIndex, double& Penetration) const;
+
+		SeparationSettings Settings;
+		SeparationResult Result;
+		bool bDone = false;
+
+		std::vector<Vec2> Positions;
+		std::vector<Vec2> Extents;
+		std::vector<double> ExtentSizes;
+		std::vector<int32_t> Floors;
+		std::vector<Vec2> Forces;
+		std::vector<double> Penetrations;
+		SpatialGrid Grid;
+
+		/* Twice the largest half extent, no overlapping pair is further apart on either axis. */
+		double PairReach = 0.;
+	};
+}
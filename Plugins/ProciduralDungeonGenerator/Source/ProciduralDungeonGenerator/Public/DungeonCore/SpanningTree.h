@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Triangulation.h"
+
+namespace DungeonCore
+{
+	/*
+	 * Kruskal's algorithm with a union-find over vertex ids, O(E log E). Returns indices into EdgeList
+	 * in ascending weight order. Equal weights are ordered by vertex ids so the result does not depend
+	 * on the order of EdgeList. Disconnected input yields a spanning forest.
+	 */
+	std::vector<int32_t> MinimumSpanningTree(const std::vector<IndexEdge>& EdgeList, int32_t NumVertices);
+}
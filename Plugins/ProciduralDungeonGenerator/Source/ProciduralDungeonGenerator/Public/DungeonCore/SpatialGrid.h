@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "DungeonTypes.h"
+
+namespace DungeonCore
+{
+	/*
+	 * Uniform grid broad phase over a set of points, stored as a hashed counting sort so a rebuild is two
+	 * linear passes with no per-bucket allocation. ForEachNear visits every point in the 3x3 block of grid
+	 * cells around a position, which covers everything within CellSize of it. Points can be split into layers
+	 * that share the buckets but never see each other.
+	 */
+	class SpatialGrid
+	{
+	public:
+		/* Layers holds one layer per point, every point is on layer 0 without it. */
+		void Build(const std::vector<Vec2>& Points, double InCellSize, const std::vector<int32_t>* Layers = nullptr);
+
+		size_t GetAllocatedBytes() const
+		{
+			return DungeonCore::GetAllocatedBytes(BucketStart) + DungeonCore::GetAllocatedBytes(Entries) +
+				DungeonCore::GetAllocatedBytes(Unsorted) + DungeonCore::GetAllocatedBytes(Cursor);
+		}
+
+		template <typename VisitorType>
+		void ForEachNear(const Vec2& Pos, VisitorType&& Visit) const
+		{
+			ForEachNear(Pos, 0, Visit);
+		}
+
+		template <typename VisitorType>
+		void ForEachNear(const Vec2& Pos, int32_t Layer, VisitorType&& Visit) const
+		{
+			if (Entries.empty())
+			{
+				return;
+			}
+
+			const int32_t CenterX = ToGrid(Pos.X);
+			const int32_t CenterY = ToGrid(Pos.Y);
+			for (int32_t GridY = CenterY - 1; GridY <= CenterY + 1; ++GridY)
+			{
+				for (int32_t GridX = CenterX - 1; GridX <= CenterX + 1; ++GridX)
+				{
+					const uint32_t Bucket = BucketOf(GridX, GridY, Layer);
+					for (uint32_t EntryIndex = BucketStart[Bucket]; EntryIndex < BucketStart[Bucket + 1]; ++EntryIndex)
+					{
+						/* Different grid cells can share a bucket, only report the one asked for. */
+						if (Entries[EntryIndex].GridX == GridX && Entries[EntryIndex].GridY == GridY && Entries[EntryIndex].Layer == Layer)
+						{
+							Visit(Entries[EntryIndex].Index);
+						}
+					}
+				}
+			}
+		}
+
+		double GetCellSize() const { return CellSize; }
+
+	private:
+		struct Entry
+		{
+			int32_t Index;
+			int32_t GridX;
+			int32_t GridY;
+			int32_t Layer;
+		};
+
+		int32_t ToGrid(double Coord) const { return static_cast<int32_t>(std::floor(Coord * InvCellSize)); }
+
+		uint32_t BucketOf(int32_t GridX, int32_t GridY, int32_t Layer) const
+		{
+			const uint32_t Hash = static_cast<uint32_t>(GridX) * 73856093u ^ static_cast<uint32_t>(GridY) * 19349663u ^
+				static_cast<uint32_t>(Layer) * 83492791u;
+			return Hash & BucketMask;
+		}
+
+		std::vector<uint32_t> BucketStart;
+		std::vector<Entry> Entries;
+
+		/* Build scratch, kept so rebuilding every step does not allocate. */
+		std::vector<Entry> Unsorted;
+		std::vector<uint32_t> Cursor;
+		double CellSize = 1.;
+		double InvCellSize = 1.;
+		uint32_t BucketMask = 0;
+	};
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "DungeonTypes.h"
+
+namespace DungeonCore
+{
+	/* Undirected edge between two vertex ids. */
+	struct IndexEdge
+	{
+		int32_t A, B;
+		double Weight;
+	};
+
+	/*
+	 * Compact half-edge triangle mesh. Half-edge e belongs to triangle e / 3 and starts at vertex
+	 * Triangles[e], the next half-edge of the same triangle is NextHalfEdge(e). HalfEdges[e] is the
+	 * twin half-edge in the adjacent triangle, or -1 on the convex hull.
+	 */
+	struct Triangulation
+	{
+		std::vector<Vec2> Vertices;
+
+		/* Vertex ids, three per triangle, wound clockwise (negative signed area in XY). */
+		std::vector<int32_t> Triangles;
+
+		std::vector<int32_t> HalfEdges;
+
+		/* Vertex ids of the convex hull, same winding as the triangles. */
+		std::vector<int32_t> Hull;
+
+		/* Every undirected edge exactly once. */
+		std::vector<IndexEdge> Edges;
+
+		int32_t NumTriangles() const { return static_cast<int32_t>(Triangles.size() / 3); }
+
+		size_t GetAllocatedBytes() const
+		{
+			return DungeonCore::GetAllocatedBytes(Vertices) + DungeonCore::GetAllocatedBytes(Triangles) +
+				DungeonCore::GetAllocatedBytes(HalfEdges) + DungeonCore::GetAllocatedBytes(Hull) +
+				DungeonCore::GetAllocatedBytes(Edges);
+		}
+
+		static int32_t TriangleOfHalfEdge(int32_t e) { return e / 3; }
+		static int32_t NextHalfEdge(int32_t e) { return e % 3 == 2 ? e - 2 : e + 1; }
+		static int32_t PrevHalfEdge(int32_t e) { return e % 3 == 0 ? e + 2 : e - 1; }
+	};
+
+	/*
+	 * Delaunay triangulation of the XY plane, vertex ids are indices into Points. Uses a sweep-hull
+	 * insertion so the cost is O(n log n). Duplicate points are left out of the triangulation and
+	 * fully collinear input yields no triangles.
+	 */
+	Triangulation Triangulate(const std::vector<Vec2>& Points);
+}
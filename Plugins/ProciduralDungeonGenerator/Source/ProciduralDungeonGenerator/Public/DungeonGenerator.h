@@ -2,23 +2,155 @@
 
 #pragma once
 
+#include <memory>
+
 #include "CoreMinimal.h"
-#include "DelaunayTriangulation.h"
+#include "DungeonCore/CorridorStrips.h"
+#include "DungeonCore/DungeonTypes.h"
+#include "DungeonCore/LayoutCache.h"
+#include "DungeonCore/LayoutEditor.h"
+#include "DungeonCore/MaterializationQueue.h"
+#include "DungeonCore/RoomNavigator.h"
+#include "DungeonCore/SectorStreaming.h"
 #include "GameFramework/Actor.h"
 #include "DungeonGenerator.generated.h"
 
-using DGEdge = DelaunayTriangle3D::Edge<UE::Math::TVector<double>>;
+struct FActorSpawnParameters;
+struct FDungeonGenerationJob;
+struct FDungeonSectorJob;
+class AStaticMeshActor;
+class UHierarchicalInstancedStaticMeshComponent;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnDungeonGenerated);
+
+UENUM(BlueprintType)
+enum class EDungeonOutputMode : uint8
+{
+	// One AStaticMeshActor per room and per corridor tile
+	Actors,
+	// One instanced component per mesh, colour and type go to per-instance custom data
+	Instanced
+};
+
+UENUM(BlueprintType)
+enum class EDungeonSeparationMethod : uint8
+{
+	// Overlapping rooms are pushed apart by how deep they overlap until none overlaps by more than the tolerance
+	Penetration,
+	// Fixed steps away from every room centre closer than MinDistance, the original behaviour
+	Steering
+};
+
+// Timing breakdown and sizes of the last generation, stage times come from the run that built the layout
+USTRUCT(BlueprintType)
+struct FDungeonGenerationStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	float SpawnMs{0};
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	float SeparationMs{0};
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	float SelectRoomsMs{0};
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	float TriangulationMs{0};
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	float SpanningTreeMs{0};
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	float LoopEdgesMs{0};
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	float CorridorsMs{0};
+
+	// Whole layout generation, 0 when it came from the layout cache or a saved file
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	float GenerateMs{0};
+
+	// Game thread time spent spawning, summed over every frame of the materialization
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	float MaterializeMs{0};
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	bool bFromCache{false};
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	int32 SeparationSteps{0};
+
+	// False if separation hit MaxSeparationSteps with rooms still overlapping
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	bool bSeparationConverged{false};
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	int32 NumCells{0};
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	int32 NumRooms{0};
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	int32 NumTriangles{0};
 
-struct Bounds
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	int32 NumEdges{0};
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	int32 NumLoopEdges{0};
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	int32 NumCorridorTiles{0};
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	int32 NumStairs{0};
+
+	// Actors or instances spawned for the corridor tiles, one per strip when they are merged
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	int32 NumCorridorPieces{0};
+
+	// Peak of the layout plus stage scratch memory inside the generator core
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	int64 PeakMemoryBytes{0};
+
+	// Actors the materialization had to spawn and those it took from the pool, a warm pool spawns none
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	int32 ActorsSpawned{0};
+
+	UPROPERTY(BlueprintReadOnly, Category="Dungeon Generation")
+	int32 ActorsReused{0};
+};
+
+// Everything spawned for one layout, the whole dungeon or one streamed sector
+USTRUCT()
+struct FDungeonGeometry
 {
-	FVector Origin;
-	FVector Extent;
-
-	bool Overlap(FVector pos)
-	{
-		return (pos.X > Origin.X - Extent.X && pos.X < Origin.X + Extent.X) &&
-			  (pos.Y > Origin.Y - Extent.Y && pos.Y < Origin.Y + Extent.Y);
-	}
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TArray<AStaticMeshActor*> Cells;
+
+	UPROPERTY(Transient)
+	TArray<AStaticMeshActor*> Paths;
+
+	UPROPERTY(Transient)
+	TArray<FVector> Rooms;
+
+	UPROPERTY(Transient)
+	UHierarchicalInstancedStaticMeshComponent* RoomInstances{nullptr};
+
+	UPROPERTY(Transient)
+	UHierarchicalInstancedStaticMeshComponent* PathInstances{nullptr};
+
+	UPROPERTY(Transient)
+	UHierarchicalInstancedStaticMeshComponent* StairInstances{nullptr};
+
+	// What Paths holds in place of single tiles when the corridors were merged, and the tile spacing they were merged at
+	std::vector<DungeonCore::CorridorStrip> Strips;
+	double SectionLength{0.};
+	bool bMergedCorridors{false};
 };
 
 UCLASS()
@@ -30,9 +162,28 @@ public:
 	// Sets default values for this actor's properties
 	ADungeonGenerator();
 
+	// Core settings for the current properties, the batch commandlet reads them off a generator's defaults
+	DungeonCore::DungeonParams MakeLayoutParams() const;
+
+	// Waypoints from Start to End over the room graph: the centre of every room on the way, both ends of each
+	// stairwell climbed and End last. Agents only need fine navigation from one waypoint to the next, so nav
+	// mesh does not have to span the dungeon at once. Start and End snap to the room they are in or closest to.
+	// False if there is no layout, sectors are being streamed or the rooms are not connected.
+	UFUNCTION(BlueprintCallable, Category="Dungeon Generation|Navigation")
+	bool FindDungeonPath(const FVector& Start, const FVector& End, TArray<FVector>& OutWaypoints);
+
+	// Length of the shortest walk between two rooms over the room graph, -1 if there is none
+	UFUNCTION(BlueprintCallable, Category="Dungeon Generation|Navigation")
+	float GetDungeonRoomDistance(int32 FromRoom, int32 ToRoom);
+
+	// Box around every room and corridor of the layout, to fit nav mesh bounds to the dungeon. Invalid without one.
+	UFUNCTION(BlueprintPure, Category="Dungeon Generation|Navigation")
+	FBox GetDungeonBounds() const;
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	
 	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation")
 	UStaticMesh* RoomMesh;
@@ -49,8 +200,50 @@ protected:
 	UFUNCTION(BlueprintCallable, Category="Dungeon Generation")
 	void GenerateDungeon();
 
+	// Computes the layout on a worker thread, OnDungeonGenerated fires on the game thread once it is ready to spawn
+	UFUNCTION(BlueprintCallable, Category="Dungeon Generation")
+	void GenerateDungeonAsync();
+
+	// Also cancels a running GenerateDungeonAsync, whose result is then dropped
 	UFUNCTION(BlueprintCallable, Category="Dungeon Generation")
 	void ClearDungeon();
+
+	// Writes the current layout with its settings and seed to a versioned binary file, false if there is none
+	UFUNCTION(BlueprintCallable, Category="Dungeon Generation")
+	bool SaveDungeonLayout(const FString& FilePath) const;
+
+	// Spawns a layout written by SaveDungeonLayout without running the generator, the stored settings
+	// and seed replace the current ones. False if the file is missing, damaged or from a newer version.
+	UFUNCTION(BlueprintCallable, Category="Dungeon Generation")
+	bool LoadDungeonLayout(const FString& FilePath);
+
+	// 0 to 1 while GenerateDungeonAsync runs
+	UFUNCTION(BlueprintPure, Category="Dungeon Generation")
+	float GetGenerationProgress() const;
+
+	UFUNCTION(BlueprintPure, Category="Dungeon Generation")
+	bool IsGenerating() const;
+
+	UFUNCTION(BlueprintCallable, Category="Dungeon Generation")
+	FDungeonGenerationStats GetLastGenerationStats() const;
+
+	UPROPERTY(BlueprintAssignable, Category="Dungeon Generation")
+	FOnDungeonGenerated OnDungeonGenerated;
+
+	// Fires once every room and corridor of the last layout has been spawned
+	UPROPERTY(BlueprintAssignable, Category="Dungeon Generation")
+	FOnDungeonGenerated OnDungeonMaterialized;
+
+	// Share of the last layout spawned so far
+	UFUNCTION(BlueprintPure, Category="Dungeon Generation")
+	float GetMaterializationProgress() const;
+
+	UFUNCTION(BlueprintPure, Category="Dungeon Generation")
+	bool IsMaterializing() const;
+
+	// Spawning time allowed per frame in game worlds, content nearest the player first. 0 spawns everything at once.
+	UPROPERTY(EditInstanceOnly, BlueprintReadWrite, Category="Dungeon Generation", meta=(ClampMin="0"))
+	float MaterializeBudgetMs{2.f};
 	
 	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation")
 	int MinSize;
@@ -61,11 +254,110 @@ protected:
 	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation")
 	float SpawnRadius;
 	
+	// Only used by Steering separation
 	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation")
 	float MinDistance;
 
+	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation|Separation")
+	EDungeonSeparationMethod SeparationMethod{EDungeonSeparationMethod::Penetration};
+
+	// Deepest overlap between two rooms Penetration separation leaves
+	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation|Separation", meta=(ClampMin="0"))
+	float SeparationTolerance{1.f};
+
+	// Separation stops after this many iterations even if rooms still overlap
+	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation|Separation", meta=(ClampMin="1"))
+	int32 MaxSeparationSteps{2000};
+
 	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation")
 	int SnapSize{5};
+
+	// Storeys stacked FloorHeight apart, cells are shared out between them and neighbouring floors are linked by stairs
+	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation", meta=(ClampMin="1"))
+	int32 NumFloors{1};
+
+	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation", meta=(ClampMin="1"))
+	float FloorHeight{600.f};
+
+	// Stretched to span one floor, PathMesh is used when unset
+	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation")
+	UStaticMesh* StairMesh{nullptr};
+
+	// Same seed and settings always give the same dungeon
+	UPROPERTY(EditInstanceOnly, BlueprintReadWrite, Category="Dungeon Generation")
+	int32 Seed{0};
+
+	// Pick a fresh seed on every GenerateDungeon, the chosen one is written back to Seed
+	UPROPERTY(EditInstanceOnly, BlueprintReadWrite, Category="Dungeon Generation")
+	bool bRandomizeSeed{true};
+
+	// Streams an endless dungeon in square sectors around the player instead of one layout. Every sector uses
+	// the cell settings above with its own seed derived from Seed, so a sector always comes back the same.
+	// Game worlds only, ClearDungeon or StopSectorStreaming release everything.
+	UFUNCTION(BlueprintCallable, Category="Dungeon Generation|Streaming")
+	void StartSectorStreaming();
+
+	UFUNCTION(BlueprintCallable, Category="Dungeon Generation|Streaming")
+	void StopSectorStreaming();
+
+	UFUNCTION(BlueprintPure, Category="Dungeon Generation|Streaming")
+	bool IsStreaming() const;
+
+	// Side of a sector, keep it well above twice SpawnRadius so rooms are not clipped away
+	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation|Streaming", meta=(ClampMin="1"))
+	float SectorSize{12000.f};
+
+	// Sectors kept spawned on each side of the player's sector, 1 gives a 3x3 block
+	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation|Streaming", meta=(ClampMin="0"))
+	int32 ActiveSectorRadius{1};
+
+	// Sector layouts generated on worker threads at the same time
+	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation|Streaming", meta=(ClampMin="1"))
+	int32 MaxSectorJobs{2};
+
+	// Straight runs of corridor tiles spawn as one stretched PathMesh piece with a single collision box instead of
+	// one piece per tile. PathMesh has to be one SectionLegnth long for the pieces to line up.
+	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation")
+	bool bMergeCorridorTiles{true};
+
+	// Instanced output needs materials reading PerInstanceCustomData: 0-2 colour, 3 type (0 room, 1 corridor)
+	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation")
+	EDungeonOutputMode OutputMode{EDungeonOutputMode::Actors};
+
+	// Cleared room and corridor actors are hidden and kept for the next generation instead of destroyed,
+	// up to this many. Actors released past it are destroyed. 0 turns pooling off.
+	UPROPERTY(EditInstanceOnly, BlueprintReadWrite, Category="Dungeon Generation|Pooling", meta=(ClampMin="0"))
+	int32 MaxPooledActors{4096};
+
+	// Destroys every pooled actor and instanced component, the next generation spawns from scratch
+	UFUNCTION(BlueprintCallable, Category="Dungeon Generation|Pooling")
+	void EmptyPool();
+
+	UFUNCTION(BlueprintPure, Category="Dungeon Generation|Pooling")
+	int32 GetNumPooledActors() const;
+
+	// Adds a room of the given half size on the floor Location.Z falls in. Only its own corridors and those
+	// running where it now stands are routed and spawned, the rest of the dungeon stays as it is. Index of the
+	// new room, -1 if there is no layout to edit, sectors are being streamed, the floor does not exist or the
+	// room would overlap another.
+	UFUNCTION(BlueprintCallable, Category="Dungeon Generation|Editing")
+	int32 AddDungeonRoom(const FVector& Location, const FVector2D& HalfExtent);
+
+	// Reconnects the rooms it linked and drops the corridors nothing walks anymore. The last room takes over its index.
+	UFUNCTION(BlueprintCallable, Category="Dungeon Generation|Editing")
+	bool RemoveDungeonRoom(int32 RoomIndex);
+
+	// Moves a room on its own floor, Location.Z is ignored. False if it would overlap another room.
+	UFUNCTION(BlueprintCallable, Category="Dungeon Generation|Editing")
+	bool MoveDungeonRoom(int32 RoomIndex, const FVector& Location);
+
+	// Index of the room covering Location on the floor Location.Z falls in, -1 if there is none
+	UFUNCTION(BlueprintPure, Category="Dungeon Generation|Editing")
+	int32 FindDungeonRoomAt(const FVector& Location) const;
+
+	// Rooms FindDungeonPath keeps the distances to every other room for, the least recently used are dropped
+	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category="Dungeon Generation|Navigation", meta=(ClampMin="1"))
+	int32 MaxCachedPathTargets{64};
 	
 public:	
 	// Called every frame
@@ -73,19 +365,98 @@ public:
 
 private:
 
-	TArray<class AStaticMeshActor*> SpawnedCells;
-	TArray<class AStaticMeshActor*> SpawnedPath;
-	TArray<FVector> Rooms;
+	UPROPERTY(Transient)
+	FDungeonGeometry Geometry;
+
+	// Spawned sectors while streaming, keyed by sector coordinate
+	UPROPERTY(Transient)
+	TMap<FIntPoint, FDungeonGeometry> SectorGeometry;
+
+	// Hidden actors and emptied instanced components waiting to be reused, cells and paths apart so a
+	// pooled room keeps its material instance
+	UPROPERTY(Transient)
+	TArray<AStaticMeshActor*> PooledCells;
+
+	UPROPERTY(Transient)
+	TArray<AStaticMeshActor*> PooledPaths;
+
+	UPROPERTY(Transient)
+	TArray<UHierarchicalInstancedStaticMeshComponent*> PooledInstances;
+
+	// Last layout produced by DungeonCore, the spawned actors are built from it
+	DungeonCore::DungeonLayout Layout;
+
+	// Inputs Layout was generated from, saved along with it
+	DungeonCore::DungeonParams LayoutParams;
+	uint32 LayoutSeed{0};
+
+	// Layouts of recent (seed, settings) pairs, regenerating one of them skips the core entirely.
+	// Shared so a worker can still use it if the actor goes away mid generation.
+	std::shared_ptr<DungeonCore::LayoutCache> LayoutCache{std::make_shared<DungeonCore::LayoutCache>()};
+
+	// Edits Layout in place, set up on the first edit after a new layout arrives since it routes every corridor once
+	DungeonCore::LayoutEditor Editor;
+
+	// Room graph of Layout for path queries, built on the first query after the layout changes
+	DungeonCore::RoomNavigator Navigator;
+
+	FDungeonGenerationStats LastStats;
+
+	// Layout items still waiting to be spawned
+	DungeonCore::MaterializationQueue MaterializeQueue;
+
+	// Generation running on a worker, null when idle
+	TSharedPtr<FDungeonGenerationJob, ESPMode::ThreadSafe> ActiveJob;
+
+	DungeonCore::SectorStreamer Streamer;
+	bool bStreaming{false};
 
-	FVector Separate(AStaticMeshActor* CurrentCell);
+	// Sector layouts being generated on workers
+	TMap<FIntPoint, TSharedPtr<FDungeonSectorJob, ESPMode::ThreadSafe>> SectorJobs;
 
-	FVector GetRandomPointInCircle(float radius);
-	int RoundM(float loc, int snapSize);
-	FVector RoundM(FVector loc, int snapSize);
-	Bounds GetRoomExtentByLocation(FVector Location);
-	DGEdge GetClosestEdge(FVector start, FVector end);
-	bool IsOverlappingRoom(FVector loc);
+	// Ready sectors waiting to be spawned, nearest first, and the one being spawned
+	TArray<FIntPoint> PendingSectors;
+	FIntPoint MaterializingSector;
+	DungeonCore::MaterializationQueue SectorQueue;
 
-	bool bIsDungeonGenerating = false;
-	bool bIsSeparating = false;
+	uint32 NextSeed();
+	void CancelGeneration();
+	void FinishGeneration(const TSharedPtr<FDungeonGenerationJob, ESPMode::ThreadSafe>& Job);
+	void MaterializeLayout();
+	void PublishStats(bool bFromCache);
+	bool BeginLayoutEdit();
+	int32 GetFloorAt(double Z) const;
+	bool BeginNavigation();
+	void ApplyLayoutChanges(const DungeonCore::LayoutChanges& Changes);
+	void ReleaseActorsAt(TArray<AStaticMeshActor*>& Actors, TArray<AStaticMeshActor*>& Pool, TSet<FIntVector>& Locations);
+	void RemoveInstancesAt(UHierarchicalInstancedStaticMeshComponent* Instances, TSet<FIntVector>& Locations);
+	FVector GetFocusLocation() const;
+	void UpdateMaterializeFocus();
+	void UpdateTickEnabled();
+	void ProcessMaterializeQueue(double BudgetSeconds);
+	void MaterializeItems(DungeonCore::MaterializationQueue& Queue, const DungeonCore::DungeonLayout& Source,
+	                      FDungeonGeometry& Target, double EndTime);
+	void ReleaseGeometry(FDungeonGeometry& Target, bool bKeepComponents);
+	void UpdateSectorStreaming(double BudgetSeconds);
+	void LaunchSectorJob(const DungeonCore::SectorCoord& Coord);
+	void FinishSectorJob(const FIntPoint& Sector, const TSharedPtr<FDungeonSectorJob, ESPMode::ThreadSafe>& Job);
+	void ReleaseSector(const FIntPoint& Sector);
+	void MaterializePendingSectors(double EndTime);
+	void SpawnCellActor(const DungeonCore::Cell& LayoutCell, const FVector& Location, FDungeonGeometry& Target);
+	void SpawnPathActor(const DungeonCore::Vec3& Tile, FDungeonGeometry& Target);
+	void SpawnStairActor(const FTransform& Transform, FDungeonGeometry& Target);
+	void SpawnStripActor(const FTransform& Transform, FDungeonGeometry& Target);
+	void MergeCorridors(const DungeonCore::DungeonLayout& Source, double SectionLength, FDungeonGeometry& Target) const;
+	UStaticMesh* GetStairMesh() const;
+	FTransform MakeStairTransform(const DungeonCore::Stairwell& Stair, const DungeonCore::DungeonLayout& Source) const;
+	void AddInstanceBatch(UHierarchicalInstancedStaticMeshComponent* Instances, const TArray<FTransform>& Transforms,
+	                      const FLinearColor& Color, float Type);
+	UHierarchicalInstancedStaticMeshComponent* GetOrCreateInstances(UHierarchicalInstancedStaticMeshComponent*& Instances,
+	                                                                UStaticMesh* Mesh, FName Name);
+	AStaticMeshActor* SpawnMeshActor(UStaticMesh* Mesh, const FVector& Location, const FActorSpawnParameters& SpawnParams,
+	                                 TArray<AStaticMeshActor*>& Pool);
+	AStaticMeshActor* ReuseMeshActor(UStaticMesh* Mesh, const FVector& Location, const FActorSpawnParameters& SpawnParams,
+	                                 TArray<AStaticMeshActor*>& Pool);
+	void ReleaseMeshActor(AStaticMeshActor* MeshActor, TArray<AStaticMeshActor*>& Pool);
+	void ReleaseInstances(UHierarchicalInstancedStaticMeshComponent* Instances);
 };
@@ -1,56 +1,42 @@
 ﻿#pragma once
 #include <vector>
-#include <unordered_set>
 
 #include "DelaunayTriangulation.h"
+#include "DungeonCore/SpanningTree.h"
 
 using Edges = std::vector<DelaunayTriangle3D::Edge<UE::Math::TVector<double>>>;
 using Edge = DelaunayTriangle3D::Edge<UE::Math::TVector<double>>;
 
 namespace MST
 {
-	Edges MinimumSpanningTree(const Edges& EdgeList, FVector start)
+	/*
+	 * Kruskal spanning tree over the FVector edge list, see DungeonCore::MinimumSpanningTree. Vertices are
+	 * mapped to ids once and weighed by their exact distance. start is kept for source compatibility, every
+	 * component of the edge list is spanned.
+	 */
+	inline Edges MinimumSpanningTree(const Edges& EdgeList, FVector start)
 	{
-		TArray<FVector> OpenSet;
-		TArray<FVector> CloseSet;
+		TMap<FVector, int32> VertexIds;
+		const auto GetVertexId = [&VertexIds](const FVector& Vertex)
+		{
+			return VertexIds.FindOrAdd(Vertex, VertexIds.Num());
+		};
 
-		for (auto edge : EdgeList)
+		GetVertexId(start);
+		std::vector<DungeonCore::IndexEdge> IndexEdges;
+		IndexEdges.reserve(EdgeList.size());
+		for (const auto& edge : EdgeList)
 		{
-			OpenSet.Add(edge.p0);
-			OpenSet.Add(edge.p1);
+			const int32 A = GetVertexId(edge.p0);
+			const int32 B = GetVertexId(edge.p1);
+			IndexEdges.push_back({A, B, FVector::Distance(edge.p0, edge.p1)});
 		}
 
-		CloseSet.Add(start);
-
 		Edges results;
-
-		while (OpenSet.Num() > 0)
+		for (const int32 EdgeIndex : DungeonCore::MinimumSpanningTree(IndexEdges, VertexIds.Num()))
 		{
-			bool chosen = false;
-			Edge chosenEdge = {{0,0,0}, {0,0,0}, 0};
-			float minWeight = std::numeric_limits<float>::infinity();
-
-			for (auto edge : EdgeList)
-			{
-				int closedVertices = 0;
-				if (!CloseSet.Contains(edge.p0)) closedVertices++;
-				if (!CloseSet.Contains(edge.p1)) closedVertices++;
-				if (closedVertices != 1) continue;
-
-				if (edge.Weight < minWeight) {
-					chosenEdge = edge;
-					chosen = true;
-					minWeight = edge.Weight;
-				}
-			}
-
-			if (!chosen) break;
-			results.push_back(chosenEdge);
-			OpenSet.Add(chosenEdge.p0);
-			OpenSet.Add(chosenEdge.p1);
-			CloseSet.Add(chosenEdge.p0);
-			CloseSet.Add(chosenEdge.p1);
+			results.push_back(EdgeList[EdgeIndex]);
 		}
 		return results;
-	};
+	}
 }
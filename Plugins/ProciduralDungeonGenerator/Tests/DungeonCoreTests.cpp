@@ -0,0 +1,1437 @@
+// Headless tests for the DungeonCore generation pipeline, run through ctest.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "DungeonCore/BatchGeneration.h"
+#include "DungeonCore/CorridorRouter.h"
+#include "DungeonCore/CorridorStrips.h"
+#include "DungeonCore/DungeonLayoutGenerator.h"
+#include "DungeonCore/LayoutCache.h"
+#include "DungeonCore/LayoutEditor.h"
+#include "DungeonCore/LayoutSerialization.h"
+#include "DungeonCore/MaterializationQueue.h"
+#include "DungeonCore/OccupancyGrid.h"
+#include "DungeonCore/Parallel.h"
+#include "DungeonCore/Random.h"
+#include "DungeonCore/RoomNavigator.h"
+#include "DungeonCore/SectorStreaming.h"
+#include "DungeonCore/SeparationSolver.h"
+#include "DungeonCore/SpanningTree.h"
+#include "DungeonCore/SpatialGrid.h"
+#include "DungeonCore/Triangulation.h"
+
+using namespace DungeonCore;
+
+namespace
+{
+	int Failures = 0;
+
+#define CHECK(Condition) \
+	do \
+	{ \
+		if (!(Condition)) \
+		{ \
+			std::printf("  %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #Condition); \
+			++Failures; \
+		} \
+	} while (false)
+
+	struct TestCase
+	{
+		const char* Name;
+		std::function<void()> Body;
+	};
+
+	std::vector<TestCase>& GetTests()
+	{
+		static std::vector<TestCase> Tests;
+		return Tests;
+	}
+
+	struct TestRegistrar
+	{
+		TestRegistrar(const char* Name, std::function<void()> Body)
+		{
+			GetTests().push_back({Name, std::move(Body)});
+		}
+	};
+
+#define TEST(Name) \
+	void Name(); \
+	TestRegistrar Name##Registrar{#Name, Name}; \
+	void Name()
+
+	/* Number of connected components of the room graph, 1 means everything is reachable. */
+	int CountComponents(int NumVertices, const std::vector<RoomEdge>& Edges)
+	{
+		std::vector<int> Parent(NumVertices);
+		std::iota(Parent.begin(), Parent.end(), 0);
+		std::function<int(int)> Find = [&](int V) { return Parent[V] == V ? V : Parent[V] = Find(Parent[V]); };
+
+		int Components = NumVertices;
+		for (const RoomEdge& Edge : Edges)
+		{
+			const int A = Find(Edge.A);
+			const int B = Find(Edge.B);
+			if (A != B)
+			{
+				Parent[A] = B;
+				--Components;
+			}
+		}
+		return Components;
+	}
+
+	TEST(TriangulateSquare)
+	{
+		const Triangulation DT = Triangulate({{0, 0}, {100, 0}, {100, 100}, {0, 110}});
+		CHECK(DT.NumTriangles() == 2);
+		CHECK(DT.Edges.size() == 5);
+		CHECK(DT.Hull.size() == 4);
+	}
+
+	TEST(TriangulateRandomPointsIsDelaunay)
+	{
+		RandomEngine Rng{7};
+		std::uniform_real_distribution<double> Coord(-5000., 5000.);
+		std::vector<Vec2> Points;
+		for (int i = 0; i < 400; ++i)
+		{
+			Points.push_back({Coord(Rng), Coord(Rng)});
+		}
+
+		const Triangulation DT = Triangulate(Points);
+		CHECK(DT.NumTriangles() > 0);
+
+		/* No point may lie strictly inside any triangle circumcircle. */
+		int Violations = 0;
+		for (int32_t t = 0; t < DT.NumTriangles(); ++t)
+		{
+			const Vec2& A = Points[DT.Triangles[3 * t]];
+			const Vec2& B = Points[DT.Triangles[3 * t + 1]];
+			const Vec2& C = Points[DT.Triangles[3 * t + 2]];
+			const double D = 2. * (A.X * (B.Y - C.Y) + B.X * (C.Y - A.Y) + C.X * (A.Y - B.Y));
+			const Vec2 Center{
+				(A.SizeSquared() * (B.Y - C.Y) + B.SizeSquared() * (C.Y - A.Y) + C.SizeSquared() * (A.Y - B.Y)) / D,
+				(A.SizeSquared() * (C.X - B.X) + B.SizeSquared() * (A.X - C.X) + C.SizeSquared() * (B.X - A.X)) / D};
+			const double RadiusSq = (A - Center).SizeSquared();
+			for (const Vec2& Point : Points)
+			{
+				if ((Point - Center).SizeSquared() < RadiusSq * (1. - 1e-9))
+				{
+					++Violations;
+				}
+			}
+		}
+		CHECK(Violations == 0);
+	}
+
+	TEST(TriangulateGridPoints)
+	{
+		std::vector<Vec2> Points;
+		for (int x = 0; x < 10; ++x)
+		{
+			for (int y = 0; y < 10; ++y)
+			{
+				Points.push_back({x * 100., y * 100.});
+			}
+		}
+		CHECK(Triangulate(Points).NumTriangles() == 2 * 9 * 9);
+	}
+
+	TEST(TriangulateTooFewPoints)
+	{
+		CHECK(Triangulate({{0, 0}, {100, 0}}).NumTriangles() == 0);
+		CHECK(Triangulate({{0, 0}, {100, 0}, {200, 0}, {300, 0}}).NumTriangles() == 0);
+	}
+
+	TEST(TriangulationHalfEdgesAreConsistent)
+	{
+		RandomEngine Rng{11};
+		std::uniform_real_distribution<double> Coord(0., 1000.);
+		std::vector<Vec2> Points;
+		for (int i = 0; i < 200; ++i)
+		{
+			Points.push_back({Coord(Rng), Coord(Rng)});
+		}
+
+		const Triangulation DT = Triangulate(Points);
+		int HullHalfEdges = 0;
+		for (int32_t e = 0; e < static_cast<int32_t>(DT.HalfEdges.size()); ++e)
+		{
+			const int32_t Twin = DT.HalfEdges[e];
+			if (Twin == -1)
+			{
+				++HullHalfEdges;
+				continue;
+			}
+			CHECK(DT.HalfEdges[Twin] == e);
+			CHECK(DT.Triangles[Twin] == DT.Triangles[Triangulation::NextHalfEdge(e)]);
+			CHECK(DT.Triangles[e] == DT.Triangles[Triangulation::NextHalfEdge(Twin)]);
+		}
+
+		/* Euler: every undirected edge once, E = V + T - 1. */
+		CHECK(HullHalfEdges == static_cast<int>(DT.Hull.size()));
+		CHECK(DT.Edges.size() == Points.size() + DT.NumTriangles() - 1);
+	}
+
+	TEST(SpanningTreeOfTriangulation)
+	{
+		const std::vector<Vec2> Points{{0, 0}, {300, 0}, {600, 50}, {0, 400}, {350, 380}, {650, 420}};
+		const Triangulation DT = Triangulate(Points);
+		const std::vector<int32_t> Tree = MinimumSpanningTree(DT.Edges, static_cast<int32_t>(Points.size()));
+		CHECK(Tree.size() == Points.size() - 1);
+
+		std::vector<RoomEdge> Edges;
+		for (const int32_t EdgeIndex : Tree)
+		{
+			Edges.push_back({DT.Edges[EdgeIndex].A, DT.Edges[EdgeIndex].B, DT.Edges[EdgeIndex].Weight, false});
+		}
+		CHECK(CountComponents(static_cast<int>(Points.size()), Edges) == 1);
+	}
+
+	TEST(SpanningTreeMatchesPrimWeight)
+	{
+		RandomEngine Rng{3};
+		std::uniform_real_distribution<double> Coord(0., 10000.);
+		std::vector<Vec2> Points;
+		for (int i = 0; i < 300; ++i)
+		{
+			Points.push_back({Coord(Rng), Coord(Rng)});
+		}
+		const Triangulation DT = Triangulate(Points);
+
+		double KruskalWeight = 0.;
+		for (const int32_t EdgeIndex : MinimumSpanningTree(DT.Edges, static_cast<int32_t>(Points.size())))
+		{
+			KruskalWeight += DT.Edges[EdgeIndex].Weight;
+		}
+
+		/* Reference O(V * E) Prim. */
+		double PrimWeight = 0.;
+		std::vector<bool> Closed(Points.size(), false);
+		Closed[0] = true;
+		for (size_t Added = 1; Added < Points.size(); ++Added)
+		{
+			const IndexEdge* Best = nullptr;
+			for (const IndexEdge& Edge : DT.Edges)
+			{
+				if (Closed[Edge.A] != Closed[Edge.B] && (!Best || Edge.Weight < Best->Weight))
+				{
+					Best = &Edge;
+				}
+			}
+			Closed[Best->A] = Closed[Best->B] = true;
+			PrimWeight += Best->Weight;
+		}
+		CHECK(std::abs(KruskalWeight - PrimWeight) < 1e-6);
+	}
+
+	TEST(SpanningTreeTieBreakIgnoresEdgeOrder)
+	{
+		/* Unit grid, every edge has the same weight. */
+		std::vector<IndexEdge> Edges;
+		for (int32_t y = 0; y < 4; ++y)
+		{
+			for (int32_t x = 0; x < 4; ++x)
+			{
+				const int32_t Id = y * 4 + x;
+				if (x < 3)
+				{
+					Edges.push_back({Id, Id + 1, 1.});
+				}
+				if (y < 3)
+				{
+					Edges.push_back({Id + 4, Id, 1.});
+				}
+			}
+		}
+
+		std::vector<IndexEdge> Reversed(Edges.rbegin(), Edges.rend());
+		const auto TreeEdges = [](const std::vector<IndexEdge>& List)
+		{
+			std::vector<std::pair<int32_t, int32_t>> Result;
+			for (const int32_t EdgeIndex : MinimumSpanningTree(List, 16))
+			{
+				Result.push_back(std::minmax(List[EdgeIndex].A, List[EdgeIndex].B));
+			}
+			return Result;
+		};
+		CHECK(TreeEdges(Edges) == TreeEdges(Reversed));
+		CHECK(TreeEdges(Edges).size() == 15);
+	}
+
+	TEST(SpatialGridFindsAllNeighbours)
+	{
+		RandomEngine Rng{5};
+		std::uniform_real_distribution<double> Coord(-3000., 3000.);
+		std::vector<Vec2> Points;
+		for (int i = 0; i < 500; ++i)
+		{
+			Points.push_back({Coord(Rng), Coord(Rng)});
+		}
+
+		const double Radius = 250.;
+		SpatialGrid Grid;
+		Grid.Build(Points, Radius);
+
+		for (const Vec2& Query : Points)
+		{
+			std::vector<int32_t> Found;
+			Grid.ForEachNear(Query, [&](int32_t Index)
+			{
+				if ((Points[Index] - Query).Size() <= Radius)
+				{
+					Found.push_back(Index);
+				}
+			});
+
+			std::vector<int32_t> Expected;
+			for (int32_t Index = 0; Index < static_cast<int32_t>(Points.size()); ++Index)
+			{
+				if ((Points[Index] - Query).Size() <= Radius)
+				{
+					Expected.push_back(Index);
+				}
+			}
+			std::sort(Found.begin(), Found.end());
+			CHECK(Found == Expected);
+		}
+	}
+
+	TEST(SeparationRemovesCloseNeighbours)
+	{
+		DungeonParams Params;
+		Params.NumberOfCells = 60;
+		Params.SpawnRadius = 500.f;
+		Params.MinDistance = 400.f;
+		Params.Separation = SeparationMethod::Steering;
+
+		RandomEngine Rng{1234};
+		DungeonLayout Layout;
+		SpawnCells(Params, Rng, Layout);
+		SeparateCells(Params, Layout);
+
+		CHECK(Layout.SeparationSteps < Params.MaxSeparationSteps);
+		for (size_t i = 0; i < Layout.Cells.size(); ++i)
+		{
+			for (size_t j = i + 1; j < Layout.Cells.size(); ++j)
+			{
+				CHECK((Layout.Cells[i].Location - Layout.Cells[j].Location).Size() > Params.MinDistance);
+			}
+		}
+	}
+
+	TEST(SeparationIgnoresChunkOrder)
+	{
+		DungeonParams Params;
+		Params.NumberOfCells = 2000;
+		Params.SpawnRadius = 8000.f;
+
+		RandomEngine Rng{99};
+		DungeonLayout Layout;
+		SpawnCells(Params, Rng, Layout);
+
+		const auto Solve = [&](ParallelExecutor Executor)
+		{
+			SetParallelExecutor(Executor);
+			SeparationSolver Solver;
+			Solver.Init(Layout.Cells, Params.MinDistance);
+			for (int Step = 0; Step < 20; ++Step)
+			{
+				Solver.Step();
+			}
+			return Solver.GetPositions();
+		};
+
+		/* Same positions on one thread, on all threads and with chunks run back to front. */
+		const std::vector<Vec2> Serial = Solve(nullptr);
+		const std::vector<Vec2> Threaded = Solve(&ThreadParallelExecutor);
+		const std::vector<Vec2> Reversed = Solve([](int32_t NumChunks, const std::function<void(int32_t)>& Chunk)
+		{
+			for (int32_t Index = NumChunks - 1; Index >= 0; --Index)
+			{
+				Chunk(Index);
+			}
+		});
+		SetParallelExecutor(&ThreadParallelExecutor);
+
+		CHECK(Serial == Threaded);
+		CHECK(Serial == Reversed);
+	}
+
+	TEST(OccupancyGridMatchesLinearScan)
+	{
+		DungeonParams Params;
+		RandomEngine Rng{7};
+		const DungeonLayout Layout = GenerateLayout(Params, 7);
+
+		OccupancyGrid Occupancy;
+		Occupancy.Init(Layout, Params.SectionLength);
+
+		/* Random probes plus room centres and corners, which sit exactly on the strict bounds. */
+		std::vector<Vec2> Probes;
+		std::uniform_real_distribution<double> Coord(-Params.SpawnRadius * 2., Params.SpawnRadius * 2.);
+		for (int Index = 0; Index < 5000; ++Index)
+		{
+			Probes.push_back({Coord(Rng), Coord(Rng)});
+		}
+		for (const Room& Current : Layout.Rooms)
+		{
+			const Bounds2D& Bounds = Current.Bounds;
+			Probes.push_back(Bounds.Origin);
+			Probes.push_back(Bounds.Origin + Bounds.Extent);
+			Probes.push_back(Bounds.Origin - Bounds.Extent);
+		}
+
+		for (const Vec2& Probe : Probes)
+		{
+			CHECK(Occupancy.IsInsideRoom(Probe) == IsOverlappingRoom(Layout, Probe));
+		}
+
+		CHECK(Occupancy.AddTile({10., 20., -5.}));
+		CHECK(!Occupancy.AddTile({10., 20., -5.}));
+		CHECK(Occupancy.AddTile({10.5, 20., -5.}));
+		CHECK(Occupancy.HasTile({10.5, 20., -5.}));
+		CHECK(!Occupancy.HasTile({-10., 20., -5.}));
+	}
+
+	TEST(RandomEngineMatchesPcgReference)
+	{
+		/* First outputs of the reference pcg32 demo for seed 42, stream 54. */
+		RandomEngine Rng{42, 54};
+		const uint32_t Expected[] = {0xa15c02b7, 0x7b47f409, 0xba1d3330, 0x83d2f293, 0xbfa4784b, 0xcbed606e};
+		for (const uint32_t Value : Expected)
+		{
+			CHECK(Rng.Next() == Value);
+		}
+
+		for (int Draw = 0; Draw < 1000; ++Draw)
+		{
+			const int Value = RandRange(Rng, -3, 4);
+			CHECK(Value >= -3 && Value <= 4);
+			const float Unit = RandomFloat(Rng);
+			CHECK(Unit >= 0.f && Unit < 1.f);
+		}
+	}
+
+	TEST(GenerateLayoutIsDeterministic)
+	{
+		const auto SameLayout = [](const DungeonLayout& A, const DungeonLayout& B)
+		{
+			if (A.Cells.size() != B.Cells.size() || A.Rooms != B.Rooms || A.Edges.size() != B.Edges.size() ||
+				A.CorridorTiles != B.CorridorTiles)
+			{
+				return false;
+			}
+			for (size_t Index = 0; Index < A.Cells.size(); ++Index)
+			{
+				if (A.Cells[Index].Location != B.Cells[Index].Location || A.Cells[Index].Scale != B.Cells[Index].Scale)
+				{
+					return false;
+				}
+			}
+			for (size_t Index = 0; Index < A.Edges.size(); ++Index)
+			{
+				if (A.Edges[Index].A != B.Edges[Index].A || A.Edges[Index].B != B.Edges[Index].B ||
+					A.Edges[Index].bIsLoop != B.Edges[Index].bIsLoop)
+				{
+					return false;
+				}
+			}
+			return true;
+		};
+
+		DungeonParams Params;
+		CHECK(SameLayout(GenerateLayout(Params, 123), GenerateLayout(Params, 123)));
+		CHECK(!SameLayout(GenerateLayout(Params, 123), GenerateLayout(Params, 124)));
+	}
+
+	TEST(LayoutCacheReturnsCachedLayout)
+	{
+		LayoutCache Cache{2};
+		DungeonParams Params;
+
+		const auto First = Cache.GetOrGenerate(Params, 1);
+		CHECK(Cache.GetOrGenerate(Params, 1) == First);
+		CHECK(Cache.Find(Params, 2) == nullptr);
+
+		DungeonParams Other = Params;
+		Other.NumberOfCells += 1;
+		CHECK(Cache.Find(Other, 1) == nullptr);
+
+		/* Seed 1 was used last, so adding a third key evicts seed 2. */
+		Cache.GetOrGenerate(Params, 2);
+		Cache.Find(Params, 1);
+		Cache.GetOrGenerate(Other, 1);
+		CHECK(Cache.Num() == 2);
+		CHECK(Cache.Find(Params, 1) == First);
+		CHECK(Cache.Find(Params, 2) == nullptr);
+	}
+
+	TEST(GenerateLayoutReportsProgressAndCancels)
+	{
+		DungeonParams Params;
+
+		GenerationProgress Progress;
+		const DungeonLayout Layout = GenerateLayout(Params, 5, &Progress);
+		CHECK(Progress.Get() == 1.f);
+		CHECK(!Layout.CorridorTiles.empty());
+
+		/* A cancel before the run stops it after spawning and keeps it out of the cache. */
+		GenerationProgress Cancelled;
+		Cancelled.Cancel();
+		CHECK(GenerateLayout(Params, 5, &Cancelled).Rooms.empty());
+		CHECK(Cancelled.Get() < 1.f);
+
+		LayoutCache Cache;
+		CHECK(Cache.GetOrGenerate(Params, 5, &Cancelled) == nullptr);
+		CHECK(Cache.Num() == 0);
+	}
+
+	TEST(MaterializationQueueSpawnsNearestFirst)
+	{
+		DungeonParams Params;
+		const DungeonLayout Layout = GenerateLayout(Params, 3);
+
+		MaterializationQueue Queue;
+		Queue.Reset(Layout, false);
+		CHECK(Queue.NumTotal() == Layout.Rooms.size() + Layout.CorridorTiles.size());
+		CHECK(Queue.GetProgress() == 0.f);
+
+		const Vec2 Focus{Params.SpawnRadius, 0.};
+		Queue.SetFocus(Focus);
+
+		/* Rooms first, then tiles, each group by ascending distance to the focus. */
+		LayoutItem Item;
+		LayoutItemType PreviousType = LayoutItemType::Cell;
+		double PreviousDistance = 0.;
+		size_t NumPopped = 0;
+		while (Queue.Pop(Item))
+		{
+			Vec2 Location;
+			if (Item.Type == LayoutItemType::Cell)
+			{
+				CHECK(PreviousType == LayoutItemType::Cell);
+				CHECK(Layout.Cells[Item.Index].bIsRoom);
+				Location = Layout.Cells[Item.Index].Location;
+			}
+			else
+			{
+				if (PreviousType == LayoutItemType::Cell)
+				{
+					PreviousDistance = 0.;
+				}
+				const Vec3& Tile = Layout.CorridorTiles[Item.Index];
+				Location = {Tile.X, Tile.Y};
+			}
+
+			const double Distance = (Location - Focus).SizeSquared();
+			CHECK(Distance >= PreviousDistance);
+			PreviousDistance = Distance;
+			PreviousType = Item.Type;
+			++NumPopped;
+		}
+		CHECK(NumPopped == Queue.NumTotal());
+		CHECK(Queue.GetProgress() == 1.f);
+
+		Queue.Reset(Layout, true);
+		CHECK(Queue.NumTotal() == Layout.Cells.size() + Layout.CorridorTiles.size());
+	}
+
+	TEST(GenerateLayoutRecordsStats)
+	{
+		DungeonParams Params;
+		const DungeonLayout Layout = GenerateLayout(Params, 9);
+		const GenerationStats& Stats = Layout.Stats;
+
+		const double StageMs = Stats.SpawnMs + Stats.SeparationMs + Stats.SelectRoomsMs + Stats.TriangulationMs +
+			Stats.SpanningTreeMs + Stats.LoopEdgesMs + Stats.CorridorsMs;
+		CHECK(Stats.SeparationMs > 0.);
+		CHECK(Stats.bSeparationConverged);
+		CHECK(Stats.TotalMs >= StageMs);
+		CHECK(Stats.NumTriangles > 0);
+
+		int NumLoopEdges = 0;
+		for (const RoomEdge& Edge : Layout.Edges)
+		{
+			NumLoopEdges += Edge.bIsLoop ? 1 : 0;
+		}
+		CHECK(Stats.NumLoopEdges == NumLoopEdges);
+		CHECK(Stats.PeakBytes >= Layout.GetAllocatedBytes());
+	}
+
+	SectorParams MakeTestSectorParams()
+	{
+		SectorParams Params;
+		Params.Layout.NumberOfCells = 30;
+		Params.Layout.SpawnRadius = 1500.f;
+		Params.Layout.MaxSeparationSteps = 300;
+		Params.SectorSize = 10000.;
+		Params.WorldSeed = 17;
+		return Params;
+	}
+
+	TEST(SectorLayoutStaysInsideItsSector)
+	{
+		const SectorParams Params = MakeTestSectorParams();
+		for (const SectorCoord Coord : {SectorCoord{0, 0}, SectorCoord{-3, 2}})
+		{
+			const DungeonLayout Layout = GenerateSectorLayout(Params, Coord);
+			CHECK(!Layout.Rooms.empty());
+			CHECK(CountComponents(static_cast<int>(Layout.Rooms.size()), Layout.Edges) == 1);
+
+			const Vec2 Center = GetSectorCenter(Params.SectorSize, Coord);
+			for (const Room& Current : Layout.Rooms)
+			{
+				const Bounds2D& Bounds = Current.Bounds;
+				CHECK(std::abs(Bounds.Origin.X - Center.X) + Bounds.Extent.X <= Params.SectorSize / 2.);
+				CHECK(std::abs(Bounds.Origin.Y - Center.Y) + Bounds.Extent.Y <= Params.SectorSize / 2.);
+			}
+
+			/* Regenerating a sector on its own gives the same layout. */
+			CHECK(GenerateSectorLayout(Params, Coord).CorridorTiles == Layout.CorridorTiles);
+		}
+		CHECK(GetSectorSeed(Params.WorldSeed, {0, 1}) != GetSectorSeed(Params.WorldSeed, {1, 0}));
+	}
+
+	TEST(SectorStreamerFollowsFocus)
+	{
+		const SectorParams Params = MakeTestSectorParams();
+		SectorStreamer Streamer;
+		Streamer.Init(Params, 1);
+
+		const auto ProvideMissing = [&]
+		{
+			for (const SectorCoord& Coord : Streamer.GetMissingLayouts())
+			{
+				Streamer.ProvideLayout(Coord, GenerateSectorLayout(Params, Coord));
+			}
+		};
+
+		std::vector<SectorCoord> Released;
+		Streamer.Update({0., 0.}, Released);
+		CHECK(Released.empty());
+		CHECK(Streamer.NumActive() == 9);
+
+		/* 3x3 active block plus the column east and the row north of it. */
+		const std::vector<SectorCoord> Missing = Streamer.GetMissingLayouts();
+		CHECK(Missing.size() == 15);
+		CHECK(Missing.front() == (SectorCoord{0, 0}));
+		CHECK(Streamer.TakeReadySectors().empty());
+
+		ProvideMissing();
+		const std::vector<SectorCoord> Ready = Streamer.TakeReadySectors();
+		CHECK(Ready.size() == 9);
+		CHECK(Streamer.TakeReadySectors().empty());
+
+		/* The centre sector owns a stitch towards its east neighbour on top of its own corridors. */
+		const DungeonLayout* Centre = Streamer.GetReadyLayout({0, 0});
+		CHECK(Centre != nullptr);
+		const DungeonLayout Own = GenerateSectorLayout(Params, {0, 0});
+		CHECK(Centre->CorridorTiles.size() > Own.CorridorTiles.size());
+
+		/* Moving three sectors east swaps the whole active block, residency stays bounded. */
+		Streamer.Update({3. * Params.SectorSize, 0.}, Released);
+		CHECK(Released.size() == 9);
+		CHECK(Streamer.GetReadyLayout({0, 0}) == nullptr);
+		CHECK(Streamer.NumResident() == 15);
+
+		ProvideMissing();
+		CHECK(Streamer.TakeReadySectors().size() == 9);
+	}
+
+	bool IsSameLayout(const DungeonLayout& A, const DungeonLayout& B)
+	{
+		const auto SameCell = [](const Cell& CellA, const Cell& CellB)
+		{
+			return CellA.Location == CellB.Location && CellA.Scale == CellB.Scale &&
+				CellA.HalfExtent == CellB.HalfExtent && CellA.bIsRoom == CellB.bIsRoom && CellA.Floor == CellB.Floor;
+		};
+		const auto SameEdge = [](const RoomEdge& EdgeA, const RoomEdge& EdgeB)
+		{
+			return EdgeA.A == EdgeB.A && EdgeA.B == EdgeB.B && EdgeA.Weight == EdgeB.Weight &&
+				EdgeA.bIsLoop == EdgeB.bIsLoop;
+		};
+		return std::equal(A.Cells.begin(), A.Cells.end(), B.Cells.begin(), B.Cells.end(), SameCell) &&
+			A.Rooms == B.Rooms && A.CorridorTiles == B.CorridorTiles && A.Stairs == B.Stairs &&
+			A.SeparationSteps == B.SeparationSteps && A.NumFloors == B.NumFloors && A.FloorHeight == B.FloorHeight &&
+			std::equal(A.Edges.begin(), A.Edges.end(), B.Edges.begin(), B.Edges.end(), SameEdge);
+	}
+
+	TEST(SavedLayoutReadsBackUnchanged)
+	{
+		SavedLayout Saved;
+		Saved.Params.NumberOfCells = 60;
+		Saved.Params.MaxSeparationSteps = 300;
+		Saved.Params.SeparationTolerance = 2.f;
+		Saved.Seed = 99;
+		Saved.Layout = GenerateLayout(Saved.Params, Saved.Seed);
+		CHECK(!Saved.Layout.CorridorTiles.empty());
+
+		const std::vector<uint8_t> Bytes = WriteLayout(Saved);
+		SavedLayout Loaded;
+		CHECK(ReadLayout(Bytes.data(), Bytes.size(), Loaded) == LayoutReadResult::Ok);
+		CHECK(Loaded.Params == Saved.Params);
+		CHECK(Loaded.Seed == Saved.Seed);
+		CHECK(IsSameLayout(Loaded.Layout, Saved.Layout));
+
+		/* Straight corridor runs make tiles far cheaper than three doubles each. */
+		CHECK(Bytes.size() < Saved.Layout.Cells.size() * 28 + Saved.Layout.CorridorTiles.size() * 8 + 1024);
+
+		/* Cells the compact form cannot hold exactly switch the whole blob to full precision. */
+		Saved.Layout.Cells[0].Scale.X = 0.1;
+		Saved.Layout.Cells[1].HalfExtent.Y += 1.;
+		const std::vector<uint8_t> FullBytes = WriteLayout(Saved);
+		CHECK(FullBytes.size() > Bytes.size());
+		CHECK(ReadLayout(FullBytes.data(), FullBytes.size(), Loaded) == LayoutReadResult::Ok);
+		CHECK(IsSameLayout(Loaded.Layout, Saved.Layout));
+	}
+
+	TEST(DamagedLayoutIsRejected)
+	{
+		SavedLayout Saved;
+		Saved.Params.NumberOfCells = 30;
+		Saved.Params.MaxSeparationSteps = 200;
+		Saved.Layout = GenerateLayout(Saved.Params, 5);
+		const std::vector<uint8_t> Bytes = WriteLayout(Saved);
+
+		SavedLayout Loaded;
+		Loaded.Seed = 1234;
+		CHECK(ReadLayout(Bytes.data(), 10, Loaded) == LayoutReadResult::Truncated);
+		CHECK(ReadLayout(Bytes.data(), Bytes.size() - 1, Loaded) == LayoutReadResult::Truncated);
+
+		std::vector<uint8_t> Damaged = Bytes;
+		Damaged[0] = 'X';
+		CHECK(ReadLayout(Damaged.data(), Damaged.size(), Loaded) == LayoutReadResult::BadMagic);
+
+		Damaged = Bytes;
+		Damaged[4] = static_cast<uint8_t>(LayoutFormatVersion + 1);
+		CHECK(ReadLayout(Damaged.data(), Damaged.size(), Loaded) == LayoutReadResult::UnsupportedVersion);
+
+		Damaged = Bytes;
+		Damaged[Damaged.size() / 2] ^= 0x40;
+		CHECK(ReadLayout(Damaged.data(), Damaged.size(), Loaded) == LayoutReadResult::ChecksumMismatch);
+
+		/* Failed reads leave the output alone. */
+		CHECK(Loaded.Seed == 1234);
+		CHECK(Loaded.Layout.Cells.empty());
+	}
+
+	DungeonLayout MakeRoomLayout(const std::vector<Bounds2D>& RoomBounds)
+	{
+		DungeonLayout Layout;
+		for (const Bounds2D& Bounds : RoomBounds)
+		{
+			Cell RoomCell;
+			RoomCell.Location = Bounds.Origin;
+			RoomCell.HalfExtent = {Bounds.Extent.X, Bounds.Extent.Y, 50.};
+			RoomCell.bIsRoom = true;
+			Layout.Rooms.push_back({static_cast<int>(Layout.Cells.size()), Bounds, RoomType::Side});
+			Layout.Cells.push_back(RoomCell);
+		}
+		return Layout;
+	}
+
+	TEST(CorridorRouterGoesAroundRooms)
+	{
+		/* A wall-like room sits straight between the two rooms being joined. */
+		const DungeonLayout Layout = MakeRoomLayout({{{-1000., 0.}, {200., 200.}}, {{0., 0.}, {250., 900.}},
+		                                             {{1000., 0.}, {200., 200.}}});
+		OccupancyGrid Occupancy;
+		Occupancy.Init(Layout, 100.);
+		CorridorRouter Router;
+		Router.Reset(100.);
+
+		std::vector<Vec3> Tiles;
+		CHECK(Router.Route(Layout.Cells[0].GetBounds(), Layout.Cells[2].GetBounds(), -5., Occupancy, Tiles));
+		CHECK(!Tiles.empty());
+		for (const Vec3& Tile : Tiles)
+		{
+			CHECK(!IsOverlappingRoom(Layout, {Tile.X, Tile.Y}));
+		}
+
+		/* One unbroken chain of tiles, from next to the start room to next to the target room. */
+		for (size_t Index = 1; Index < Tiles.size(); ++Index)
+		{
+			CHECK(std::abs(Tiles[Index].X - Tiles[Index - 1].X) + std::abs(Tiles[Index].Y - Tiles[Index - 1].Y) == 100.);
+		}
+		const auto NextTo = [](const Cell& Room, const Vec3& Tile)
+		{
+			return std::abs(Tile.X - Room.Location.X) <= Room.HalfExtent.X + 100. &&
+				std::abs(Tile.Y - Room.Location.Y) <= Room.HalfExtent.Y + 100.;
+		};
+		CHECK(NextTo(Layout.Cells[0], Tiles.front()));
+		CHECK(NextTo(Layout.Cells[2], Tiles.back()));
+	}
+
+	TEST(CorridorRouterReusesCorridors)
+	{
+		const DungeonLayout Layout = MakeRoomLayout({{{-1500., 0.}, {200., 200.}}, {{1500., 0.}, {200., 200.}},
+		                                             {{0., 1200.}, {200., 200.}}});
+		OccupancyGrid Occupancy;
+		Occupancy.Init(Layout, 100.);
+		CorridorRouter Router;
+		Router.Reset(100.);
+
+		std::vector<Vec3> Tiles;
+		CHECK(Router.Route(Layout.Cells[0].GetBounds(), Layout.Cells[1].GetBounds(), -5., Occupancy, Tiles));
+		const size_t FirstCorridor = Tiles.size();
+		const size_t BytesAfterFirst = Router.GetAllocatedBytes();
+
+		/* The same connection again lays nothing new and needs no more node storage. */
+		CHECK(Router.Route(Layout.Cells[0].GetBounds(), Layout.Cells[1].GetBounds(), -5., Occupancy, Tiles));
+		CHECK(Tiles.size() == FirstCorridor);
+		CHECK(Router.GetAllocatedBytes() == BytesAfterFirst);
+
+		/* A branch to the third room joins the existing corridor instead of running all the way on its own. */
+		CHECK(Router.Route(Layout.Cells[2].GetBounds(), Layout.Cells[0].GetBounds(), -5., Occupancy, Tiles));
+		const size_t Branch = Tiles.size() - FirstCorridor;
+
+		OccupancyGrid Empty;
+		Empty.Init(Layout, 100.);
+		std::vector<Vec3> Alone;
+		CHECK(Router.Route(Layout.Cells[2].GetBounds(), Layout.Cells[0].GetBounds(), -5., Empty, Alone));
+		CHECK(Branch < Alone.size());
+	}
+
+	TEST(RoomTableMatchesCells)
+	{
+		DungeonParams Params;
+		Params.NumberOfCells = 80;
+		const DungeonLayout Layout = GenerateLayout(Params, 21);
+		CHECK(!Layout.Rooms.empty());
+
+		size_t NumRoomCells = 0;
+		for (const Cell& Current : Layout.Cells)
+		{
+			NumRoomCells += Current.bIsRoom ? 1 : 0;
+		}
+		CHECK(NumRoomCells == Layout.Rooms.size());
+
+		for (const Room& Current : Layout.Rooms)
+		{
+			const Cell& Source = Layout.Cells[Current.CellIndex];
+			CHECK(Source.bIsRoom);
+			CHECK(Current.GetCenter() == Source.Location);
+			CHECK(Current.GetHalfExtent() == Vec2(Source.HalfExtent.X, Source.HalfExtent.Y));
+			const bool bIsLarge = Source.Scale.X > Params.MinSize + 10 && Source.Scale.Y > Params.MinSize + 10;
+			CHECK((Current.Type == RoomType::Main) == bIsLarge);
+		}
+	}
+
+	TEST(MultiFloorLayoutLinksFloorsWithStairs)
+	{
+		SavedLayout Saved;
+		Saved.Params.NumberOfCells = 240;
+		Saved.Params.MaxSeparationSteps = 300;
+		Saved.Params.NumFloors = 3;
+		Saved.Params.FloorHeight = 500.f;
+		Saved.Seed = 8;
+		Saved.Layout = GenerateLayout(Saved.Params, Saved.Seed);
+		const DungeonLayout& Layout = Saved.Layout;
+		CHECK(Layout.NumFloors == 3);
+		CHECK(CountComponents(static_cast<int>(Layout.Rooms.size()), Layout.Edges) == 1);
+
+		std::vector<int> RoomsPerFloor(3, 0);
+		for (const Room& Current : Layout.Rooms)
+		{
+			++RoomsPerFloor[Current.Floor];
+		}
+		CHECK(RoomsPerFloor[0] > 0 && RoomsPerFloor[1] > 0 && RoomsPerFloor[2] > 0);
+
+		/* Every edge changing floor climbs exactly one and has its own stairwell. */
+		size_t NumCrossEdges = 0;
+		for (const RoomEdge& Edge : Layout.Edges)
+		{
+			const int Climb = std::abs(Layout.GetRoom(Edge.A).Floor - Layout.GetRoom(Edge.B).Floor);
+			CHECK(Climb <= 1);
+			NumCrossEdges += Climb;
+		}
+		CHECK(NumCrossEdges >= 2);
+		CHECK(Layout.Stairs.size() == NumCrossEdges);
+
+		const auto HasTile = [&Layout](const Vec3& Tile)
+		{
+			return std::find(Layout.CorridorTiles.begin(), Layout.CorridorTiles.end(), Tile) != Layout.CorridorTiles.end();
+		};
+		for (const Stairwell& Stair : Layout.Stairs)
+		{
+			CHECK(Stair.LowerFloor >= 0 && Stair.LowerFloor < 2);
+			for (const int Floor : {Stair.LowerFloor, Stair.LowerFloor + 1})
+			{
+				/* Either end of a stairwell opens into a room or onto a corridor. */
+				const bool bInsideRoom = std::any_of(Layout.Rooms.begin(), Layout.Rooms.end(), [&](const Room& Current)
+				{
+					return Current.Floor == Floor && Current.Bounds.Overlap(Stair.Location);
+				});
+				CHECK(bInsideRoom || HasTile({Stair.Location.X, Stair.Location.Y, GetCorridorZ(Layout, Floor)}));
+			}
+		}
+		for (const Vec3& Tile : Layout.CorridorTiles)
+		{
+			const double Floor = (Tile.Z - GetCorridorZ(Layout, 0)) / Layout.FloorHeight;
+			CHECK(Floor == std::floor(Floor) && Floor >= 0. && Floor < 3.);
+		}
+
+		const std::vector<uint8_t> Bytes = WriteLayout(Saved);
+		SavedLayout Loaded;
+		CHECK(ReadLayout(Bytes.data(), Bytes.size(), Loaded) == LayoutReadResult::Ok);
+		CHECK(Loaded.Params == Saved.Params);
+		CHECK(IsSameLayout(Loaded.Layout, Layout));
+	}
+
+	TEST(BatchMatchesLayoutsGeneratedOneByOne)
+	{
+		std::vector<BatchEntry> Entries(6);
+		for (size_t EntryIndex = 0; EntryIndex < Entries.size(); ++EntryIndex)
+		{
+			Entries[EntryIndex].Params.NumberOfCells = EntryIndex % 2 ? 120 : 240;
+			Entries[EntryIndex].Params.NumFloors = EntryIndex == 5 ? 2 : 1;
+			Entries[EntryIndex].Params.MaxSeparationSteps = 200;
+			Entries[EntryIndex].Seed = static_cast<uint32_t>(EntryIndex + 1);
+		}
+
+		std::vector<int> Calls(Entries.size(), 0);
+		std::vector<DungeonLayout> Layouts(Entries.size());
+		const std::vector<BatchSummary> Summaries = GenerateBatch(Entries, [&](size_t EntryIndex, const DungeonLayout& Layout)
+		{
+			++Calls[EntryIndex];
+			Layouts[EntryIndex] = Layout;
+		});
+
+		CHECK(Summaries.size() == Entries.size());
+		for (size_t EntryIndex = 0; EntryIndex < Entries.size(); ++EntryIndex)
+		{
+			const DungeonLayout Expected = GenerateLayout(Entries[EntryIndex].Params, Entries[EntryIndex].Seed);
+			CHECK(Calls[EntryIndex] == 1);
+			CHECK(IsSameLayout(Layouts[EntryIndex], Expected));
+			CHECK(Summaries[EntryIndex].NumRooms == static_cast<int>(Expected.Rooms.size()));
+			CHECK(Summaries[EntryIndex].NumCorridorTiles == static_cast<int>(Expected.CorridorTiles.size()));
+			CHECK(Summaries[EntryIndex].NumStairs == static_cast<int>(Expected.Stairs.size()));
+		}
+		CHECK(Summaries[5].NumStairs > 0);
+
+		/* Loops nested in a serial scope never reach the executor. */
+		static std::atomic<int> ExecutorCalls{0};
+		SetParallelExecutor([](int32_t NumChunks, const std::function<void(int32_t)>& Chunk)
+		{
+			++ExecutorCalls;
+			ThreadParallelExecutor(NumChunks, Chunk);
+		});
+		int Sum = 0;
+		{
+			const ScopedSerialParallelFor Serial;
+			ParallelForRange(100, 10, [&Sum](int32_t Begin, int32_t End) { Sum += End - Begin; });
+		}
+		const int SerialCalls = ExecutorCalls;
+		ParallelForRange(100, 10, [](int32_t, int32_t) {});
+		SetParallelExecutor(&ThreadParallelExecutor);
+		CHECK(Sum == 100);
+		CHECK(SerialCalls == 0);
+		CHECK(ExecutorCalls == 1);
+	}
+
+	TEST(LayoutEditorKeepsLayoutConnected)
+	{
+		for (const int NumFloors : {1, 2})
+		{
+			DungeonParams Params;
+			Params.NumberOfCells = 200;
+			Params.MaxSeparationSteps = 300;
+			Params.NumFloors = NumFloors;
+			DungeonLayout Layout = GenerateLayout(Params, 5);
+			const std::vector<Vec3> Generated = Layout.CorridorTiles;
+
+			LayoutEditor Editor;
+			Editor.Init(Params, 5, Layout);
+			CHECK(Layout.CorridorTiles == Generated);
+
+			/* What the changes reported so far say the layout holds. */
+			std::vector<Vec3> Tiles = Layout.CorridorTiles;
+			std::vector<Stairwell> Stairs = Layout.Stairs;
+			const auto Apply = [&](const LayoutChanges& Changes)
+			{
+				for (const Vec3& Tile : Changes.RemovedTiles)
+				{
+					const auto Found = std::find(Tiles.begin(), Tiles.end(), Tile);
+					CHECK(Found != Tiles.end());
+					if (Found != Tiles.end())
+					{
+						Tiles.erase(Found);
+					}
+				}
+				Tiles.insert(Tiles.end(), Changes.AddedTiles.begin(), Changes.AddedTiles.end());
+				for (const Stairwell& Stair : Changes.RemovedStairs)
+				{
+					const auto Found = std::find(Stairs.begin(), Stairs.end(), Stair);
+					CHECK(Found != Stairs.end());
+					if (Found != Stairs.end())
+					{
+						Stairs.erase(Found);
+					}
+				}
+				Stairs.insert(Stairs.end(), Changes.AddedStairs.begin(), Changes.AddedStairs.end());
+			};
+			const auto CheckLayout = [&]()
+			{
+				std::vector<RoomEdge> TreeEdges;
+				int NumLoops = 0;
+				size_t NumCrossEdges = 0;
+				for (const RoomEdge& Edge : Layout.Edges)
+				{
+					if (Edge.bIsLoop)
+					{
+						++NumLoops;
+					}
+					else
+					{
+						TreeEdges.push_back(Edge);
+					}
+					NumCrossEdges += Layout.GetRoom(Edge.A).Floor != Layout.GetRoom(Edge.B).Floor;
+				}
+				CHECK(TreeEdges.size() + 1 == Layout.Rooms.size());
+				CHECK(CountComponents(static_cast<int>(Layout.Rooms.size()), TreeEdges) == 1);
+				CHECK(NumLoops == Layout.Stats.NumLoopEdges);
+				CHECK(Layout.Stairs.size() == NumCrossEdges);
+
+				const auto Less = [](const Vec3& A, const Vec3& B)
+				{
+					return std::tie(A.X, A.Y, A.Z) < std::tie(B.X, B.Y, B.Z);
+				};
+				std::vector<Vec3> Expected = Layout.CorridorTiles;
+				std::sort(Expected.begin(), Expected.end(), Less);
+				std::sort(Tiles.begin(), Tiles.end(), Less);
+				CHECK(Tiles == Expected);
+				CHECK(std::adjacent_find(Expected.begin(), Expected.end()) == Expected.end());
+				CHECK(Stairs.size() == Layout.Stairs.size());
+				for (const Stairwell& Stair : Layout.Stairs)
+				{
+					CHECK(std::find(Stairs.begin(), Stairs.end(), Stair) != Stairs.end());
+				}
+				for (size_t RoomIndex = 0; RoomIndex < Layout.Rooms.size(); ++RoomIndex)
+				{
+					CHECK(Layout.Cells[Layout.Rooms[RoomIndex].CellIndex].bIsRoom);
+				}
+
+				/* Corridors stay out of rooms, edited or not. */
+				for (const Vec3& Tile : Layout.CorridorTiles)
+				{
+					const long TileFloor = std::lround((Tile.Z - GetCorridorZ(Layout, 0)) / Layout.FloorHeight);
+					for (const Room& Current : Layout.Rooms)
+					{
+						CHECK(Current.Floor != TileFloor || !Current.Bounds.Overlap({Tile.X, Tile.Y}));
+					}
+				}
+			};
+
+			LayoutChanges Changes;
+			const size_t NumRooms = Layout.Rooms.size();
+			/* Past every other room, so its corridor cannot be all reused tiles. */
+			Vec2 Far = Layout.GetRoom(0).GetCenter();
+			for (const Room& Current : Layout.Rooms)
+			{
+				Far.X = std::max(Far.X, Current.Bounds.Origin.X + Current.Bounds.Extent.X + 1000.);
+			}
+			const int Added = Editor.AddRoom(Far, {150., 150.}, NumFloors - 1, Changes);
+			CHECK(Added == static_cast<int>(NumRooms));
+			CHECK(Changes.AddedRooms.size() == 1 && Changes.RemovedTiles.empty() && !Changes.AddedTiles.empty());
+			Apply(Changes);
+			CheckLayout();
+
+			/* Moving a room only re-routes its own corridors, most of the layout stays as it was. */
+			CHECK(Editor.MoveRoom(1, Layout.GetRoom(1).GetCenter() + Vec2{220., -140.}, Changes));
+			CHECK(Changes.RemovedRooms.size() == 1 && Changes.AddedRooms.size() == 1);
+			CHECK(Changes.RemovedTiles.size() < Layout.CorridorTiles.size() / 2);
+			Apply(Changes);
+			CheckLayout();
+
+			for (const int RoomIndex : {Added, 3, 0, 7})
+			{
+				CHECK(Editor.RemoveRoom(RoomIndex, Changes));
+				CHECK(Changes.RemovedRooms.size() == 1 && Changes.AddedRooms.empty());
+				Apply(Changes);
+				CheckLayout();
+			}
+			CHECK(Layout.Rooms.size() == NumRooms - 3);
+			CHECK(!Editor.RemoveRoom(static_cast<int>(Layout.Rooms.size()), Changes));
+			CHECK(Editor.AddRoom(Far, {150., 150.}, NumFloors, Changes) == -1);
+
+			/* The corridor out to the removed far room went with it. */
+			for (const Vec3& Tile : Layout.CorridorTiles)
+			{
+				CHECK(Tile.X < Far.X - 600.);
+			}
+
+			/* Rooms may not overlap, one put down on a corridor has it routed around itself. */
+			CHECK(Editor.AddRoom(Layout.GetRoom(0).GetCenter(), {150., 150.}, Layout.GetRoom(0).Floor, Changes) == -1);
+			CHECK(!Editor.MoveRoom(0, Layout.GetRoom(1).GetCenter(), Changes));
+			bool bPlacedOnCorridor = false;
+			for (size_t TileIndex = 0; TileIndex < Layout.CorridorTiles.size() && !bPlacedOnCorridor; TileIndex += 7)
+			{
+				const Vec3 Tile = Layout.CorridorTiles[TileIndex];
+				const int Floor = static_cast<int>(std::lround((Tile.Z - GetCorridorZ(Layout, 0)) / Layout.FloorHeight));
+				bPlacedOnCorridor = Editor.AddRoom({Tile.X, Tile.Y}, {300., 300.}, Floor, Changes) != -1;
+			}
+			CHECK(bPlacedOnCorridor && !Changes.RemovedTiles.empty());
+			Apply(Changes);
+			CheckLayout();
+
+			/* Same for a room moved onto a corridor of its floor. */
+			bool bMovedOnCorridor = false;
+			for (size_t TileIndex = 0; TileIndex < Layout.CorridorTiles.size() && !bMovedOnCorridor; TileIndex += 7)
+			{
+				const Vec3 Tile = Layout.CorridorTiles[TileIndex];
+				const int Floor = static_cast<int>(std::lround((Tile.Z - GetCorridorZ(Layout, 0)) / Layout.FloorHeight));
+				bMovedOnCorridor = Floor == Layout.GetRoom(2).Floor && Editor.MoveRoom(2, {Tile.X, Tile.Y}, Changes);
+			}
+			CHECK(bMovedOnCorridor);
+			Apply(Changes);
+			CheckLayout();
+		}
+	}
+
+	TEST(CorridorStripsCoverEveryTileOnce)
+	{
+		const auto CoversExactly = [](const std::vector<CorridorStrip>& Strips, const std::vector<Vec3>& Tiles, double SectionLength)
+		{
+			int32_t NumCovered = 0;
+			for (const CorridorStrip& Strip : Strips)
+			{
+				NumCovered += Strip.NumTiles;
+			}
+			return NumCovered == static_cast<int32_t>(Tiles.size()) &&
+				std::all_of(Tiles.begin(), Tiles.end(), [&](const Vec3& Tile)
+				{
+					return std::count_if(Strips.begin(), Strips.end(), [&](const CorridorStrip& Strip)
+					{
+						return Strip.FindTile(Tile, SectionLength) != -1;
+					}) == 1;
+				});
+		};
+
+		/* An L, the corner goes to the longer leg. */
+		std::vector<Vec3> Corner;
+		for (int Step = 0; Step < 5; ++Step)
+		{
+			Corner.push_back({50. + Step * 100., 50., -10.});
+		}
+		for (int Step = 1; Step < 4; ++Step)
+		{
+			Corner.push_back({450., 50. + Step * 100., -10.});
+		}
+		Corner.push_back({2050., 50., -10.});
+		std::vector<CorridorStrip> Strips = MergeCorridorTiles(Corner, 100.);
+		CHECK(Strips.size() == 3);
+		CHECK(CoversExactly(Strips, Corner, 100.));
+		CHECK(Strips[0].NumTiles == 5 && !Strips[0].bAlongY);
+		CHECK(Strips[1].NumTiles == 3 && Strips[1].bAlongY);
+		CHECK(Strips[2].NumTiles == 1);
+		CHECK(Strips[0].GetCenter(100.) == Vec3(250., 50., -10.));
+
+		DungeonParams Params;
+		Params.NumberOfCells = 200;
+		DungeonLayout Layout = GenerateLayout(Params, 9);
+		Strips = MergeCorridorTiles(Layout.CorridorTiles, Params.SectionLength);
+		CHECK(CoversExactly(Strips, Layout.CorridorTiles, Params.SectionLength));
+		CHECK(Strips.size() * 2 < Layout.CorridorTiles.size());
+
+		MaterializationQueue Queue;
+		Queue.Reset(Layout, false, &Strips, Params.SectionLength);
+		CHECK(Queue.NumTotal() == Layout.Rooms.size() + Strips.size() + Layout.Stairs.size());
+
+		/* An edit only replaces the strips it cut into. */
+		LayoutEditor Editor;
+		Editor.Init(Params, 9, Layout);
+		LayoutChanges Changes;
+		std::vector<CorridorStrip> RemovedStrips;
+		std::vector<CorridorStrip> AddedStrips;
+		for (const int RoomIndex : {2, 5, 0})
+		{
+			const size_t NumStrips = Strips.size();
+			CHECK(Editor.RemoveRoom(RoomIndex, Changes));
+			UpdateCorridorStrips(Strips, Changes.RemovedTiles, Changes.AddedTiles, Params.SectionLength, RemovedStrips,
+			                     AddedStrips);
+			CHECK(CoversExactly(Strips, Layout.CorridorTiles, Params.SectionLength));
+			CHECK(Strips.size() == NumStrips - RemovedStrips.size() + AddedStrips.size());
+			CHECK(RemovedStrips.empty() == Changes.RemovedTiles.empty());
+		}
+	}
+
+	TEST(PenetrationSeparationResolvesOverlaps)
+	{
+		DungeonParams Params;
+		Params.NumberOfCells = 600;
+		Params.SpawnRadius = 4000.f;
+		Params.NumFloors = 2;
+
+		RandomEngine Rng{31};
+		DungeonLayout Spawned;
+		SpawnCells(Params, Rng, Spawned);
+
+		DungeonLayout Layout = Spawned;
+		SeparateCells(Params, Layout);
+		CHECK(Layout.Stats.bSeparationConverged);
+		CHECK(Layout.SeparationSteps > 0);
+		CHECK(Layout.SeparationSteps < Params.MaxSeparationSteps);
+
+		for (size_t i = 0; i < Layout.Cells.size(); ++i)
+		{
+			for (size_t j = i + 1; j < Layout.Cells.size(); ++j)
+			{
+				const Cell& A = Layout.Cells[i];
+				const Cell& B = Layout.Cells[j];
+				const double OverlapX = A.HalfExtent.X + B.HalfExtent.X - std::abs(A.Location.X - B.Location.X);
+				const double OverlapY = A.HalfExtent.Y + B.HalfExtent.Y - std::abs(A.Location.Y - B.Location.Y);
+				CHECK(A.Floor != B.Floor || std::min(OverlapX, OverlapY) <= Params.SeparationTolerance);
+			}
+		}
+
+		/* Steering the same cells takes several times the steps. */
+		DungeonParams SteeringParams = Params;
+		SteeringParams.Separation = SeparationMethod::Steering;
+		DungeonLayout Steered = Spawned;
+		SeparateCells(SteeringParams, Steered);
+		CHECK(Steered.SeparationSteps > 2 * Layout.SeparationSteps);
+
+		/* Time slices, thread count and iteration cap only decide where the solver stops, not where cells go. */
+		SeparationSettings Settings;
+		Settings.Tolerance = Params.SeparationTolerance;
+		Settings.MaxIterations = Params.MaxSeparationSteps;
+		const auto Solve = [&](ParallelExecutor Executor, double BudgetMs)
+		{
+			SetParallelExecutor(Executor);
+			SeparationSolver Solver;
+			Solver.Init(Spawned.Cells, Settings);
+			int NumSlices = 0;
+			while (!Solver.IsDone())
+			{
+				Solver.Solve(BudgetMs);
+				++NumSlices;
+			}
+			CHECK(NumSlices >= 1);
+			CHECK(Solver.GetResult().Iterations == Layout.SeparationSteps);
+			CHECK(Solver.GetResult().MaxPenetration <= Settings.Tolerance);
+			return Solver.GetPositions();
+		};
+		const std::vector<Vec2> Whole = Solve(&ThreadParallelExecutor, 0.);
+		CHECK(Solve(nullptr, 1e-6) == Whole);
+		SetParallelExecutor(&ThreadParallelExecutor);
+		CHECK(Solve(&ThreadParallelExecutor, 1e-6) == Whole);
+		for (size_t CellIndex = 0; CellIndex < Whole.size(); ++CellIndex)
+		{
+			CHECK(Layout.Cells[CellIndex].Location == Whole[CellIndex]);
+		}
+
+		SeparationSolver Capped;
+		Settings.MaxIterations = 3;
+		Capped.Init(Spawned.Cells, Settings);
+		const SeparationResult& Result = Capped.Solve();
+		CHECK(Capped.IsDone());
+		CHECK(!Result.bConverged);
+		CHECK(Result.Iterations == 3);
+		CHECK(Result.MaxPenetration > Settings.Tolerance);
+	}
+
+	TEST(RoomNavigatorFindsShortestRoomPaths)
+	{
+		DungeonParams Params;
+		Params.NumberOfCells = 240;
+		Params.NumFloors = 3;
+		Params.FloorHeight = 500.f;
+		const DungeonLayout Layout = GenerateLayout(Params, 21);
+		const int NumRooms = static_cast<int>(Layout.Rooms.size());
+		CHECK(NumRooms > 10);
+
+		/* Reference distances and the stairwell of each edge, a fresh layout adds them in edge order. */
+		std::vector<std::vector<double>> Expected(NumRooms, std::vector<double>(NumRooms, 1e300));
+		std::vector<std::vector<Vec2>> EdgeStair(NumRooms, std::vector<Vec2>(NumRooms));
+		size_t NumStairs = 0;
+		for (int RoomIndex = 0; RoomIndex < NumRooms; ++RoomIndex)
+		{
+			Expected[RoomIndex][RoomIndex] = 0.;
+		}
+		for (const RoomEdge& Edge : Layout.Edges)
+		{
+			Expected[Edge.A][Edge.B] = Expected[Edge.B][Edge.A] = std::min(Expected[Edge.A][Edge.B], Edge.Weight);
+			if (Layout.GetRoom(Edge.A).Floor != Layout.GetRoom(Edge.B).Floor)
+			{
+				EdgeStair[Edge.A][Edge.B] = EdgeStair[Edge.B][Edge.A] = Layout.Stairs[NumStairs++].Location;
+			}
+		}
+		for (int Via = 0; Via < NumRooms; ++Via)
+		{
+			for (int From = 0; From < NumRooms; ++From)
+			{
+				for (int To = 0; To < NumRooms; ++To)
+				{
+					Expected[From][To] = std::min(Expected[From][To], Expected[From][Via] + Expected[Via][To]);
+				}
+			}
+		}
+
+		RoomNavigator Navigator;
+		Navigator.Init(Layout, 4);
+		std::vector<int32_t> Path;
+		for (int From = 0; From < NumRooms; From += 3)
+		{
+			for (int To = 0; To < NumRooms; To += 5)
+			{
+				CHECK(std::abs(Navigator.GetDistance(From, To) - Expected[From][To]) < 1e-6);
+				CHECK(Navigator.FindRoomPath(From, To, Path));
+				CHECK(Path.front() == From && Path.back() == To);
+
+				/* Every hop is an edge and together they are exactly as long as the shortest walk. */
+				double Length = 0.;
+				for (size_t Hop = 1; Hop < Path.size(); ++Hop)
+				{
+					const auto Found = std::find_if(Layout.Edges.begin(), Layout.Edges.end(), [&](const RoomEdge& Edge)
+					{
+						return (Edge.A == Path[Hop - 1] && Edge.B == Path[Hop]) || (Edge.B == Path[Hop - 1] && Edge.A == Path[Hop]);
+					});
+					CHECK(Found != Layout.Edges.end());
+					Length += Found != Layout.Edges.end() ? Found->Weight : 0.;
+				}
+				CHECK(std::abs(Length - Expected[From][To]) < 1e-6);
+			}
+		}
+		CHECK(Navigator.GetNumCachedTargets() == 4);
+		CHECK(Navigator.GetDistance(0, NumRooms) < 0.);
+
+		for (int RoomIndex = 0; RoomIndex < NumRooms; ++RoomIndex)
+		{
+			const Room& Current = Layout.GetRoom(RoomIndex);
+			CHECK(Navigator.FindRoom(Current.GetCenter(), Current.Floor) == RoomIndex);
+		}
+
+		/* Room centres in between, both ends of the stairwell on a change of floor, the goal itself last. */
+		const Room& StartRoom = Layout.GetRoom(0);
+		int GoalIndex = 1;
+		while (Layout.GetRoom(GoalIndex).Floor == StartRoom.Floor)
+		{
+			++GoalIndex;
+		}
+		const Room& GoalRoom = Layout.GetRoom(GoalIndex);
+		const Vec3 Start{StartRoom.GetCenter().X, StartRoom.GetCenter().Y, Layout.GetFloorZ(StartRoom.Floor) + 90.};
+		const Vec3 End{GoalRoom.GetCenter().X + 1., GoalRoom.GetCenter().Y, Layout.GetFloorZ(GoalRoom.Floor) + 90.};
+		std::vector<Vec3> Waypoints;
+		CHECK(Navigator.FindWaypoints(Start, End, Waypoints));
+		CHECK(Navigator.FindRoomPath(0, GoalIndex, Path));
+		CHECK(!Waypoints.empty() && Waypoints.back() == End);
+		size_t Next = 0;
+		for (size_t Hop = 1; Hop < Path.size() && Next < Waypoints.size(); ++Hop)
+		{
+			const Room& Previous = Layout.GetRoom(Path[Hop - 1]);
+			const Room& Current = Layout.GetRoom(Path[Hop]);
+			if (Previous.Floor != Current.Floor)
+			{
+				const Vec2& Stair = EdgeStair[Path[Hop - 1]][Path[Hop]];
+				CHECK(Waypoints[Next++] == Vec3(Stair.X, Stair.Y, Layout.GetFloorZ(Previous.Floor)));
+				CHECK(Waypoints[Next++] == Vec3(Stair.X, Stair.Y, Layout.GetFloorZ(Current.Floor)));
+			}
+			if (Hop + 1 < Path.size())
+			{
+				CHECK(Waypoints[Next++] == Vec3(Current.GetCenter().X, Current.GetCenter().Y, Layout.GetFloorZ(Current.Floor)));
+			}
+		}
+		CHECK(Next + 1 == Waypoints.size());
+
+		/* Rooms the edges do not reach have no path. */
+		DungeonLayout Split = Layout;
+		Split.Edges.clear();
+		Navigator.Init(Split);
+		CHECK(Navigator.GetDistance(0, 1) < 0.);
+		CHECK(!Navigator.FindRoomPath(0, 1, Path) && Path.empty());
+		CHECK(!Navigator.FindWaypoints(Start, End, Waypoints) && Waypoints.empty());
+		CHECK(Navigator.FindRoomPath(1, 1, Path) && Path.size() == 1);
+	}
+
+	TEST(InvertedSizeRangeUsesMinSize)
+	{
+		RandomEngine Rng{5};
+		CHECK(RandRange(Rng, 7, 7) == 7);
+		CHECK(RandRange(Rng, 9, 8) == 9);
+		CHECK(RandRange(Rng, 9, -100) == 9);
+
+		DungeonParams Params;
+		Params.NumberOfCells = 40;
+		Params.MinSize = 9;
+		Params.MaxSize = 8;
+		const DungeonLayout Layout = GenerateLayout(Params, 3);
+		CHECK(Layout.Cells.size() == 40);
+		for (const Cell& Current : Layout.Cells)
+		{
+			CHECK(Current.Scale.X == 18. && Current.Scale.Y == 18.);
+		}
+	}
+
+	TEST(ThreadExecutorRunsNestedAndConcurrentLoops)
+	{
+		/* Loops inside chunks and from several threads at once share the pool, every chunk runs once. */
+		SetParallelExecutor(&ThreadParallelExecutor);
+		std::vector<std::atomic<int>> Counts(4 * 64 * 16);
+		const auto Nested = [&Counts](int32_t Outer)
+		{
+			ParallelForRange(64, 1, [&Counts, Outer](int32_t Begin, int32_t End)
+			{
+				for (int32_t Middle = Begin; Middle < End; ++Middle)
+				{
+					ParallelForRange(16, 2, [&Counts, Outer, Middle](int32_t InnerBegin, int32_t InnerEnd)
+					{
+						for (int32_t Inner = InnerBegin; Inner < InnerEnd; ++Inner)
+						{
+							++Counts[(Outer * 64 + Middle) * 16 + Inner];
+						}
+					});
+				}
+			});
+		};
+		std::vector<std::thread> Callers;
+		for (int32_t Outer = 1; Outer < 4; ++Outer)
+		{
+			Callers.emplace_back(Nested, Outer);
+		}
+		Nested(0);
+		for (std::thread& Caller : Callers)
+		{
+			Caller.join();
+		}
+		CHECK(std::all_of(Counts.begin(), Counts.end(), [](const std::atomic<int>& Count) { return Count == 1; }));
+	}
+
+	TEST(GenerateLayoutConnectsAllRooms)
+	{
+		DungeonParams Params;
+		const DungeonLayout Layout = GenerateLayout(Params, 42);
+
+		CHECK(Layout.Cells.size() == static_cast<size_t>(Params.NumberOfCells));
+		CHECK(Layout.Rooms.size() >= 3);
+		CHECK(CountComponents(static_cast<int>(Layout.Rooms.size()), Layout.Edges) == 1);
+		CHECK(!Layout.CorridorTiles.empty());
+
+		for (const Vec3& Tile : Layout.CorridorTiles)
+		{
+			CHECK(!IsOverlappingRoom(Layout, {Tile.X, Tile.Y}));
+		}
+	}
+}
+
+int main()
+{
+	for (const TestCase& Test : GetTests())
+	{
+		const int FailuresBefore = Failures;
+		Test.Body();
+		std::printf("[%s] %s\n", Failures == FailuresBefore ? "PASS" : "FAIL", Test.Name);
+	}
+	return Failures == 0 ? 0 : 1;
+}
@@ -9,6 +9,8 @@
 #include "Engine/World.h"
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
+#include "DungeonGenerator.h"
+#include "EngineUtils.h"
 
 ADungeonDelverPlayerController::ADungeonDelverPlayerController()
 {
@@ -16,6 +18,8 @@ ADungeonDelverPlayerController::ADungeonDelverPlayerController()
 	DefaultMouseCursor = EMouseCursor::Default;
 	CachedDestination = FVector::ZeroVector;
 	FollowTime = 0.f;
+	WaypointAcceptRadius = 150.f;
+	NextWaypoint = 0;
 }
 
 void ADungeonDelverPlayerController::BeginPlay()
@@ -52,8 +56,23 @@ void ADungeonDelverPlayerController::SetupInputComponent()
 	}
 }
 
+void ADungeonDelverPlayerController::PlayerTick(float DeltaTime)
+{
+	Super::PlayerTick(DeltaTime);
+
+	// Hand the next leg of the dungeon path to the nav mesh once the current waypoint is reached
+	APawn* ControlledPawn = GetPawn();
+	if (ControlledPawn != nullptr && NextWaypoint + 1 < DungeonPath.Num() &&
+		FVector::Dist(ControlledPawn->GetActorLocation(), DungeonPath[NextWaypoint]) <= WaypointAcceptRadius)
+	{
+		++NextWaypoint;
+		UAIBlueprintHelperLibrary::SimpleMoveToLocation(this, DungeonPath[NextWaypoint]);
+	}
+}
+
 void ADungeonDelverPlayerController::OnInputStarted()
 {
+	ClearDungeonPath();
 	StopMovement();
 }
 
@@ -96,7 +115,7 @@ void ADungeonDelverPlayerController::OnSetDestinationReleased()
 	if (FollowTime <= ShortPressThreshold)
 	{
 		// We move there and spawn some particles
-		UAIBlueprintHelperLibrary::SimpleMoveToLocation(this, CachedDestination);
+		MoveToDestination(CachedDestination);
 		UNiagaraFunctionLibrary::SpawnSystemAtLocation(this, FXCursor, CachedDestination, FRotator::ZeroRotator, FVector(1.f, 1.f, 1.f), true, true, ENCPoolMethod::None, true);
 	}
 
@@ -115,3 +134,31 @@ void ADungeonDelverPlayerController::OnTouchReleased()
 	bIsTouch = false;
 	OnSetDestinationReleased();
 }
+
+void ADungeonDelverPlayerController::MoveToDestination(const FVector& Destination)
+{
+	ClearDungeonPath();
+
+	if (!DungeonGenerator.IsValid())
+	{
+		TActorIterator<ADungeonGenerator> It(GetWorld());
+		DungeonGenerator = It ? *It : nullptr;
+	}
+
+	// Long trips go room to room, so the nav mesh only has to cover the way to the next waypoint
+	APawn* ControlledPawn = GetPawn();
+	if (ControlledPawn != nullptr && DungeonGenerator.IsValid() &&
+		DungeonGenerator->FindDungeonPath(ControlledPawn->GetActorLocation(), Destination, DungeonPath))
+	{
+		UAIBlueprintHelperLibrary::SimpleMoveToLocation(this, DungeonPath[0]);
+		return;
+	}
+
+	UAIBlueprintHelperLibrary::SimpleMoveToLocation(this, Destination);
+}
+
+void ADungeonDelverPlayerController::ClearDungeonPath()
+{
+	DungeonPath.Reset();
+	NextWaypoint = 0;
+}
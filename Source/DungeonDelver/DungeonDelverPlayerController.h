@@ -10,6 +10,7 @@
 
 /** Forward declaration to improve compiling times */
 class UNiagaraSystem;
+class ADungeonGenerator;
 
 UCLASS()
 class ADungeonDelverPlayerController : public APlayerController
@@ -39,11 +40,17 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Input, meta=(AllowPrivateAccess = "true"))
 	class UInputAction* SetDestinationTouchAction;
 
+	/** Distance at which a dungeon path waypoint counts as reached and the pawn moves on to the next one */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Input)
+	float WaypointAcceptRadius;
+
 protected:
 	/** True if the controlled character should navigate to the mouse cursor. */
 	uint32 bMoveToMouseCursor : 1;
 
 	virtual void SetupInputComponent() override;
+
+	virtual void PlayerTick(float DeltaTime) override;
 	
 	// To add mapping context
 	virtual void BeginPlay();
@@ -55,11 +62,21 @@ protected:
 	void OnTouchTriggered();
 	void OnTouchReleased();
 
+	/** Moves to Destination through the dungeon's room graph, straight there when there is no dungeon path. */
+	void MoveToDestination(const FVector& Destination);
+	void ClearDungeonPath();
+
 private:
 	FVector CachedDestination;
 
 	bool bIsTouch; // Is it a touch device
 	float FollowTime; // For how long it has been pressed
+
+	/** Room to room waypoints of the current click move, only the leg to the next one uses the nav mesh */
+	TArray<FVector> DungeonPath;
+	int32 NextWaypoint;
+
+	TWeakObjectPtr<ADungeonGenerator> DungeonGenerator;
 };
 
 